@@ -0,0 +1,535 @@
+/*
+* 서버 핫 패스 마이크로벤치마크
+*
+* 서버의 번역 단위(protocol.c, job_queue.c, state.c, sbuf.c, packet_pool.c ...)를 그대로 링크해
+* 네트워크 없이 각 구성 요소만 따로 돌려보고, 연산 하나당 시간(ns/op)과 할당 횟수(allocs/op)를 출력함
+* net.c의 송신 경로는 아래 stub으로 바꿔 끼워 브로드캐스트는 프레임 생성과 작업 전달 비용만 잼
+* 할당 횟수는 malloc 계열 함수를 가로채 스레드별로 셈
+*
+* 빌드 (저장소 루트에서)
+*   gcc -O2 -pthread -Iserver bench/microbench.c server/protocol.c server/job_queue.c server/state.c \
+*       server/sbuf.c server/packet_pool.c server/send_queue.c server/log.c server/metrics.c server/member_set.c server/ebr.c \
+*       server/slot_map.c server/conn_table.c server/io_buf.c -o microbench
+* 실행 : ./microbench [이름 필터]
+*/
+#define _GNU_SOURCE
+
+#include "common.h"
+#include "protocol.h"
+#include "packet_pool.h"
+#include "job_queue.h"
+#include "state.h"
+#include "member_set.h"
+#include "sbuf.h"
+#include "net.h"
+#include "log.h"
+
+#include <sched.h>
+
+/* ================= 서버 링크용 stub ================= */
+
+volatile sig_atomic_t g_terminate = 0;
+job_queue_t g_logic_q[WORKER_THREAD_NUM];
+
+/* 브로드캐스트가 만든 send 작업 수 (multicast는 목록을 순회하지 않고 멤버 수에서 보낸 사람 하나를 뺀 값으로 셈) */
+static __thread uint64_t t_sends;
+
+void net_push_send(job_t* job) {
+	t_sends++;
+	sbuf_release(job->buf);
+}
+
+void net_push_multicast(sbuf_t* frame, member_set_t* members, conn_handle_t exclude) {
+	(void)frame;
+	(void)exclude;
+	t_sends += (uint64_t)(members->count - 1);
+}
+
+void net_wakeup(void) {
+}
+
+void net_io_queue_stats(int reactor, size_t* depth, size_t* hwm) {
+	(void)reactor;
+	*depth = *hwm = 0;
+}
+
+/* ================= 할당 횟수 집계 ================= */
+
+extern void* __libc_malloc(size_t);
+extern void* __libc_calloc(size_t, size_t);
+extern void* __libc_realloc(void*, size_t);
+extern void* __libc_memalign(size_t, size_t);
+extern void __libc_free(void*);
+
+static __thread uint64_t t_allocs;
+
+void* malloc(size_t n) {
+	t_allocs++;
+	return __libc_malloc(n);
+}
+
+void* calloc(size_t n, size_t size) {
+	t_allocs++;
+	return __libc_calloc(n, size);
+}
+
+void* realloc(void* p, size_t n) {
+	t_allocs++;
+	return __libc_realloc(p, n);
+}
+
+void* aligned_alloc(size_t align, size_t n) {
+	t_allocs++;
+	return __libc_memalign(align, n);
+}
+
+void free(void* p) {
+	__libc_free(p);
+}
+
+/* ================= 측정 도구 ================= */
+
+static const char* g_filter;
+
+/* 여러 스레드가 함께 돌리는 벤치마크의 출발 신호와 할당 합계 */
+static atomic_bool g_go;
+static atomic_ullong g_thread_allocs;
+
+static bool bench_enabled(const char* name) {
+	return !g_filter || strstr(name, g_filter) != NULL;
+}
+
+static void report(const char* name, uint64_t ops, uint64_t ns, uint64_t allocs) {
+	printf("%-32s %10.1f ns/op %8.3f allocs/op %12llu ops\n",
+		name, (double)ns / (double)ops, (double)allocs / (double)ops, (unsigned long long)ops);
+	fflush(stdout);
+}
+
+static void wait_go(void) {
+	while (!atomic_load_explicit(&g_go, memory_order_acquire))
+		sched_yield();
+}
+
+/* 스레드 종료 직전에 자신의 할당 횟수를 합계에 더함 (시작 값은 호출자가 넘김) */
+static void add_thread_allocs(uint64_t start) {
+	atomic_fetch_add(&g_thread_allocs, t_allocs - start);
+}
+
+/* ================= protocol_parse ================= */
+
+/* 프레임 하나를 stream 뒤에 기록하고 기록한 바이트 수를 반환 */
+static size_t put_frame(char* dst, uint16_t type, int payload_len) {
+	uint16_t net_len = htons((uint16_t)(2 + payload_len));
+	uint16_t net_type = htons(type);
+	memcpy(dst, &net_len, 2);
+	memcpy(dst + 2, &net_type, 2);
+	memset(dst + 4, 'a', payload_len);
+	return 4 + (size_t)payload_len;
+}
+
+/*
+* 미리 만든 stream을 chunk 바이트씩 recv한 것처럼 수신 버퍼에 넣고 파싱하는 벤치마크
+* net.c의 수신 루프와 같이 recv 전마다 protocol_compact를 부르고, 파싱된 패킷은 바로 풀에 반납함
+* recv 한 번마다 다 읽은 것으로 보고 protocol_release를 불러, 수신 버퍼를 빌리고 돌려주는 비용까지 포함함
+* ns/op는 패킷 하나당 시간 (수신 버퍼로의 복사 포함)
+*/
+static void bench_parse(const char* name, const char* stream, size_t stream_len, size_t chunk, int rounds) {
+	if (!bench_enabled(name))
+		return;
+
+	connection_t* conn = calloc(1, sizeof(connection_t));
+	uint64_t packets = 0;
+
+	/* 풀 캐시를 미리 채워 첫 할당 비용이 측정에 섞이지 않게 함 */
+	packet_free(packet_alloc(MAX_PACKET_SIZE));
+
+	uint64_t allocs = t_allocs;
+	uint64_t start = monotonic_ns();
+
+	for (int r = 0; r < rounds; ++r) {
+		size_t off = 0;
+		while (off < stream_len) {
+			if (protocol_compact(conn) < 0) {
+				fprintf(stderr, "%s: recv buffer alloc failed\n", name);
+				exit(1);
+			}
+
+			size_t space = RECV_BUF_SIZE - conn->recv_len;
+			size_t n = stream_len - off;
+			if (n > chunk) n = chunk;
+			if (n > space) n = space;
+
+			memcpy(conn->recv_buf + conn->recv_len, stream + off, n);
+			conn->recv_len += (int)n;
+			off += n;
+
+			packet_t* pkt;
+			int rc;
+			while ((rc = protocol_parse(conn, &pkt)) > 0) {
+				packets++;
+				packet_free(pkt);
+			}
+			if (rc < 0) {
+				fprintf(stderr, "%s: unexpected protocol error\n", name);
+				exit(1);
+			}
+			protocol_release(conn, false);
+		}
+	}
+
+	report(name, packets, monotonic_ns() - start, t_allocs - allocs);
+	protocol_release(conn, true);
+	free(conn);
+}
+
+static void run_parse_benches(void) {
+	enum { STREAM_FRAMES = 4096 };
+	char* stream = malloc((size_t)STREAM_FRAMES * (MAX_PACKET_SIZE + 4));
+	size_t len;
+
+	/* 64바이트 채팅 하나씩 도착 */
+	len = 0;
+	for (int i = 0; i < STREAM_FRAMES; ++i)
+		len += put_frame(stream + len, PKT_CHAT, 64);
+	bench_parse("parse/single_64B", stream, len, 68, 200);
+
+	/* 64바이트 채팅 16개가 한 번의 recv로 몰려 도착 */
+	bench_parse("parse/pipelined_16x64B", stream, len, 16 * 68, 200);
+
+	/* 헤더까지 잘려서 7바이트씩 조금씩 도착 */
+	bench_parse("parse/trickle_7B", stream, len, 7, 20);
+
+	/* 0~1000바이트가 섞인 프레임을 4096바이트 recv로 받아 경계가 임의로 잘림 */
+	len = 0;
+	uint32_t seed = 12345;
+	for (int i = 0; i < STREAM_FRAMES; ++i) {
+		seed = seed * 1103515245u + 12345u;
+		len += put_frame(stream + len, (uint16_t)(1 + (seed >> 16) % 3), (int)((seed >> 8) % 1001));
+	}
+	bench_parse("parse/mixed_0-1000B_4K_recv", stream, len, RECV_BUF_SIZE, 50);
+
+	free(stream);
+}
+
+/* ================= job_queue ================= */
+
+typedef struct {
+	job_queue_t* q;
+	uint64_t ops;
+} jq_arg_t;
+
+static void* jq_producer(void* arg) {
+	jq_arg_t* a = arg;
+	uint64_t allocs = t_allocs;
+	wait_go();
+
+	job_t job = { 0 };
+	job.type = JOB_DISCONNECT;
+	for (uint64_t i = 0; i < a->ops; ++i) {
+		job.handle = HANDLE_MAKE(1, i);
+		job_queue_push(a->q, &job);
+	}
+
+	add_thread_allocs(allocs);
+	return NULL;
+}
+
+/* JOB_SHUTDOWN을 받을 때까지 꺼냄 */
+static void* jq_consumer(void* arg) {
+	jq_arg_t* a = arg;
+	uint64_t allocs = t_allocs;
+	wait_go();
+
+	job_t job;
+	for (;;) {
+		job_queue_pop(a->q, &job, JOBQ_BLOCK);
+		if (job.type == JOB_SHUTDOWN)
+			break;
+	}
+
+	add_thread_allocs(allocs);
+	return NULL;
+}
+
+/*
+* job_queue_push / job_queue_pop 처리량
+* 생산자 P개가 total개의 작업을 나눠 넣고 소비자 C개가 꺼냄, ns/op는 작업 하나가 큐를 통과하는 평균 시간
+*/
+static void bench_job_queue(int producers, int consumers, uint64_t total) {
+	char name[64];
+	snprintf(name, sizeof(name), "job_queue/%dp%dc", producers, consumers);
+	if (!bench_enabled(name))
+		return;
+
+	job_queue_t* q = malloc(sizeof(job_queue_t));
+	job_queue_init(q);
+
+	pthread_t tids[64];
+	jq_arg_t pa = { q, total / producers };
+	jq_arg_t ca = { q, 0 };
+
+	atomic_store(&g_go, false);
+	atomic_store(&g_thread_allocs, 0);
+
+	for (int i = 0; i < consumers; ++i)
+		pthread_create(&tids[i], NULL, jq_consumer, &ca);
+	for (int i = 0; i < producers; ++i)
+		pthread_create(&tids[consumers + i], NULL, jq_producer, &pa);
+
+	uint64_t start = monotonic_ns();
+	atomic_store_explicit(&g_go, true, memory_order_release);
+
+	for (int i = 0; i < producers; ++i)
+		pthread_join(tids[consumers + i], NULL);
+	for (int i = 0; i < consumers; ++i)
+		job_queue_push_shutdown(q);
+	for (int i = 0; i < consumers; ++i)
+		pthread_join(tids[i], NULL);
+
+	report(name, pa.ops * producers, monotonic_ns() - start, atomic_load(&g_thread_allocs));
+
+	pthread_mutex_destroy(&q->mutex);
+	pthread_cond_destroy(&q->cond);
+	free(q);
+}
+
+typedef struct {
+	mpsc_queue_t* q;
+	uint64_t ops;
+} mpsc_arg_t;
+
+static void* mpsc_producer(void* arg) {
+	mpsc_arg_t* a = arg;
+	uint64_t allocs = t_allocs;
+	wait_go();
+
+	job_t job = { 0 };
+	job.type = JOB_SEND;
+	for (uint64_t i = 0; i < a->ops; ++i) {
+		job.handle = HANDLE_MAKE(1, i);
+		while (!mpsc_queue_try_push(a->q, &job))
+			sched_yield();
+	}
+
+	add_thread_allocs(allocs);
+	return NULL;
+}
+
+/* reactor io_q(MPSC ring)의 처리량 : 생산자 P개, 소비자는 호출 스레드 하나 */
+static void bench_mpsc(int producers, uint64_t total) {
+	char name[64];
+	snprintf(name, sizeof(name), "mpsc_queue/%dp1c", producers);
+	if (!bench_enabled(name))
+		return;
+
+	mpsc_queue_t* q = aligned_alloc(64, sizeof(mpsc_queue_t));
+	mpsc_queue_init(q);
+
+	pthread_t tids[64];
+	mpsc_arg_t pa = { q, total / producers };
+	uint64_t expect = pa.ops * producers;
+
+	atomic_store(&g_go, false);
+	atomic_store(&g_thread_allocs, 0);
+
+	for (int i = 0; i < producers; ++i)
+		pthread_create(&tids[i], NULL, mpsc_producer, &pa);
+
+	uint64_t allocs = t_allocs;
+	uint64_t start = monotonic_ns();
+	atomic_store_explicit(&g_go, true, memory_order_release);
+
+	job_t batch[64];
+	uint64_t got = 0;
+	while (got < expect) {
+		int n = mpsc_queue_pop_batch(q, batch, 64);
+		if (n == 0)
+			sched_yield();
+		got += (uint64_t)n;
+	}
+
+	for (int i = 0; i < producers; ++i)
+		pthread_join(tids[i], NULL);
+
+	report(name, expect, monotonic_ns() - start, atomic_load(&g_thread_allocs) + (t_allocs - allocs));
+	free(q);
+}
+
+/* ================= room_broadcast ================= */
+
+/*
+* 방에 users명을 넣고 한 명이 채팅을 반복해서 보내는 벤치마크
+* 프레임 한 번 직렬화 + 멤버 목록 공유 비용을 잼 (대상 수만큼의 송신은 reactor 몫이라 stub은 대상 수만 셈)
+* channel < 0이면 일반 매칭 방, 그 외는 해당 채널 방을 사용
+*/
+static void bench_broadcast(int channel, int users, int payload_len, int rounds) {
+	char name[64];
+	snprintf(name, sizeof(name), "room_broadcast/%dusers_%dB", users, payload_len);
+	if (!bench_enabled(name))
+		return;
+
+	room_t* room = NULL;
+	for (int i = 0; i < users; ++i) {
+		room_t* r = (channel < 0) ? room_reserve() : room_reserve_channel(channel);
+		if (!r || (room && r != room)) {
+			fprintf(stderr, "%s: room setup failed\n", name);
+			return;
+		}
+		room = r;
+		room_join(room, HANDLE_MAKE(1, 100 + i), 1000 + i);
+	}
+
+	packet_t* pkt = packet_alloc((size_t)payload_len);
+	pkt->type = PKT_CHAT;
+	pkt->length = (uint16_t)(2 + payload_len);
+	memset(pkt->payload, 'a', payload_len);
+
+	uint64_t sends = t_sends;
+	uint64_t allocs = t_allocs;
+	uint64_t start = monotonic_ns();
+
+	for (int i = 0; i < rounds; ++i)
+		room_broadcast(room, HANDLE_MAKE(1, 100), pkt);
+
+	report(name, (uint64_t)rounds, monotonic_ns() - start, t_allocs - allocs);
+
+	if (t_sends - sends != (uint64_t)rounds * (uint64_t)(users - 1))
+		fprintf(stderr, "%s: unexpected fan-out %llu\n", name, (unsigned long long)(t_sends - sends));
+
+	packet_free(pkt);
+	for (int i = 0; i < users; ++i)
+		room_leave(room, HANDLE_MAKE(1, 100 + i));
+}
+
+/* ================= session ================= */
+
+typedef struct {
+	int id;
+	int threads;
+	int rounds;
+} sess_arg_t;
+
+/* 세션 벤치에서 사용하는 연결 id 수 */
+#define BENCH_SESSIONS 4096
+
+/*
+* 세션 생성/제거 반복
+* 실제 서버처럼 스레드마다 자신이 home worker인 연결 id(c % threads == 스레드 번호)만 다루고, session id 발급만 서로 경쟁함
+* 스레드 수가 WORKER_THREAD_NUM의 약수이면 스레드마다 home worker별 세션 목록도 겹치지 않음
+* 라운드마다 id가 새 연결에 재사용된 것처럼 세대를 올린 handle을 사용하며, 제거된 세션은 EBR 회수를 거쳐 해제됨
+*/
+static void* sess_worker(void* arg) {
+	sess_arg_t* a = arg;
+	uint64_t allocs = t_allocs;
+	wait_go();
+
+	for (int r = 0; r < a->rounds; ++r) {
+		for (int c = a->id; c < BENCH_SESSIONS; c += a->threads) {
+			if (!session_create(HANDLE_MAKE(r + 1, c))) {
+				fprintf(stderr, "session_create failed conn=%d\n", c);
+				exit(1);
+			}
+		}
+		for (int c = a->id; c < BENCH_SESSIONS; c += a->threads)
+			session_remove(HANDLE_MAKE(r + 1, c));
+	}
+
+	add_thread_allocs(allocs);
+	return NULL;
+}
+
+static void bench_session_churn(int threads, int rounds) {
+	char name[64];
+	snprintf(name, sizeof(name), "session/create_remove_%dt", threads);
+	if (!bench_enabled(name))
+		return;
+
+	pthread_t tids[64];
+	sess_arg_t args[64];
+
+	atomic_store(&g_go, false);
+	atomic_store(&g_thread_allocs, 0);
+
+	for (int i = 0; i < threads; ++i) {
+		args[i] = (sess_arg_t){ i, threads, rounds };
+		pthread_create(&tids[i], NULL, sess_worker, &args[i]);
+	}
+
+	uint64_t start = monotonic_ns();
+	atomic_store_explicit(&g_go, true, memory_order_release);
+	for (int i = 0; i < threads; ++i)
+		pthread_join(tids[i], NULL);
+
+	/* 생성과 제거를 한 쌍으로 셈 */
+	report(name, (uint64_t)rounds * BENCH_SESSIONS, monotonic_ns() - start, atomic_load(&g_thread_allocs));
+}
+
+/*
+* 세션 조회 (worker가 패킷마다 하는 session_get)
+* stale이면 끊긴 연결의 handle(이전 세대)로 조회해 NULL로 걸러지는 비용을 잼
+*/
+static void bench_session_get(int rounds, bool stale) {
+	const char* name = stale ? "session/get_stale" : "session/get_hit";
+	if (!bench_enabled(name))
+		return;
+
+	for (int c = 0; c < BENCH_SESSIONS; ++c)
+		session_create(HANDLE_MAKE(2, c));
+
+	uint32_t gen = stale ? 1 : 2;
+	uint64_t hits = 0;
+	uint64_t allocs = t_allocs;
+	uint64_t start = monotonic_ns();
+
+	for (int r = 0; r < rounds; ++r) {
+		for (int c = 0; c < BENCH_SESSIONS; ++c) {
+			session_t* s = session_get(HANDLE_MAKE(gen, c));
+			hits += (s && s->alive);
+		}
+	}
+
+	report(name, (uint64_t)rounds * BENCH_SESSIONS, monotonic_ns() - start, t_allocs - allocs);
+
+	if (hits != (stale ? 0 : (uint64_t)rounds * BENCH_SESSIONS))
+		fprintf(stderr, "%s: unexpected hits %llu\n", name, (unsigned long long)hits);
+
+	for (int c = 0; c < BENCH_SESSIONS; ++c)
+		session_remove(HANDLE_MAKE(2, c));
+}
+
+int main(int argc, char** argv) {
+	g_filter = (argc > 1) ? argv[1] : NULL;
+
+	/* 로그 문자열 출력 비용이 섞이지 않도록 끔 (레벨 비교 분기만 남음) */
+	log_set_level(LOG_LEVEL_OFF);
+
+	if (session_table_init(BENCH_SESSIONS) < 0) {
+		fprintf(stderr, "session_table_init failed\n");
+		return 1;
+	}
+
+	printf("%-32s %16s %18s %16s\n", "benchmark", "time", "allocations", "count");
+
+	run_parse_benches();
+
+	bench_job_queue(1, 1, 2000000);
+	bench_job_queue(2, 1, 2000000);
+	bench_job_queue(4, 1, 2000000);
+	bench_job_queue(4, 4, 2000000);
+
+	bench_mpsc(1, 4000000);
+	bench_mpsc(2, 4000000);
+	bench_mpsc(4, 4000000);
+
+	bench_broadcast(-1, MAX_ROOM_USER, 64, 1000000);
+	bench_broadcast(-1, MAX_ROOM_USER, 1000, 1000000);
+	bench_broadcast(1, 5000, 64, 1000000);
+
+	bench_session_get(500, false);
+	bench_session_get(500, true);
+	bench_session_churn(1, 200);
+	bench_session_churn(2, 200);
+	bench_session_churn(4, 200);
+
+	return 0;
+}
@@ -0,0 +1,820 @@
+/*
+* 채팅 서버 부하 생성기
+*
+* 여러 epoll 스레드에서 수천 개의 연결을 열고, 서버의 length/type 프레이밍(protocol.c)으로 시나리오를 실행함
+* 채팅 payload 앞부분에 송신 시각(CLOCK_MONOTONIC, 16자리 hex)을 넣어 보내고,
+* 같은 방의 다른 클라이언트가 브로드캐스트를 받은 시각과의 차이로 fan-out 지연 시간을 잼
+* (송신 시각과 수신 시각을 같은 시계로 비교하므로 서버와 같은 호스트에서 실행해야 함)
+*
+* 시나리오
+* - join  : 모든 클라이언트가 한꺼번에 접속/입장한 뒤 측정 구간 동안 한 번씩만 채팅을 보냄 (입장 폭주 + 입장 직후 전파 확인)
+* - chat  : 입장 후 클라이언트마다 초당 --rate개의 채팅을 보냄
+* - churn : chat과 같되, 클라이언트마다 평균 --churn초 간격으로 퇴장 후 바로 재입장함
+* - game  : chat 대신 PKT_GAME_ACTION을 보내고, 방의 tick 결과(PKT_GAME_RESULT)에 실려 돌아온 시각으로 입력 -> 결과 지연 시간을 잼
+*           (tick 대기 시간을 포함하며, 기본 relay 결과는 보낸 클라이언트에게도 가므로 자신의 입력도 셈)
+* --channel을 주면 자동 배정 방 대신 모든 클라이언트가 해당 채널 방(0 : 로비)에 들어가 대형 방 브로드캐스트를 잼
+*
+* 빌드 : gcc -O2 -pthread client/loadgen.c -o loadgen
+* 사용 예 : ./loadgen --scenario chat --clients 1000 --threads 4 --rate 10 --duration 10 --json
+*/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/* 서버 프로토콜 상수 (server/common.h와 맞춤) */
+#define PKT_CHAT 1
+#define PKT_JOIN_ROOM 2
+#define PKT_LEAVE_ROOM 3
+#define PKT_GAME_ACTION 4
+#define PKT_GAME_RESULT 5
+#define PKT_HEARTBEAT 6
+#define PKT_BUNDLE 7
+#define MAX_PACKET_SIZE 1024
+
+/* 클라이언트별 송수신 버퍼 크기 */
+#define IN_BUF_SIZE 8192
+#define OUT_BUF_SIZE 8192
+
+/* payload 맨 앞의 송신 시각 자리 수 (hex) */
+#define TS_HEX_LEN 16
+
+/* 측정 구간이 끝난 뒤 전송 중인 메시지를 마저 받는 시간 */
+#define DRAIN_NS (1000ull * 1000 * 1000)
+
+/* 모든 연결이 성립될 때까지 기다리는 최대 시간 */
+#define CONNECT_TIMEOUT_NS (10ull * 1000 * 1000 * 1000)
+
+#define MAX_EVENTS 256
+
+/* 지연 시간 히스토그램 (server/metrics.h와 같은 로그-선형 구조) */
+#define HIST_SUB_BITS 4
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS 40
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 1) * HIST_SUB)
+
+typedef enum {
+	SCN_JOIN,
+	SCN_CHAT,
+	SCN_CHURN,
+	SCN_GAME,
+} scenario_t;
+
+static const char* scenario_name[] = { "join", "chat", "churn", "game" };
+
+typedef struct {
+	const char* host;
+	int port;
+	int clients;
+	int threads;
+	double duration;		// 측정 구간 (초)
+	double rate;			// 클라이언트당 초당 채팅 수
+	int size;				// 채팅 payload 크기 (바이트)
+	double churn;			// churn 시나리오의 평균 재입장 간격 (초)
+	double settle;			// 입장 후 측정 시작까지 기다리는 시간 (초)
+	int channel;			// 입장할 채널 번호 (-1이면 자동 배정 방)
+	scenario_t scenario;
+	bool json;
+} config_t;
+
+typedef struct {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t buckets[HIST_BUCKETS];
+} hist_t;
+
+typedef struct {
+	int fd;
+	bool connected;
+	bool closed;
+	uint64_t connect_start_ns;
+	uint64_t next_send_ns;
+	uint64_t next_churn_ns;
+	int sends_left;				// 남은 채팅 수 (-1이면 제한 없음)
+
+	int in_len;
+	int out_head;
+	int out_len;
+	bool want_out;
+
+	char in[IN_BUF_SIZE];
+	char out[OUT_BUF_SIZE];
+} client_t;
+
+typedef struct {
+	uint64_t connected;
+	uint64_t connect_failed;
+	uint64_t disconnected;
+	uint64_t sent;
+	uint64_t send_skipped;		// 송신 버퍼가 가득 차 보내지 못한 채팅 수
+	uint64_t received;
+	uint64_t received_late;		// 측정 구간 밖에서 보낸 채팅 수신
+	uint64_t churns;
+	uint64_t bytes_out;
+	uint64_t bytes_in;
+	hist_t connect;
+	hist_t latency;
+} stats_t;
+
+typedef struct {
+	int id;
+	pthread_t tid;
+	int epfd;
+	client_t* clients;
+	int nclients;
+	uint32_t rng;
+	stats_t stats;
+} thread_ctx_t;
+
+static config_t cfg = {
+	.host = "127.0.0.1",
+	.port = 3800,
+	.clients = 1000,
+	.threads = 4,
+	.duration = 10.0,
+	.rate = 10.0,
+	.size = 64,
+	.churn = 2.0,
+	.settle = 0.5,
+	.channel = -1,
+	.scenario = SCN_CHAT,
+	.json = false,
+};
+
+static struct sockaddr_in server_addr;
+static pthread_barrier_t phase_barrier;
+static uint64_t g_start_ns;		// 측정 구간 시작 시각
+static uint64_t g_end_ns;		// 측정 구간 종료 시각
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* xorshift 난수 (스레드 전용 상태) */
+static uint32_t rng_next(uint32_t* s) {
+	uint32_t x = *s;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*s = x;
+	return x;
+}
+
+/* [0, range) 구간의 균등 난수 (ns) */
+static uint64_t rng_range(uint32_t* s, uint64_t range) {
+	if (range == 0)
+		return 0;
+	uint64_t r = ((uint64_t)rng_next(s) << 32) | rng_next(s);
+	return r % range;
+}
+
+static int hist_bucket(uint64_t v) {
+	if (v >= (1ull << HIST_MAX_BITS))
+		return HIST_BUCKETS - 1;
+	if (v < HIST_SUB)
+		return (int)v;
+
+	int msb = 63 - __builtin_clzll(v);
+	int e = msb - HIST_SUB_BITS + 1;
+	return e * HIST_SUB + (int)((v >> (e - 1)) - HIST_SUB);
+}
+
+static uint64_t hist_bucket_upper(int idx) {
+	int e = idx / HIST_SUB;
+	uint64_t m = idx % HIST_SUB;
+	if (e == 0)
+		return m;
+	return ((HIST_SUB + m + 1) << (e - 1)) - 1;
+}
+
+static void hist_record(hist_t* h, uint64_t v) {
+	h->buckets[hist_bucket(v)]++;
+	h->count++;
+	h->sum += v;
+	if (v > h->max)
+		h->max = v;
+}
+
+static void hist_merge(hist_t* dst, const hist_t* src) {
+	for (int i = 0; i < HIST_BUCKETS; ++i)
+		dst->buckets[i] += src->buckets[i];
+	dst->count += src->count;
+	dst->sum += src->sum;
+	if (src->max > dst->max)
+		dst->max = src->max;
+}
+
+/* q 분위수에 해당하는 칸의 상한 (최댓값을 넘지 않게 자름) */
+static uint64_t hist_quantile(const hist_t* h, double q) {
+	if (h->count == 0)
+		return 0;
+
+	uint64_t target = (uint64_t)(q * (double)h->count);
+	if (target >= h->count)
+		target = h->count - 1;
+
+	uint64_t seen = 0;
+	for (int i = 0; i < HIST_BUCKETS; ++i) {
+		seen += h->buckets[i];
+		if (seen > target) {
+			uint64_t upper = hist_bucket_upper(i);
+			return (upper < h->max) ? upper : h->max;
+		}
+	}
+	return h->max;
+}
+
+/* 프레임 하나를 송신 버퍼 뒤에 붙이는 함수, 자리가 없으면 -1 */
+static int client_queue_frame(client_t* c, uint16_t type, const char* payload, int len) {
+	int frame_len = 4 + len;
+
+	if (c->out_head > 0 && c->out_len + frame_len > OUT_BUF_SIZE) {
+		memmove(c->out, c->out + c->out_head, c->out_len - c->out_head);
+		c->out_len -= c->out_head;
+		c->out_head = 0;
+	}
+	if (c->out_len + frame_len > OUT_BUF_SIZE)
+		return -1;
+
+	uint16_t net_len = htons((uint16_t)(2 + len));
+	uint16_t net_type = htons(type);
+	memcpy(c->out + c->out_len, &net_len, 2);
+	memcpy(c->out + c->out_len + 2, &net_type, 2);
+	if (len > 0)
+		memcpy(c->out + c->out_len + 4, payload, len);
+	c->out_len += frame_len;
+	return 0;
+}
+
+/* 입장 요청 프레임 추가 (채널이 지정되어 있으면 채널 번호를 payload로 담음) */
+static int client_queue_join(client_t* c) {
+	if (cfg.channel < 0)
+		return client_queue_frame(c, PKT_JOIN_ROOM, NULL, 0);
+
+	uint16_t channel = htons((uint16_t)cfg.channel);
+	return client_queue_frame(c, PKT_JOIN_ROOM, (const char*)&channel, 2);
+}
+
+static void client_close(thread_ctx_t* t, client_t* c) {
+	if (c->closed)
+		return;
+	epoll_ctl(t->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+	close(c->fd);
+	c->closed = true;
+}
+
+/* 송신 버퍼를 소켓이 받는 만큼 보내는 함수, 연결 에러면 -1 */
+static int client_flush(thread_ctx_t* t, client_t* c) {
+	while (c->out_head < c->out_len) {
+		ssize_t n = send(c->fd, c->out + c->out_head, c->out_len - c->out_head, MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				c->want_out = true;
+				return 0;
+			}
+			return -1;
+		}
+		c->out_head += (int)n;
+		t->stats.bytes_out += (uint64_t)n;
+	}
+
+	c->out_head = c->out_len = 0;
+	c->want_out = false;
+	return 0;
+}
+
+static void client_fail(thread_ctx_t* t, client_t* c) {
+	if (c->closed)
+		return;
+	t->stats.disconnected++;
+	client_close(t, c);
+}
+
+/* 16자리 hex 송신 시각 해석, 형식이 맞지 않으면 0 */
+static uint64_t parse_ts(const char* p, int len) {
+	if (len < TS_HEX_LEN)
+		return 0;
+
+	uint64_t v = 0;
+	for (int i = 0; i < TS_HEX_LEN; ++i) {
+		char ch = p[i];
+		int d;
+		if (ch >= '0' && ch <= '9')
+			d = ch - '0';
+		else if (ch >= 'a' && ch <= 'f')
+			d = ch - 'a' + 10;
+		else
+			return 0;
+		v = (v << 4) | (uint64_t)d;
+	}
+	return v;
+}
+
+/* 받은 payload 앞의 송신 시각으로 지연 시간 기록 (측정 구간 밖에서 보낸 것은 따로 셈) */
+static void record_ts(thread_ctx_t* t, const char* p, int len, uint64_t now) {
+	uint64_t ts = parse_ts(p, len);
+	if (ts >= g_start_ns && ts < g_end_ns && now >= ts) {
+		t->stats.received++;
+		hist_record(&t->stats.latency, now - ts);
+	}
+	else {
+		t->stats.received_late++;
+	}
+}
+
+/* 수신 버퍼의 완성된 프레임을 모두 처리하는 함수, 프레이밍이 깨졌으면 -1 */
+static int client_parse(thread_ctx_t* t, client_t* c, uint64_t now) {
+	int off = 0;
+
+	while (c->in_len - off >= 4) {
+		uint16_t net_len, net_type;
+		memcpy(&net_len, c->in + off, 2);
+		memcpy(&net_type, c->in + off + 2, 2);
+		int len = ntohs(net_len);
+		/* 묶음 머리는 건너뛰고 안의 프레임을 하나씩 처리 (서버 SEND_BUNDLE) */
+		if (ntohs(net_type) == PKT_BUNDLE) {
+			off += 4;
+			continue;
+		}
+		if (len < 2 || len > MAX_PACKET_SIZE + 2)
+			return -1;
+		if (c->in_len - off < 2 + len)
+			break;
+
+		if (ntohs(net_type) == PKT_CHAT) {
+			record_ts(t, c->in + off + 4, len - 2, now);
+		}
+		else if (ntohs(net_type) == PKT_GAME_RESULT) {
+			/* tick 번호(4) 뒤에 입력마다 session_id(4) + 길이(2) + 내용 */
+			const char* p = c->in + off + 4 + 4;
+			const char* end = c->in + off + 2 + len;
+			while (end - p >= 6) {
+				uint16_t net_n;
+				memcpy(&net_n, p + 4, 2);
+				int n = ntohs(net_n);
+				if (end - p - 6 < n)
+					break;
+				record_ts(t, p + 6, n, now);
+				p += 6 + n;
+			}
+		}
+		else if (ntohs(net_type) == PKT_HEARTBEAT) {
+			/* 같은 타입으로 바로 응답 (송신 버퍼가 찼으면 뒤따르는 채팅 전송이 수신 시각을 대신 갱신함) */
+			client_queue_frame(c, PKT_HEARTBEAT, NULL, 0);
+		}
+
+		off += 2 + len;
+	}
+
+	if (off > 0) {
+		memmove(c->in, c->in + off, c->in_len - off);
+		c->in_len -= off;
+	}
+	return 0;
+}
+
+static void client_on_readable(thread_ctx_t* t, client_t* c) {
+	for (;;) {
+		ssize_t n = recv(c->fd, c->in + c->in_len, IN_BUF_SIZE - c->in_len, 0);
+		if (n > 0) {
+			c->in_len += (int)n;
+			t->stats.bytes_in += (uint64_t)n;
+			if (client_parse(t, c, now_ns()) < 0) {
+				client_fail(t, c);
+				return;
+			}
+			continue;
+		}
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			/* parse 중 쌓인 heartbeat 응답을 내보냄 */
+			if (!c->want_out && c->out_len > c->out_head && client_flush(t, c) < 0)
+				client_fail(t, c);
+			return;
+		}
+
+		client_fail(t, c);
+		return;
+	}
+}
+
+/* 논블로킹 connect 시작 */
+static int client_start(thread_ctx_t* t, client_t* c) {
+	memset(c, 0, offsetof(client_t, in));
+
+	c->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (c->fd < 0)
+		return -1;
+
+	int one = 1;
+	setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	c->connect_start_ns = now_ns();
+	if (connect(c->fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0 && errno != EINPROGRESS) {
+		close(c->fd);
+		return -1;
+	}
+
+	struct epoll_event ev;
+	ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+	ev.data.ptr = c;
+	if (epoll_ctl(t->epfd, EPOLL_CTL_ADD, c->fd, &ev) < 0) {
+		close(c->fd);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* connect 완료 처리 : 성공하면 곧바로 입장 요청 */
+static void client_on_connected(thread_ctx_t* t, client_t* c) {
+	int err = 0;
+	socklen_t len = sizeof(err);
+	if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+		t->stats.connect_failed++;
+		client_close(t, c);
+		return;
+	}
+
+	c->connected = true;
+	t->stats.connected++;
+	hist_record(&t->stats.connect, now_ns() - c->connect_start_ns);
+
+	client_queue_join(c);
+	if (client_flush(t, c) < 0)
+		client_fail(t, c);
+}
+
+static void handle_events(thread_ctx_t* t, int timeout_ms, int* pending_connects) {
+	struct epoll_event events[MAX_EVENTS];
+
+	int n = epoll_wait(t->epfd, events, MAX_EVENTS, timeout_ms);
+	for (int i = 0; i < n; ++i) {
+		client_t* c = events[i].data.ptr;
+		if (c->closed)
+			continue;
+
+		if (!c->connected) {
+			if (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+				client_on_connected(t, c);
+				if (pending_connects)
+					(*pending_connects)--;
+			}
+			continue;
+		}
+
+		if (events[i].events & EPOLLIN)
+			client_on_readable(t, c);
+		if (c->closed)
+			continue;
+
+		if ((events[i].events & (EPOLLERR | EPOLLHUP)) && !(events[i].events & EPOLLIN)) {
+			client_fail(t, c);
+			continue;
+		}
+
+		if ((events[i].events & EPOLLOUT) && c->want_out && client_flush(t, c) < 0)
+			client_fail(t, c);
+	}
+}
+
+/* 송신 시각을 담은 채팅 하나를 보내는 함수 */
+static void client_send_chat(thread_ctx_t* t, client_t* c, uint64_t now) {
+	char payload[MAX_PACKET_SIZE];
+	int len = cfg.size;
+
+	snprintf(payload, sizeof(payload), "%016llx", (unsigned long long)now);
+	memset(payload + TS_HEX_LEN, 'x', len - TS_HEX_LEN);
+
+	uint16_t type = (cfg.scenario == SCN_GAME) ? PKT_GAME_ACTION : PKT_CHAT;
+	if (client_queue_frame(c, type, payload, len) < 0) {
+		t->stats.send_skipped++;
+		return;
+	}
+
+	t->stats.sent++;
+	if (!c->want_out && client_flush(t, c) < 0)
+		client_fail(t, c);
+}
+
+/* 퇴장 후 바로 재입장 */
+static void client_churn(thread_ctx_t* t, client_t* c) {
+	if (client_queue_frame(c, PKT_LEAVE_ROOM, NULL, 0) < 0 || client_queue_join(c) < 0)
+		return;
+
+	t->stats.churns++;
+	if (!c->want_out && client_flush(t, c) < 0)
+		client_fail(t, c);
+}
+
+static void* loadgen_thread(void* arg) {
+	thread_ctx_t* t = arg;
+
+	/* 1. 접속 + 입장 : 담당 클라이언트를 한꺼번에 connect */
+	int pending = 0;
+	for (int i = 0; i < t->nclients; ++i) {
+		if (client_start(t, &t->clients[i]) < 0) {
+			t->clients[i].closed = true;
+			t->stats.connect_failed++;
+			continue;
+		}
+		pending++;
+	}
+
+	uint64_t deadline = now_ns() + CONNECT_TIMEOUT_NS;
+	while (pending > 0 && now_ns() < deadline)
+		handle_events(t, 10, &pending);
+
+	for (int i = 0; i < t->nclients; ++i) {
+		client_t* c = &t->clients[i];
+		if (!c->connected && !c->closed) {
+			t->stats.connect_failed++;
+			client_close(t, c);
+		}
+	}
+
+	/* 모든 스레드의 접속이 끝난 뒤 측정 구간을 한 번만 정함 */
+	if (pthread_barrier_wait(&phase_barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+		g_start_ns = now_ns() + (uint64_t)(cfg.settle * 1e9);
+		g_end_ns = g_start_ns + (uint64_t)(cfg.duration * 1e9);
+	}
+	pthread_barrier_wait(&phase_barrier);
+
+	/* 2. 측정 구간 : 송신 시점을 클라이언트마다 흩어 모든 클라이언트가 같은 순간에 보내지 않게 함 */
+	uint64_t span = g_end_ns - g_start_ns;
+	uint64_t interval = (cfg.scenario == SCN_JOIN || cfg.rate <= 0) ? span : (uint64_t)(1e9 / cfg.rate);
+	uint64_t churn_interval = (uint64_t)(cfg.churn * 1e9);
+
+	for (int i = 0; i < t->nclients; ++i) {
+		client_t* c = &t->clients[i];
+		c->next_send_ns = g_start_ns + rng_range(&t->rng, interval);
+		c->next_churn_ns = g_start_ns + rng_range(&t->rng, 2 * churn_interval);
+		c->sends_left = (cfg.scenario == SCN_JOIN) ? 1 : -1;
+	}
+
+	/* settle 동안에도 입장 처리와 수신은 계속함 */
+	while (now_ns() < g_start_ns)
+		handle_events(t, 1, NULL);
+
+	for (;;) {
+		uint64_t now = now_ns();
+		if (now >= g_end_ns)
+			break;
+
+		for (int i = 0; i < t->nclients; ++i) {
+			client_t* c = &t->clients[i];
+			if (c->closed)
+				continue;
+
+			if (cfg.scenario == SCN_CHURN && now >= c->next_churn_ns) {
+				client_churn(t, c);
+				c->next_churn_ns = now + churn_interval / 2 + rng_range(&t->rng, churn_interval);
+				if (c->closed)
+					continue;
+			}
+
+			/* 밀린 송신은 한 번에 몰아 보내지 않고 하나만 보낸 뒤 다음 주기로 넘김 */
+			if (c->sends_left != 0 && now >= c->next_send_ns) {
+				client_send_chat(t, c, now);
+				c->next_send_ns += interval;
+				if (c->next_send_ns < now)
+					c->next_send_ns = now + interval;
+				if (c->sends_left > 0)
+					c->sends_left--;
+			}
+		}
+
+		handle_events(t, 1, NULL);
+	}
+
+	/* 3. 전송 중인 메시지를 마저 받음 */
+	uint64_t drain_end = g_end_ns + DRAIN_NS;
+	while (now_ns() < drain_end)
+		handle_events(t, 10, NULL);
+
+	for (int i = 0; i < t->nclients; ++i)
+		client_close(t, &t->clients[i]);
+
+	return NULL;
+}
+
+/* 열 수 있는 fd 수를 hard 한도까지 올림 */
+static void raise_nofile(int need) {
+	struct rlimit rl;
+	if (getrlimit(RLIMIT_NOFILE, &rl) < 0)
+		return;
+	if (rl.rlim_cur >= (rlim_t)need)
+		return;
+	rl.rlim_cur = (rl.rlim_max == RLIM_INFINITY || rl.rlim_max > (rlim_t)need) ? (rlim_t)need : rl.rlim_max;
+	if (setrlimit(RLIMIT_NOFILE, &rl) < 0 || rl.rlim_cur < (rlim_t)need)
+		fprintf(stderr, "warning: RLIMIT_NOFILE=%llu is below %d\n", (unsigned long long)rl.rlim_cur, need);
+}
+
+static void usage(const char* prog) {
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"  --host HOST        server address (default 127.0.0.1)\n"
+		"  --port PORT        server port (default 3800)\n"
+		"  --scenario NAME    join | chat | churn | game (default chat)\n"
+		"  --clients N        connections (default 1000)\n"
+		"  --threads N        epoll threads (default 4)\n"
+		"  --duration SEC     measured interval (default 10)\n"
+		"  --rate N           chat messages per second per client (default 10)\n"
+		"  --size BYTES       chat payload size, %d..%d (default 64)\n"
+		"  --churn SEC        mean leave/rejoin interval for churn (default 2)\n"
+		"  --settle SEC       wait after joining before measuring (default 0.5)\n"
+		"  --channel N        join channel room N (0 = lobby) instead of matchmaking\n"
+		"  --json             print one JSON object instead of text\n",
+		prog, TS_HEX_LEN, MAX_PACKET_SIZE - 1);
+}
+
+static int parse_args(int argc, char** argv) {
+	static const struct option opts[] = {
+		{ "host", required_argument, NULL, 'h' },
+		{ "port", required_argument, NULL, 'p' },
+		{ "scenario", required_argument, NULL, 's' },
+		{ "clients", required_argument, NULL, 'c' },
+		{ "threads", required_argument, NULL, 't' },
+		{ "duration", required_argument, NULL, 'd' },
+		{ "rate", required_argument, NULL, 'r' },
+		{ "size", required_argument, NULL, 'z' },
+		{ "churn", required_argument, NULL, 'n' },
+		{ "settle", required_argument, NULL, 'w' },
+		{ "channel", required_argument, NULL, 'l' },
+		{ "json", no_argument, NULL, 'j' },
+		{ NULL, 0, NULL, 0 },
+	};
+
+	int opt;
+	while ((opt = getopt_long(argc, argv, "", opts, NULL)) != -1) {
+		switch (opt) {
+		case 'h': cfg.host = optarg; break;
+		case 'p': cfg.port = atoi(optarg); break;
+		case 'c': cfg.clients = atoi(optarg); break;
+		case 't': cfg.threads = atoi(optarg); break;
+		case 'd': cfg.duration = atof(optarg); break;
+		case 'r': cfg.rate = atof(optarg); break;
+		case 'z': cfg.size = atoi(optarg); break;
+		case 'n': cfg.churn = atof(optarg); break;
+		case 'w': cfg.settle = atof(optarg); break;
+		case 'l': cfg.channel = atoi(optarg); break;
+		case 'j': cfg.json = true; break;
+		case 's':
+			if (strcmp(optarg, "join") == 0) cfg.scenario = SCN_JOIN;
+			else if (strcmp(optarg, "chat") == 0) cfg.scenario = SCN_CHAT;
+			else if (strcmp(optarg, "churn") == 0) cfg.scenario = SCN_CHURN;
+			else if (strcmp(optarg, "game") == 0) cfg.scenario = SCN_GAME;
+			else return -1;
+			break;
+		default:
+			return -1;
+		}
+	}
+
+	/* 서버가 브로드캐스트 시 개행을 붙이므로 payload는 MAX_PACKET_SIZE - 1까지 */
+	if (cfg.clients <= 0 || cfg.threads <= 0 || cfg.duration <= 0 || cfg.churn <= 0 || cfg.settle < 0 ||
+		cfg.size < TS_HEX_LEN || cfg.size > MAX_PACKET_SIZE - 1)
+		return -1;
+	if (cfg.threads > cfg.clients)
+		cfg.threads = cfg.clients;
+	return 0;
+}
+
+static void print_report(const stats_t* s) {
+	double secs = cfg.duration;
+	double fanout = s->sent ? (double)s->received / (double)s->sent : 0.0;
+
+	if (cfg.json) {
+		printf("{\"scenario\":\"%s\",\"channel\":%d,\"clients\":%d,\"threads\":%d,\"duration_s\":%.3f,\"rate\":%.3f,\"size\":%d,"
+			"\"connected\":%llu,\"connect_failed\":%llu,\"disconnected\":%llu,"
+			"\"connect_p50_us\":%.1f,\"connect_p99_us\":%.1f,\"connect_max_us\":%.1f,"
+			"\"sent\":%llu,\"send_skipped\":%llu,\"received\":%llu,\"received_late\":%llu,\"churns\":%llu,"
+			"\"send_msgs_per_s\":%.1f,\"recv_msgs_per_s\":%.1f,\"fanout\":%.3f,"
+			"\"bytes_out\":%llu,\"bytes_in\":%llu,"
+			"\"latency_p50_us\":%.1f,\"latency_p99_us\":%.1f,\"latency_p999_us\":%.1f,\"latency_max_us\":%.1f,\"latency_mean_us\":%.1f}\n",
+			scenario_name[cfg.scenario], cfg.channel, cfg.clients, cfg.threads, cfg.duration, cfg.rate, cfg.size,
+			(unsigned long long)s->connected, (unsigned long long)s->connect_failed, (unsigned long long)s->disconnected,
+			hist_quantile(&s->connect, 0.5) / 1e3, hist_quantile(&s->connect, 0.99) / 1e3, s->connect.max / 1e3,
+			(unsigned long long)s->sent, (unsigned long long)s->send_skipped, (unsigned long long)s->received,
+			(unsigned long long)s->received_late, (unsigned long long)s->churns,
+			s->sent / secs, s->received / secs, fanout,
+			(unsigned long long)s->bytes_out, (unsigned long long)s->bytes_in,
+			hist_quantile(&s->latency, 0.5) / 1e3, hist_quantile(&s->latency, 0.99) / 1e3,
+			hist_quantile(&s->latency, 0.999) / 1e3, s->latency.max / 1e3,
+			s->latency.count ? (double)s->latency.sum / s->latency.count / 1e3 : 0.0);
+		return;
+	}
+
+	printf("[LOADGEN] scenario=%s channel=%d clients=%d threads=%d duration=%.1fs rate=%.1f/s size=%d\n",
+		scenario_name[cfg.scenario], cfg.channel, cfg.clients, cfg.threads, cfg.duration, cfg.rate, cfg.size);
+	printf("  connect  : ok=%llu failed=%llu p50=%.1fus p99=%.1fus max=%.1fus\n",
+		(unsigned long long)s->connected, (unsigned long long)s->connect_failed,
+		hist_quantile(&s->connect, 0.5) / 1e3, hist_quantile(&s->connect, 0.99) / 1e3, s->connect.max / 1e3);
+	printf("  sent     : %llu (%.1f msg/s) skipped=%llu churns=%llu\n",
+		(unsigned long long)s->sent, s->sent / secs, (unsigned long long)s->send_skipped, (unsigned long long)s->churns);
+	printf("  received : %llu (%.1f msg/s) fanout=%.2f late=%llu\n",
+		(unsigned long long)s->received, s->received / secs, fanout, (unsigned long long)s->received_late);
+	printf("  latency  : p50=%.1fus p99=%.1fus p999=%.1fus max=%.1fus\n",
+		hist_quantile(&s->latency, 0.5) / 1e3, hist_quantile(&s->latency, 0.99) / 1e3,
+		hist_quantile(&s->latency, 0.999) / 1e3, s->latency.max / 1e3);
+	printf("  errors   : disconnected=%llu\n", (unsigned long long)s->disconnected);
+}
+
+int main(int argc, char** argv) {
+	if (parse_args(argc, argv) < 0) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	memset(&server_addr, 0, sizeof(server_addr));
+	server_addr.sin_family = AF_INET;
+	server_addr.sin_port = htons((uint16_t)cfg.port);
+	if (inet_pton(AF_INET, cfg.host, &server_addr.sin_addr) != 1) {
+		fprintf(stderr, "invalid host: %s\n", cfg.host);
+		return 2;
+	}
+
+	raise_nofile(cfg.clients + cfg.threads + 64);
+
+	thread_ctx_t* ctx = calloc(cfg.threads, sizeof(thread_ctx_t));
+	if (!ctx) {
+		perror("calloc");
+		return 1;
+	}
+
+	pthread_barrier_init(&phase_barrier, NULL, cfg.threads);
+
+	/* 클라이언트를 스레드마다 고르게 나눔 */
+	for (int i = 0; i < cfg.threads; ++i) {
+		thread_ctx_t* t = &ctx[i];
+		t->id = i;
+		t->nclients = cfg.clients / cfg.threads + (i < cfg.clients % cfg.threads ? 1 : 0);
+		t->clients = calloc(t->nclients, sizeof(client_t));
+		t->rng = 0x9e3779b9u ^ (uint32_t)(i + 1) * 2654435761u;
+		t->epfd = epoll_create1(EPOLL_CLOEXEC);
+		if (!t->clients || t->epfd < 0) {
+			perror("thread setup");
+			return 1;
+		}
+	}
+
+	for (int i = 0; i < cfg.threads; ++i) {
+		if (pthread_create(&ctx[i].tid, NULL, loadgen_thread, &ctx[i]) != 0) {
+			perror("pthread_create");
+			return 1;
+		}
+	}
+
+	stats_t total;
+	memset(&total, 0, sizeof(total));
+
+	for (int i = 0; i < cfg.threads; ++i) {
+		pthread_join(ctx[i].tid, NULL);
+
+		stats_t* s = &ctx[i].stats;
+		total.connected += s->connected;
+		total.connect_failed += s->connect_failed;
+		total.disconnected += s->disconnected;
+		total.sent += s->sent;
+		total.send_skipped += s->send_skipped;
+		total.received += s->received;
+		total.received_late += s->received_late;
+		total.churns += s->churns;
+		total.bytes_out += s->bytes_out;
+		total.bytes_in += s->bytes_in;
+		hist_merge(&total.connect, &s->connect);
+		hist_merge(&total.latency, &s->latency);
+
+		close(ctx[i].epfd);
+		free(ctx[i].clients);
+	}
+
+	print_report(&total);
+
+	pthread_barrier_destroy(&phase_barrier);
+	free(ctx);
+	return 0;
+}
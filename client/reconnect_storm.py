@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""
+재접속 폭주(reconnect storm) 벤치마크
+
+서버 재시작 직후처럼 많은 클라이언트가 동시에 접속하는 상황을 흉내냄
+각 라운드마다 --clients개의 소켓을 한꺼번에 connect하고,
+접속이 끝난 소켓은 잘못된 헤더(length=0)를 보내 서버가 accept -> recv -> 파싱 -> 끊기까지 처리하는 시간을 잰다
+
+- connect : SYN을 보낸 뒤 연결이 성립되기까지 걸린 시간 (accept 대기열이 넘치면 SYN 재전송으로 1초 이상 걸림)
+- served  : 폭주 시작부터 서버가 해당 연결을 읽고 끊을 때까지 걸린 시간
+
+사용 예 : python3 reconnect_storm.py --clients 3000 --rounds 3
+"""
+import argparse
+import errno
+import selectors
+import socket
+import struct
+import time
+
+# length(2)=0 + type(2) : 서버 protocol_parse가 위반으로 판단해 연결을 끊는 헤더
+PROBE = struct.pack("!HH", 0, 0)
+
+# SYN 재전송 최소 간격(초), 이보다 오래 걸린 connect는 대기열 초과로 버려졌던 것으로 봄
+SYN_RETRY_SEC = 1.0
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    idx = min(len(values) - 1, int(len(values) * p / 100.0))
+    return values[idx]
+
+def fmt_ms(values):
+    return (f"p50={percentile(values, 50) * 1000:7.1f}ms "
+            f"p99={percentile(values, 99) * 1000:7.1f}ms "
+            f"max={(max(values) if values else 0) * 1000:7.1f}ms")
+
+def run_round(host: str, port: int, n: int, timeout: float):
+    sel = selectors.DefaultSelector()
+    connect_lat = []
+    served_lat = []
+    failed = 0
+
+    start = time.perf_counter()
+
+    # 1. 모든 소켓을 논블로킹으로 한꺼번에 connect
+    for _ in range(n):
+        s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        s.setblocking(False)
+        rc = s.connect_ex((host, port))
+        if rc not in (0, errno.EINPROGRESS):
+            failed += 1
+            s.close()
+            continue
+        sel.register(s, selectors.EVENT_WRITE, "connect")
+
+    # 2. 연결 성립 -> probe 전송 -> 서버가 끊을 때까지 대기
+    pending = len(sel.get_map())
+    deadline = start + timeout
+    while pending > 0:
+        remain = deadline - time.perf_counter()
+        if remain <= 0:
+            break
+
+        for key, _ in sel.select(timeout=remain):
+            s = key.fileobj
+            now = time.perf_counter()
+
+            if key.data == "connect":
+                err = s.getsockopt(socket.SOL_SOCKET, socket.SO_ERROR)
+                if err != 0:
+                    failed += 1
+                    pending -= 1
+                    sel.unregister(s)
+                    s.close()
+                    continue
+
+                connect_lat.append(now - start)
+                try:
+                    s.send(PROBE)
+                except OSError:
+                    pass
+                sel.modify(s, selectors.EVENT_READ, "served")
+                continue
+
+            # 서버가 연결을 끊으면 EOF 또는 RST가 옴
+            try:
+                data = s.recv(4096)
+            except BlockingIOError:
+                continue
+            except OSError:
+                data = b""
+
+            if not data:
+                served_lat.append(now - start)
+                pending -= 1
+                sel.unregister(s)
+                s.close()
+
+    # 시간 안에 끝나지 않은 연결 정리
+    for key in list(sel.get_map().values()):
+        failed += 1
+        sel.unregister(key.fileobj)
+        key.fileobj.close()
+    sel.close()
+
+    elapsed = time.perf_counter() - start
+    return elapsed, connect_lat, served_lat, failed
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--host", default="127.0.0.1")
+    ap.add_argument("--port", type=int, default=3800)
+    ap.add_argument("--clients", type=int, default=2000, help="라운드마다 동시에 접속할 클라이언트 수")
+    ap.add_argument("--rounds", type=int, default=3)
+    ap.add_argument("--timeout", type=float, default=30.0, help="라운드 제한 시간(초)")
+    ap.add_argument("--pause", type=float, default=0.5, help="라운드 사이 대기 시간(초)")
+    args = ap.parse_args()
+
+    total_served = 0
+    total_time = 0.0
+
+    for rnd in range(1, args.rounds + 1):
+        elapsed, connect_lat, served_lat, failed = run_round(args.host, args.port, args.clients, args.timeout)
+        retried = sum(1 for v in connect_lat if v >= SYN_RETRY_SEC)
+
+        print(f"[ROUND {rnd}] clients={args.clients} served={len(served_lat)} failed={failed} "
+              f"syn_retry={retried} time={elapsed:.3f}s")
+        print(f"  connect {fmt_ms(connect_lat)}")
+        print(f"  served  {fmt_ms(served_lat)}")
+
+        total_served += len(served_lat)
+        total_time += elapsed
+        time.sleep(args.pause)
+
+    if total_time > 0:
+        print(f"[TOTAL] served={total_served} rate={total_served / total_time:.0f} conn/s")
+
+if __name__ == "__main__":
+    main()
@@ -8,6 +8,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/epoll.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
@@ -19,49 +20,385 @@
 #include <stdbool.h>
 #include <unistd.h>
 #include <errno.h>
+#include <stdatomic.h>
+#include <time.h>
 
 
 #define PORTNUM 3800
 #define MAX_EVENTS 64
-#define MAX_CLIENTS 4096
+
+/*
+* 동시 연결 수 한도
+* 컴파일 시 상수가 아니라 시작 시 RLIMIT_NOFILE(soft 한도를 hard 한도까지 올린 값)에서 CONN_FD_RESERVE를 뺀 값을 사용함 (conn_table.c)
+* CONN_FD_RESERVE는 listen/epoll/eventfd/admin 소켓 등 연결 외 용도로 남겨 둘 fd 수
+* RLIMIT_NOFILE이 무제한이거나 매우 큰 경우에도 CONN_LIMIT_MAX를 넘지 않음
+*/
+#define CONN_FD_RESERVE 64
+#ifndef CONN_LIMIT_MAX
+#define CONN_LIMIT_MAX (1 << 22)
+#endif
+
+/*
+* listen 소켓의 accept 대기열 길이 (실제 값은 커널의 net.core.somaxconn으로 잘림)
+* 서버 재시작 후 클라이언트들이 한꺼번에 재접속해도 SYN이 버려지지 않도록 넉넉하게 잡음
+*/
+#ifndef LISTEN_BACKLOG
+#define LISTEN_BACKLOG 4096
+#endif
+
+/* listen 이벤트 한 번에 accept할 최대 연결 수, 남은 연결은 다음 epoll_wait에서 이어서 처리해 기존 클라이언트 처리가 밀리지 않게 함 */
+#define ACCEPT_BATCH 64
+
+/* reactor마다 재사용을 위해 남겨두는 연결 객체 수 */
+#define CONN_POOL_SIZE 1024
+
+/* 지표 조회용 admin Unix 소켓 경로 (metrics.c) */
+#ifndef ADMIN_SOCKET_PATH
+#define ADMIN_SOCKET_PATH "/tmp/chat_server_admin.sock"
+#endif
 
 #define RECV_BUF_SIZE 4096
-#define SEND_BUF_SIZE 4096
+
+/*
+* 연결 하나를 한 번 깨어날 때 읽는 최대 바이트 수 (epoll reactor)
+* 한 클라이언트가 패킷을 몰아 보내도 reactor를 붙잡지 않도록, 예산을 다 쓰고도 읽을 데이터가 남은 연결은
+* ready 목록에 올려 두고 다른 연결의 이벤트를 처리한 뒤 다음 루프에서 이어서 읽음
+*/
+#ifndef RECV_BUDGET_BYTES
+#define RECV_BUDGET_BYTES (4 * RECV_BUF_SIZE)
+#endif
+#define SEND_IOV_MAX 64
+
+/*
+* 송신 합치기 (기본 끔, 빌드 시 -DSEND_COALESCE=1)
+* SEND_COALESCE : epoll edge-triggered reactor도 프레임마다 바로 보내지 않고, 루프 한 번 동안 연결에 쌓인 프레임을 루프 끝에서 writev 하나로 보냄
+*                 (io_uring reactor와 level-triggered 모드는 원래 루프 단위로 모아 보냄)
+*                 한 번에 다 담지 못하는 경우 마지막 묶음 전까지 MSG_MORE를 붙여, TCP_CORK처럼 덜 찬 segment를 바로 내보내지 않게 함
+* SEND_COALESCE_WINDOW_MS : 0보다 크면 첫 프레임이 쌓인 뒤 이 시간 동안 더 모았다가 보냄 (지연을 더 내주고 시스템 콜과 패킷 수를 줄임)
+* SEND_BUNDLE : 1이면 한 번에 보내는 프레임들을 PKT_BUNDLE 프레임 하나로 묶음 (묶음 머리 4바이트만 따로 두므로 복사 없음, 클라이언트가 풀어야 함)
+* SEND_BUNDLE_MAX : 묶음 하나에 담는 본문 최대 바이트 (클라이언트 수신 버퍼가 담을 수 있어야 함)
+*/
+#ifndef SEND_COALESCE
+#define SEND_COALESCE 0
+#endif
+#ifndef SEND_COALESCE_WINDOW_MS
+#define SEND_COALESCE_WINDOW_MS 0
+#endif
+#ifndef SEND_BUNDLE
+#define SEND_BUNDLE 0
+#endif
+#ifndef SEND_BUNDLE_MAX
+#define SEND_BUNDLE_MAX 4096
+#endif
+
+/*
+* 연결별 송신 큐 한도 (바이트)
+* soft 한도를 넘은 상태가 SEND_SOFT_LIMIT_MS 동안 계속되거나, hard 한도를 넘으면 연결을 끊음
+* 즉 일시적으로 느린 클라이언트는 버티고, 계속 읽지 않는 클라이언트만 정리함
+*/
+#define SEND_SOFT_LIMIT (64 * 1024)
+#define SEND_HARD_LIMIT (1024 * 1024)
+#define SEND_SOFT_LIMIT_MS 10000
 #define MAX_PACKET_SIZE 1024
 
+/* 자동 배정(MATCH) 방의 정원 */
 #define MAX_ROOM_USER 4
 #define MAX_ROOMS 256
 
+/*
+* 대형 방 설정 (state.h의 room_kind_t 참고)
+* 채널 0번은 로비이며, PKT_JOIN_ROOM payload에 채널 번호(2바이트, network order)를 담아 입장함
+*/
+#define MAX_CHANNELS 64
+#ifndef LOBBY_CAPACITY
+#define LOBBY_CAPACITY 8192
+#endif
+#ifndef CHANNEL_CAPACITY
+#define CHANNEL_CAPACITY 8192
+#endif
+
 #define WORKER_THREAD_NUM 4
+#define NET_THREAD_NUM 2
+
+/*
+* 1이면 클라이언트 소켓을 EPOLLIN | EPOLLOUT | EPOLLET로 한 번만 등록하고 send를 즉시 시도함
+* 부분 전송이 발생한 경우에만 want_write로 쓰기 대기를 기록하므로 패킷당 epoll_ctl 호출이 없음
+* 0이면 송신 큐가 찰 때마다 EPOLLOUT을 켜고 끄는 level-triggered 방식으로 동작
+*/
+#ifndef NET_EDGE_TRIGGERED
+#define NET_EDGE_TRIGGERED 1
+#endif
+
+/*
+* 네트워크 backend 선택 (빌드 시 -DNET_IO_URING=1)
+* 0이면 epoll reactor(net.c), 1이면 io_uring reactor(net_uring.c)를 사용함
+* io_uring backend는 multishot accept/recv와 provided buffer ring으로 readiness 통지 후 시스템 콜을 다시 부르는 과정을 없애고,
+* logic -> net 깨우기도 eventfd 대신 IORING_OP_MSG_RING으로 reactor의 ring에 직접 완료 이벤트를 넣음
+*/
+#ifndef NET_IO_URING
+#define NET_IO_URING 0
+#endif
+
 #define JOB_QUEUE_SIZE 1024
 
+/*
+* net -> logic 흐름 제어 (worker 큐 적재량 기준, job_queue.c)
+* reactor는 worker 큐에 넣을 때 대기하지 않으며, 큐가 HIGH 이상이면 어떤 연결의 패킷도 넣지 않고 그 worker로 패킷을 보내던 연결의 읽기를 멈춤
+* 큐가 LOW 이하로 내려가면 worker가 reactor를 깨워 멈춘 연결을 다시 읽게 함
+* 적재량에는 worker가 방 소유 worker 큐가 가득 차 아직 넘기지 못하고 들고 있는 방 작업도 포함됨
+* HIGH 이상인 큐가 하나라도 있는 동안 새 연결은 accept 직후 닫음
+* HIGH와 가득 찬 상태 사이의 여유는 끊김 이벤트와 worker 사이의 방 작업만 씀 (job_queue_try_push_packet이 HIGH에서 막음)
+*/
+#ifndef LOGIC_Q_HIGH_WATERMARK
+#define LOGIC_Q_HIGH_WATERMARK (JOB_QUEUE_SIZE * 3 / 4)
+#endif
+#ifndef LOGIC_Q_LOW_WATERMARK
+#define LOGIC_Q_LOW_WATERMARK (JOB_QUEUE_SIZE / 4)
+#endif
+
+/* 방 소유 worker 큐가 가득 차 방 작업이 밀려 있는 worker가 다시 넣어 보는 간격 (logic.c) */
+#ifndef LOGIC_ROOM_RETRY_MS
+#define LOGIC_ROOM_RETRY_MS 1
+#endif
+
+/*
+* 수신 속도 제한 (연결별 token bucket, rate_limit.c)
+* reactor가 파싱 직후 worker 큐에 넣기 전에 검사하므로, 한도를 넘은 패킷은 worker 큐와 방 브로드캐스트까지 가지 않음
+* RATE_<대상>_PER_SEC : 초당 허용 패킷 수 (0이면 제한 없음)
+* RATE_<대상>_BURST : 쉬지 않고 몰아 보낼 수 있는 최대 패킷 수
+* RATE_<대상>_ACTION : 한도를 넘었을 때 동작 (rl_action_t)
+* CONN은 패킷 종류와 관계없이 연결 전체에 적용되며, 종류별 한도를 통과한 패킷만 연결 한도를 검사함
+*/
+#ifndef RATE_CONN_PER_SEC
+#define RATE_CONN_PER_SEC 200
+#endif
+#ifndef RATE_CONN_BURST
+#define RATE_CONN_BURST 400
+#endif
+#ifndef RATE_CONN_ACTION
+#define RATE_CONN_ACTION RL_DISCONNECT
+#endif
+#ifndef RATE_CHAT_PER_SEC
+#define RATE_CHAT_PER_SEC 20
+#endif
+#ifndef RATE_CHAT_BURST
+#define RATE_CHAT_BURST 40
+#endif
+#ifndef RATE_CHAT_ACTION
+#define RATE_CHAT_ACTION RL_DROP
+#endif
+#ifndef RATE_ROOM_PER_SEC
+#define RATE_ROOM_PER_SEC 5					// 입장/퇴장 각각
+#endif
+#ifndef RATE_ROOM_BURST
+#define RATE_ROOM_BURST 10
+#endif
+#ifndef RATE_ROOM_ACTION
+#define RATE_ROOM_ACTION RL_DELAY
+#endif
+#ifndef RATE_GAME_ACTION_PER_SEC
+#define RATE_GAME_ACTION_PER_SEC 60
+#endif
+#ifndef RATE_GAME_ACTION_BURST
+#define RATE_GAME_ACTION_BURST 120
+#endif
+#ifndef RATE_GAME_ACTION_ACTION
+#define RATE_GAME_ACTION_ACTION RL_DELAY
+#endif
+
+/*
+* 타이머 (timer_wheel.c, reactor와 worker가 각자 휠 하나씩 사용)
+* TIMER_TICK_MS : 휠의 시간 단위, 타이머는 예정 시각 이후 첫 tick에 만료됨
+* IDLE_TIMEOUT_MS : 이 시간 동안 아무것도 받지 못한 연결은 끊음 (0이면 끄며, 하프 오픈 연결과 응답 없는 클라이언트 정리용)
+* HEARTBEAT_INTERVAL_MS : 이 시간 동안 조용한 연결에 PKT_HEARTBEAT를 보내 응답을 유도함 (0이면 보내지 않음, IDLE_TIMEOUT_MS보다 작아야 함)
+* JOIN_DEADLINE_MS : 접속하거나 방을 나간 뒤 이 시간 안에 방에 들어가지 않은 연결은 끊음 (0이면 끔)
+* 수신 경로는 패킷마다 연결의 마지막 수신 시각만 갱신하고, 타이머는 만료 시점에 그 시각을 보고 다시 걸거나 끊음
+*/
+#ifndef TIMER_TICK_MS
+#define TIMER_TICK_MS 10
+#endif
+#ifndef IDLE_TIMEOUT_MS
+#define IDLE_TIMEOUT_MS 90000
+#endif
+#ifndef HEARTBEAT_INTERVAL_MS
+#define HEARTBEAT_INTERVAL_MS 30000
+#endif
+#ifndef JOIN_DEADLINE_MS
+#define JOIN_DEADLINE_MS 0
+#endif
+
+/*
+* 게임 tick (game.c)
+* GAME_TICK_HZ : 자동 배정(MATCH) 방의 기본 tick 주기 (초당 횟수)
+* GAME_TICK_HZ_CHANNEL : 로비 / 채널 방의 기본 tick 주기
+* 시뮬레이션 콜백이 방마다 주기를 바꿀 수 있으며, 최대 주기는 타이머 휠 tick(TIMER_TICK_MS)에 한 번
+* 주기가 TIMER_TICK_MS의 배수가 아니면 tick마다 휠 tick 단위로 늦어지지만, 예정 시각은 주기대로 쌓으므로 평균 주기는 유지됨
+* GAME_INPUT_MAX : 방의 tick 하나에 모으는 입력 최대 수 (입력 바이트는 결과 프레임 하나에 담길 만큼으로 제한, 넘치면 버림)
+* GAME_IDLE_STOP_MS : 기본 relay 시뮬레이션은 이 시간 동안 입력이 없으면 tick을 멈추고 다음 입력에서 다시 시작함
+*/
+#ifndef GAME_TICK_HZ
+#define GAME_TICK_HZ 20
+#endif
+#ifndef GAME_TICK_HZ_CHANNEL
+#define GAME_TICK_HZ_CHANNEL 10
+#endif
+#define GAME_TICK_HZ_MAX (1000 / TIMER_TICK_MS)
+#ifndef GAME_INPUT_MAX
+#define GAME_INPUT_MAX 128
+#endif
+#ifndef GAME_IDLE_STOP_MS
+#define GAME_IDLE_STOP_MS 10000
+#endif
+
 extern volatile sig_atomic_t g_terminate;
 
 typedef enum {
-	PKT_CHAT = 1,        // ä
-	PKT_JOIN_ROOM,       //  
-	PKT_LEAVE_ROOM,      //  
-	PKT_GAME_ACTION,     //  Է
-	PKT_GAME_RESULT,     //  
+	PKT_CHAT = 1,        // 채팅
+	PKT_JOIN_ROOM,       // 방 입장
+	PKT_LEAVE_ROOM,      // 방 퇴장
+	PKT_GAME_ACTION,     // 게임 입력
+	PKT_GAME_RESULT,     // 게임 결과
+	PKT_HEARTBEAT,       // 연결 확인 (서버가 조용한 연결에 보내고, 클라이언트는 같은 타입으로 응답하며 reactor에서 소비됨)
+	PKT_BUNDLE,          // 프레임 묶음 (SEND_BUNDLE, 서버 -> 클라이언트), payload는 헤더를 포함한 프레임들을 그대로 이은 것이라 머리 4바이트만 건너뛰고 이어서 파싱하면 됨
 } packet_type_t;
 
-typedef struct {
-	uint16_t type;					//  
-	uint16_t length;				// payload  
-	char payload[MAX_PACKET_SIZE];	//   
+/*
+* 수신 패킷
+* payload 크기에 맞는 size class의 풀 버퍼에 할당되며(packet_pool.c), job에는 포인터만 담겨 전달됨
+*/
+typedef struct packet {
+	struct packet* next;			// 풀 free list 연결용
+	uint8_t size_class;				// 할당된 풀 size class
+	uint8_t charged;				// 수신 속도 제한을 이미 통과해 token을 쓴 패킷 (보류 후 다시 넣을 때 검사하지 않음, flow.c)
+	uint16_t type;					// 프로토콜 종류
+	uint16_t length;				// (type + payload) 길이
+	uint64_t recv_ns;				// reactor가 파싱한 시각 (monotonic_ns), 지연 시간 측정용
+	char payload[];					// 가변 데이터 영역 (size class 용량만큼 할당)
 } packet_t;
 
+/*
+* 연결 handle = (세대 << 32) | 연결 id
+* 연결 id는 fd와 무관하게 conn_table이 빈 번호부터 발급하는 dense 번호이며, 연결이 끊기면 바로 다른 연결에 재사용됨
+* 그래서 id마다 세대를 두고 발급할 때마다 올리며, 작업, 세션, 방 멤버 목록은 handle을 들고 다님
+* 세대가 다른(이미 끊긴 연결의) handle은 조회/전송 단계에서 버려짐
+* 세대 0은 발급하지 않으므로 0은 빈 handle로 사용함
+*/
+typedef uint64_t conn_handle_t;
+
+#define HANDLE_NONE ((conn_handle_t)0)
+#define HANDLE_MAKE(gen, id) (((conn_handle_t)(uint32_t)(gen) << 32) | (uint32_t)(id))
+#define HANDLE_ID(h) ((int)(uint32_t)(h))
+#define HANDLE_GEN(h) ((uint32_t)((h) >> 32))
+
+struct sbuf;
+struct send_chunk;
+
+/*
+* 연결별 송신 큐 (send_queue.c)
+* 프레임 참조를 고정 크기 chunk들의 연결 리스트에 담아 필요한 만큼 늘어남
+* chunk는 io_buf 풀에서 빌리며 다 보내면 바로 돌려주므로, 보낼 것이 없는 연결은 chunk를 들고 있지 않음
+* 부분 전송은 맨 앞 프레임의 offset으로만 기록하므로 데이터를 당기는 compaction이 없음
+*/
+typedef struct {
+	struct send_chunk* head;		// 가장 먼저 보낼 프레임이 있는 chunk
+	struct send_chunk* tail;		// 새 프레임을 붙일 chunk
+	int count;						// 대기 중인 프레임 수
+	size_t bytes;					// 아직 보내지 못한 전체 바이트 수
+	int offset;						// 맨 앞 프레임에서 이미 전송된 바이트 수
+	uint64_t soft_since;			// soft 한도를 처음 넘은 시각(ms), 한도 아래면 0
+
+	/* 보내는 중인 PKT_BUNDLE (SEND_BUNDLE), 본문은 큐 앞쪽의 프레임들 */
+	uint32_t bundle_left;			// 아직 보내지 못한 묶음 본문 바이트
+	uint8_t bundle_hdr_left;		// 아직 보내지 못한 묶음 머리 바이트
+	uint8_t bundle_hdr[4];
+} send_queue_t;
+
+/*
+* 타이머 휠에 거는 타이머 (timer_wheel.c)
+* 객체에 내장해 두고 휠의 칸 목록에 직접 연결하므로 등록/취소에 할당이 없음
+*/
+typedef struct wheel_timer {
+	struct wheel_timer* next;
+	struct wheel_timer** pprev;		// 앞 노드의 next(또는 칸 머리) 주소, 등록되지 않았으면 NULL
+	uint64_t expire;				// 만료 tick
+	uint16_t slot;					// 들어 있는 칸 (단 x TW_SLOTS + 칸 번호)
+	void (*fn)(void* arg);			// 만료 시 호출 (휠에서 뺀 뒤 호출하므로 안에서 다시 등록해도 됨)
+	void* arg;
+} wheel_timer_t;
+
+/* 수신 속도 제한을 넘은 패킷의 처리 */
+typedef enum {
+	RL_PASS,				// 한도 안 (worker로 넘김)
+	RL_DROP,				// 버림
+	RL_DELAY,				// 토큰이 찰 때까지 연결의 읽기를 멈추고 패킷은 보류했다가 순서대로 넘김
+	RL_DISCONNECT,			// 연결을 끊음
+	RL_ACTION_COUNT
+} rl_action_t;
+
+/* 속도 제한 대상 수 : 0번은 연결 전체 한도, 나머지는 패킷 종류 번호 */
+#define RATE_LIMITS (PKT_GAME_RESULT + 1)
+
+/*
+* 수신 속도 제한 token bucket (rate_limit.c)
+* 토큰은 1/1000 단위로 보관해, 경과 시간(ms) x 초당 허용량만큼 정수 연산으로 채움
+*/
 typedef struct {
+	uint32_t tokens;				// 남은 토큰 x 1000
+	uint32_t last_ms;				// 마지막으로 채운 시각 (monotonic_ms 하위 32비트)
+} rate_bucket_t;
+
+/* 단조 증가 시계(ns), 지연 시간 측정용 */
+static inline uint64_t monotonic_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* 단조 증가 시계(ms) */
+static inline uint64_t monotonic_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+typedef struct connection {
 	int fd;
+	conn_handle_t handle;			// accept 시 발급한 연결 handle
+	int owner;						// 연결을 담당하는 reactor 번호
+
+	/* 담당 reactor의 살아 있는 연결 목록 (종료 시 정리용, 담당 reactor만 접근) */
+	struct connection* live_prev;
+	struct connection* live_next;
 
 	// recv
-	char recv_buf[RECV_BUF_SIZE];	//  
-	int recv_len;					//  ŵ  	
+	char* recv_buf;					// 수신 버퍼 (io_buf 풀에서 빌림), 처리할 데이터가 없으면 NULL
+	int recv_head;					// 아직 파싱하지 않은 데이터의 시작 위치
+	int recv_len;					// 현재 수신된 버퍼 길이 (수신 데이터의 끝 위치)	
+
+	/*
+	* 흐름 제어 (worker 큐가 HIGH 이상이거나 속도 제한 지연으로 읽기를 멈춘 상태)
+	* 멈추기 전에 이미 파싱한 패킷은 순서대로 보류 목록에 두었다가 다시 읽기 전에 먼저 넣음
+	*/
+	bool paused;
+	bool paused_by_queue;			// worker 큐 적체로 멈춤 (LOW 이하까지 기다림), false면 RL_DELAY로 멈춤 (지연 시각만 기다림)
+	packet_t* stalled_head;
+	packet_t* stalled_tail;
+
+	bool ready;						// 수신 예산을 다 써 reactor의 ready 목록에서 다음 차례를 기다리는 중
+	bool heavy;						// 최근 수신 예산을 다 쓴 연결 (EAGAIN까지 읽으면 내림), worker 큐가 HIGH 이상이면 먼저 멈춤
+
+	/* 수신 속도 제한 (담당 reactor만 접근) */
+	rate_bucket_t rate[RATE_LIMITS];
+	uint64_t throttled_until;		// RL_DELAY로 멈춘 경우 다시 넘길 수 있는 시각(ms)
+
+	/* 유휴 / heartbeat 감시 (담당 reactor만 접근) */
+	uint64_t last_active;			// 마지막으로 데이터를 받은 시각(ms), 수신 경로는 이 값만 갱신함
+	wheel_timer_t idle_timer;		// reactor 타이머 휠에 건 유휴 검사 타이머
 
 	// send
-	char send_buf[SEND_BUF_SIZE];	// ۽ 
-	int send_len;					// ۽ؾ  ü  
-	int send_offset;				// ̹ ۵ Ʈ (κ   ʿ)
+	send_queue_t sendq;				// 송신 대기 프레임 큐
+	bool want_write;				// 부분 전송 후 EPOLLOUT을 기다리는 중 (edge-triggered 모드 전용)
+	bool flush_pending;				// 송신 합치기로 reactor의 flush 목록에서 전송을 기다리는 중 (epoll reactor 전용)
 } connection_t;
 
 #endif
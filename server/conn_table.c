@@ -0,0 +1,99 @@
+#include "conn_table.h"
+#include "log.h"
+
+#include <sys/resource.h>
+
+slot_map_t g_conn_slots;
+
+/* 빈 id 목록과 아직 한 번도 쓰지 않은 id의 시작 번호 (accept하는 reactor들이 경쟁하므로 락으로 보호) */
+static pthread_mutex_t conn_table_lock = PTHREAD_MUTEX_INITIALIZER;
+static int free_head = -1;
+static int next_unused = 0;
+
+/*
+* RLIMIT_NOFILE에서 연결 id 한도를 정하는 함수
+* soft 한도가 hard 한도보다 낮으면 hard 한도까지 올려 보고, 올리지 못하면 soft 한도를 그대로 사용함
+*/
+static int conn_limit_from_rlimit(void) {
+	struct rlimit rl;
+	if (getrlimit(RLIMIT_NOFILE, &rl) < 0) {
+		LOG_WARN("[CONN] getrlimit failed: %E", errno);
+		return 1024 - CONN_FD_RESERVE;
+	}
+
+	if (rl.rlim_cur < rl.rlim_max) {
+		rlim_t soft = rl.rlim_cur;
+		rl.rlim_cur = rl.rlim_max;
+		if (setrlimit(RLIMIT_NOFILE, &rl) < 0)
+			rl.rlim_cur = soft;
+	}
+
+	if (rl.rlim_cur == RLIM_INFINITY || rl.rlim_cur > (rlim_t)CONN_LIMIT_MAX + CONN_FD_RESERVE)
+		return CONN_LIMIT_MAX;
+	if (rl.rlim_cur <= (rlim_t)CONN_FD_RESERVE)
+		return 1;
+	return (int)rl.rlim_cur - CONN_FD_RESERVE;
+}
+
+int conn_table_init(void) {
+	int limit = conn_limit_from_rlimit();
+	if (slot_map_init(&g_conn_slots, sizeof(conn_slot_t), limit) < 0)
+		return -1;
+
+	LOG_INFO("[CONN] connection limit=%d (RLIMIT_NOFILE - %d)", limit, CONN_FD_RESERVE);
+	return 0;
+}
+
+int conn_table_limit(void) {
+	return g_conn_slots.limit;
+}
+
+conn_handle_t conn_table_alloc(int owner, void* conn) {
+	pthread_mutex_lock(&conn_table_lock);
+
+	int id;
+	conn_slot_t* slot;
+	if (free_head >= 0) {
+		id = free_head;
+		slot = slot_map_get(&g_conn_slots, id);
+		free_head = slot->next_free;
+	}
+	else {
+		id = next_unused;
+		slot = slot_map_ensure(&g_conn_slots, id);
+		if (!slot) {
+			pthread_mutex_unlock(&conn_table_lock);
+			return HANDLE_NONE;
+		}
+		next_unused++;
+	}
+
+	pthread_mutex_unlock(&conn_table_lock);
+
+	/* 세대 0은 빈 handle이므로 건너뜀 */
+	unsigned gen = atomic_load_explicit(&slot->gen, memory_order_relaxed) + 1;
+	if (gen == 0)
+		gen = 1;
+
+	/* 연결 객체와 세대를 먼저 채운 뒤 owner를 release로 올려, owner를 본 스레드가 이전 세대를 보지 않게 함 */
+	slot->conn = conn;
+	atomic_store_explicit(&slot->gen, gen, memory_order_relaxed);
+	atomic_store_explicit(&slot->owner, owner, memory_order_release);
+
+	return HANDLE_MAKE(gen, id);
+}
+
+void conn_table_free(conn_handle_t handle) {
+	int id = HANDLE_ID(handle);
+	conn_slot_t* slot = slot_map_get(&g_conn_slots, id);
+	if (!slot)
+		return;
+
+	atomic_store_explicit(&slot->owner, -1, memory_order_release);
+	slot->conn = NULL;
+
+	pthread_mutex_lock(&conn_table_lock);
+	slot->next_free = free_head;
+	free_head = id;
+	pthread_mutex_unlock(&conn_table_lock);
+}
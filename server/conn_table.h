@@ -0,0 +1,47 @@
+#ifndef CONN_TABLE_H
+#define CONN_TABLE_H
+
+#include "common.h"
+#include "slot_map.h"
+
+/*
+* 연결 테이블
+* 연결마다 fd와 무관한 dense id를 발급하고, id -> (연결 객체, 담당 reactor, 세대)를 slot_map에 보관함
+* 끊긴 연결의 id는 빈 목록에 돌려 다음 연결이 먼저 재사용하므로, id는 동시 연결 수 범위 안에 빽빽하게 유지됨
+* id 한도는 RLIMIT_NOFILE에서 정하며(common.h의 CONN_FD_RESERVE 참고), fd 번호가 커도 테이블 크기와 상관없음
+*/
+typedef struct conn_slot {
+	void* conn;							// 연결 객체 (담당 reactor만 읽고 씀)
+	atomic_int owner;					// 담당 reactor 번호, 비어 있으면 -1
+	atomic_uint gen;					// 마지막으로 발급한 세대
+	int next_free;						// 빈 id 목록 연결 (테이블 락으로 보호)
+} conn_slot_t;
+
+extern slot_map_t g_conn_slots;
+
+int conn_table_init(void);
+int conn_table_limit(void);
+
+/* 빈 id에 연결을 등록하고 새 세대의 handle을 반환 (한도에 도달했으면 HANDLE_NONE) */
+conn_handle_t conn_table_alloc(int owner, void* conn);
+
+/* 연결을 테이블에서 내리고 id를 빈 목록에 돌려줌 (담당 reactor에서 호출) */
+void conn_table_free(conn_handle_t handle);
+
+/* handle이 가리키는 연결의 담당 reactor 번호 (끊긴 연결이면 -1, 세대는 reactor가 다시 확인함) */
+static inline int conn_table_owner(conn_handle_t handle) {
+	conn_slot_t* slot = slot_map_get(&g_conn_slots, HANDLE_ID(handle));
+	return slot ? atomic_load_explicit(&slot->owner, memory_order_acquire) : -1;
+}
+
+/* reactor가 자신이 담당한 연결 객체를 handle로 찾는 함수 (끊겼거나 세대가 다르면 NULL) */
+static inline void* conn_table_lookup(conn_handle_t handle, int reactor) {
+	conn_slot_t* slot = slot_map_get(&g_conn_slots, HANDLE_ID(handle));
+	if (!slot || atomic_load_explicit(&slot->owner, memory_order_relaxed) != reactor)
+		return NULL;
+	if (atomic_load_explicit(&slot->gen, memory_order_relaxed) != HANDLE_GEN(handle))
+		return NULL;
+	return slot->conn;
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include "ebr.h"
+#include "log.h"
+
+/* EBR에 참여할 수 있는 최대 스레드 수 */
+#define EBR_MAX_THREADS 64
+
+/* state의 최하위 비트 : 읽기 구간 안에 있음 */
+#define EBR_ACTIVE 1u
+
+/*
+* 스레드별 EBR 기록
+* state는 (읽기 구간에 들어갈 때 본 전역 epoch << 1) | EBR_ACTIVE 이며, epoch를 올리려는 스레드만 읽음
+* retire 목록은 소유 스레드만 다루며 retire 순서대로(epoch 오름차순) 쌓임
+*/
+typedef struct {
+	_Alignas(64) atomic_uint state;
+	ebr_node_t* head;
+	ebr_node_t* tail;
+	int pending;
+} ebr_thread_t;
+
+static atomic_uint global_epoch;
+static ebr_thread_t* threads[EBR_MAX_THREADS];
+static atomic_int thread_count;
+
+static __thread ebr_thread_t* t_ebr;
+static __thread bool t_ebr_failed;
+
+/* 현재 스레드의 EBR 기록을 처음 사용할 때 만들어 등록하는 함수 */
+static ebr_thread_t* ebr_register(void) {
+	if (t_ebr_failed)
+		return NULL;
+
+	int id = atomic_fetch_add(&thread_count, 1);
+	ebr_thread_t* t = (id < EBR_MAX_THREADS) ? aligned_alloc(64, sizeof(ebr_thread_t)) : NULL;
+	if (!t) {
+		t_ebr_failed = true;
+		LOG_ERROR("[EBR] thread registration failed id=%d", id);
+		return NULL;
+	}
+
+	atomic_init(&t->state, 0);
+	t->head = NULL;
+	t->tail = NULL;
+	t->pending = 0;
+
+	__atomic_store_n(&threads[id], t, __ATOMIC_RELEASE);
+	t_ebr = t;
+	return t;
+}
+
+static inline ebr_thread_t* ebr_local(void) {
+	return t_ebr ? t_ebr : ebr_register();
+}
+
+/*
+* 읽기 구간 시작
+* 본 epoch를 먼저 알리고 나서(seq_cst fence) 공유 포인터를 읽어야, 그 포인터가 두 epoch 안에 해제되지 않음
+*/
+void ebr_enter(void) {
+	ebr_thread_t* t = ebr_local();
+	if (!t)
+		return;
+
+	unsigned e = atomic_load_explicit(&global_epoch, memory_order_relaxed);
+	atomic_store_explicit(&t->state, (e << 1) | EBR_ACTIVE, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+}
+
+/*
+* 읽기 구간 안의 모든 스레드가 현재 epoch를 본 뒤라면 전역 epoch를 하나 올리는 함수
+* 이전 epoch에 들어온 채 아직 나가지 않은 스레드가 있으면 올리지 않음
+*/
+static unsigned ebr_try_advance(void) {
+	unsigned e = atomic_load_explicit(&global_epoch, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+
+	int n = atomic_load_explicit(&thread_count, memory_order_acquire);
+	if (n > EBR_MAX_THREADS)
+		n = EBR_MAX_THREADS;
+
+	for (int i = 0; i < n; ++i) {
+		ebr_thread_t* t = __atomic_load_n(&threads[i], __ATOMIC_ACQUIRE);
+		if (!t)
+			continue;
+		unsigned s = atomic_load_explicit(&t->state, memory_order_relaxed);
+		if ((s & EBR_ACTIVE) && (s >> 1) != (e & (~0u >> 1)))
+			return e;
+	}
+
+	if (atomic_compare_exchange_strong(&global_epoch, &e, e + 1))
+		return e + 1;
+	return e;
+}
+
+/* retire 목록 앞쪽에서 두 epoch 이상 지난 노드들을 해제하는 함수 */
+static void ebr_collect(ebr_thread_t* t) {
+	unsigned e = ebr_try_advance();
+
+	while (t->head && (int)(e - t->head->epoch) >= 2) {
+		ebr_node_t* node = t->head;
+		t->head = node->next;
+		t->pending--;
+		node->free_fn(node);
+	}
+
+	if (!t->head)
+		t->tail = NULL;
+}
+
+/* 읽기 구간 끝, retire해 둔 노드가 있으면 이번에 해제할 수 있는 만큼 정리함 */
+void ebr_exit(void) {
+	ebr_thread_t* t = t_ebr;
+	if (!t)
+		return;
+
+	atomic_store_explicit(&t->state, 0, memory_order_release);
+	if (t->pending > 0)
+		ebr_collect(t);
+}
+
+void ebr_retire(ebr_node_t* node, void (*free_fn)(ebr_node_t*)) {
+	ebr_thread_t* t = ebr_local();
+
+	/* 기록을 받지 못한 스레드는 회수를 미룰 수 없으므로 읽는 쪽과 겹치지 않는다고 보고 바로 해제 */
+	if (!t) {
+		free_fn(node);
+		return;
+	}
+
+	node->next = NULL;
+	node->epoch = atomic_load_explicit(&global_epoch, memory_order_acquire);
+	node->free_fn = free_fn;
+
+	if (t->tail)
+		t->tail->next = node;
+	else
+		t->head = node;
+	t->tail = node;
+	t->pending++;
+
+	ebr_collect(t);
+}
@@ -0,0 +1,27 @@
+#ifndef EBR_H
+#define EBR_H
+
+#include "common.h"
+
+/*
+* epoch 기반 메모리 회수 (EBR)
+* 여러 스레드가 락 없이 읽는 객체를 테이블에서 뺀 뒤 바로 free하지 않고 retire 목록에 넣어 두었다가,
+* 그 객체를 보고 있었을 수 있는 모든 읽기 구간이 끝난 뒤(전역 epoch가 두 번 넘어간 뒤) 해제함
+*
+* 읽는 쪽 : ebr_enter() ~ ebr_exit() 사이에서만 공유 포인터를 읽고 사용함
+* 지우는 쪽 : 포인터를 테이블에서 먼저 지운 뒤 ebr_retire()로 넘김
+*/
+
+typedef struct ebr_node {
+	struct ebr_node* next;
+	unsigned epoch;							// retire 시점의 전역 epoch
+	void (*free_fn)(struct ebr_node*);
+} ebr_node_t;
+
+void ebr_enter(void);
+void ebr_exit(void);
+
+/* 현재 스레드의 retire 목록에 넣고, 해제해도 되는 노드들을 정리함 */
+void ebr_retire(ebr_node_t* node, void (*free_fn)(ebr_node_t*));
+
+#endif
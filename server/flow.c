@@ -0,0 +1,181 @@
+#include "flow.h"
+#include "logic.h"
+#include "packet_pool.h"
+#include "metrics.h"
+#include "log.h"
+#include "rate_limit.h"
+
+int handle_list_push(handle_list_t* l, conn_handle_t h) {
+	if (l->count == l->cap) {
+		int cap = l->cap ? l->cap * 2 : 64;
+		conn_handle_t* items = realloc(l->items, sizeof(conn_handle_t) * (size_t)cap);
+		if (!items)
+			return -1;
+		l->items = items;
+		l->cap = cap;
+	}
+
+	l->items[l->count++] = h;
+	return 0;
+}
+
+/* 보류 목록 뒤에 패킷을 붙이는 함수 */
+static void stall(connection_t* conn, packet_t* pkt) {
+	pkt->next = NULL;
+	if (conn->stalled_tail)
+		conn->stalled_tail->next = pkt;
+	else
+		conn->stalled_head = pkt;
+	conn->stalled_tail = pkt;
+}
+
+flow_rc_t flow_deliver(connection_t* conn, packet_t* pkt, bool heavy) {
+	if (conn->paused) {
+		stall(conn, pkt);
+		return FLOW_OK;
+	}
+
+	switch (rate_limit_check(conn, pkt->type, monotonic_ms())) {
+	case RL_PASS:
+		pkt->charged = 1;
+		break;
+	case RL_DROP:
+		packet_free(pkt);
+		return FLOW_OK;
+	case RL_DELAY:
+		stall(conn, pkt);
+		conn->paused_by_queue = false;
+		return FLOW_PAUSE;
+	default:
+		packet_free(pkt);
+		return FLOW_DISCONNECT;
+	}
+
+	jobq_push_t rc = job_queue_try_push_packet(logic_queue_for(conn->handle), conn->handle, pkt);
+	if (rc == JOBQ_FULL) {
+		stall(conn, pkt);
+		conn->paused_by_queue = true;
+		return FLOW_PAUSE;
+	}
+
+	if (rc == JOBQ_CONGESTED && heavy) {
+		conn->paused_by_queue = true;
+		return FLOW_PAUSE;
+	}
+	return FLOW_OK;
+}
+
+int flow_pause(flow_t* f, connection_t* conn) {
+	if (handle_list_push(&f->paused, conn->handle) < 0)
+		return -1;
+
+	conn->paused = true;
+	metric_inc(MC_READS_PAUSED);
+	return 0;
+}
+
+/* 보류 목록 맨 앞 패킷을 빼는 함수 */
+static void unstall(connection_t* conn, packet_t* next) {
+	conn->stalled_head = next;
+	if (!next)
+		conn->stalled_tail = NULL;
+}
+
+int flow_try_resume(connection_t* conn) {
+	uint64_t now = monotonic_ms();
+	if (conn->throttled_until > now)
+		return 0;
+
+	/*
+	* 큐 적체로 멈춘 연결만 LOW 이하까지 기다림 (HIGH 근처에서 멈춤과 재개를 반복하지 않게 함)
+	* 속도 제한 지연으로 멈춘 연결은 지연 시각이 지나면 바로 넣어 보며, 큐가 HIGH 이상이면 넣기가 거절되어 큐 적체로 바뀜
+	*/
+	job_queue_t* q = logic_queue_for(conn->handle);
+	if (conn->paused_by_queue && job_queue_depth(q) > LOGIC_Q_LOW_WATERMARK)
+		return 0;
+
+	while (conn->stalled_head) {
+		/* 큐에 넣은 뒤에는 worker가 곧바로 해제하며 next를 덮어쓸 수 있으므로 다음 패킷을 먼저 읽어 둠 */
+		packet_t* pkt = conn->stalled_head;
+		packet_t* next = pkt->next;
+
+		/*
+		* 속도 제한으로 지연됐거나 읽기를 멈춘 뒤 들어온 패킷만 검사함
+		* 통과한 뒤 큐가 HIGH 이상이라 보류된 패킷은 이미 token을 썼으므로, 다시 검사하면 worker가 느린 것만으로 한도를 넘게 됨
+		*/
+		rl_action_t act = pkt->charged ? RL_PASS : rate_limit_check(conn, pkt->type, now);
+		if (act == RL_DELAY) {
+			conn->paused_by_queue = false;
+			return 0;
+		}
+		if (act != RL_PASS) {
+			unstall(conn, next);
+			packet_free(pkt);
+			if (act == RL_DISCONNECT)
+				return -1;
+			continue;
+		}
+		pkt->charged = 1;
+
+		jobq_push_t rc = job_queue_try_push_packet(q, conn->handle, pkt);
+		if (rc == JOBQ_FULL) {
+			conn->paused_by_queue = true;
+			return 0;
+		}
+
+		unstall(conn, next);
+		if (rc == JOBQ_CONGESTED) {
+			conn->paused_by_queue = true;
+			return 0;
+		}
+	}
+
+	conn->paused = conn->paused_by_queue = false;
+	metric_inc(MC_READS_RESUMED);
+	return 1;
+}
+
+void flow_drop_stalled(connection_t* conn) {
+	while (conn->stalled_head) {
+		packet_t* pkt = conn->stalled_head;
+		conn->stalled_head = pkt->next;
+		packet_free(pkt);
+	}
+	conn->stalled_tail = NULL;
+	conn->paused = conn->paused_by_queue = false;
+}
+
+void flow_notify_disconnect(flow_t* f, conn_handle_t handle) {
+	/* 앞서 미뤄둔 끊김이 있으면 순서를 지키기 위해 뒤에 붙임 */
+	if (f->pending_disc.count == 0 && job_queue_try_push_disconnect(logic_queue_for(handle), handle) != JOBQ_FULL)
+		return;
+
+	metric_inc(MC_DISCONNECTS_DEFERRED);
+	if (handle_list_push(&f->pending_disc, handle) < 0) {
+		/* 목록조차 늘릴 수 없으면 끊김 이벤트를 잃지 않도록 자리가 날 때까지 기다림 */
+		LOG_ERROR("disconnect backlog alloc failed, blocking on worker queue");
+		job_t job = { .type = JOB_DISCONNECT, .handle = handle };
+		job_queue_push(logic_queue_for(handle), &job);
+	}
+}
+
+void flow_retry(flow_t* f) {
+	int done = 0;
+	while (done < f->pending_disc.count) {
+		conn_handle_t h = f->pending_disc.items[done];
+		if (job_queue_try_push_disconnect(logic_queue_for(h), h) == JOBQ_FULL)
+			break;
+		done++;
+	}
+
+	if (done > 0) {
+		memmove(f->pending_disc.items, f->pending_disc.items + done, sizeof(conn_handle_t) * (size_t)(f->pending_disc.count - done));
+		f->pending_disc.count -= done;
+	}
+}
+
+void flow_destroy(flow_t* f) {
+	free(f->paused.items);
+	free(f->pending_disc.items);
+	memset(f, 0, sizeof(*f));
+}
@@ -0,0 +1,76 @@
+#ifndef FLOW_H
+#define FLOW_H
+
+#include "common.h"
+#include "job_queue.h"
+
+/*
+* net -> logic 흐름 제어
+* reactor는 worker 큐에 넣을 때 대기하지 않음 (대기하면 그 reactor의 모든 I/O가 멈추고,
+* io_q가 비기를 기다리는 worker와 서로를 기다리게 됨)
+* 대신 큐가 HIGH 이상인 worker로 패킷을 보내던 연결은 읽기를 멈추고,
+* 이미 파싱한 패킷은 연결의 보류 목록에 두었다가 큐가 LOW 이하로 비면 순서대로 넣은 뒤 다시 읽음
+* 끊김 이벤트는 버릴 수 없으므로 큐가 가득 차 있으면 reactor의 목록에 두었다가 다시 넣음
+*/
+
+/* 연결 handle 목록 (필요한 만큼 늘어남, reactor 전용) */
+typedef struct {
+	conn_handle_t* items;
+	int count;
+	int cap;
+} handle_list_t;
+
+typedef struct {
+	handle_list_t paused;			// 읽기를 멈춘 연결
+	handle_list_t pending_disc;		// worker 큐가 가득 차 아직 넣지 못한 끊김 이벤트
+} flow_t;
+
+int handle_list_push(handle_list_t* l, conn_handle_t h);
+
+/* flow_deliver 결과 */
+typedef enum {
+	FLOW_OK,				// 계속 읽음
+	FLOW_PAUSE,				// 읽기를 멈춰야 함
+	FLOW_DISCONNECT			// 수신 속도 제한(RL_DISCONNECT)으로 연결을 끊어야 함
+} flow_rc_t;
+
+/*
+* 파싱한 패킷을 연결의 home worker 큐에 넣는 함수
+* 넣기 전에 수신 속도 제한을 검사해, 한도를 넘은 패킷은 설정된 동작에 따라 버리거나 보류하거나 연결을 끊게 함
+* 읽기를 멈춘 연결이면 검사 없이 보류 목록 뒤에 붙이며, 보류한 패킷은 다시 넣을 때 검사함 (이미 통과한 패킷은 다시 검사하지 않음)
+* FLOW_PAUSE이면 호출자가 flow_pause로 등록한 뒤 연결의 읽기를 멈춤
+* 큐가 HIGH 이상이라 넣지 못했거나 속도 제한으로 지연할 때는 보류 목록에 두고 항상 멈춤
+* 넣은 패킷으로 HIGH에 닿았으면 heavy(최근 수신 예산을 다 쓴 연결)만 바로 멈추고, 가벼운 연결은 다음 패킷이 보류될 때 멈춤
+*/
+flow_rc_t flow_deliver(connection_t* conn, packet_t* pkt, bool heavy);
+
+/* 연결을 읽기를 멈춘 목록에 등록 (목록을 늘리지 못하면 -1, 다시 깨울 방법이 없으므로 호출자가 연결을 끊음) */
+int flow_pause(flow_t* f, connection_t* conn);
+
+/*
+* 읽기를 멈춘 연결을 다시 읽어도 되는지 확인하는 함수
+* 속도 제한 지연이 끝났고, 큐 적체로 멈춘 연결이면 home worker 큐가 LOW 이하일 때 보류 목록을 순서대로 검사해 넣음
+* (속도 제한 지연으로만 멈춘 연결은 큐 적재량과 관계없이 넣어 보며, HIGH 이상이면 넣기가 거절되어 큐 적체로 멈춘 것으로 바뀜)
+* 모두 넣었고 큐에 여유가 남아 있으면 1(다시 읽어도 됨), 아직 멈춰 둘 연결이면 0
+* 보류한 패킷이 RL_DISCONNECT 한도를 넘었으면 -1 (호출자가 연결을 끊음)
+*/
+int flow_try_resume(connection_t* conn);
+
+/* 닫히는 연결의 보류 패킷을 버리는 함수 */
+void flow_drop_stalled(connection_t* conn);
+
+/* 끊김 이벤트를 넣는 함수, 큐가 가득 차 있으면 목록에 두었다가 flow_retry에서 다시 넣음 */
+void flow_notify_disconnect(flow_t* f, conn_handle_t handle);
+
+/* 미뤄둔 끊김 이벤트를 다시 넣는 함수 */
+void flow_retry(flow_t* f);
+
+/* reactor 종료 시 목록 해제 */
+void flow_destroy(flow_t* f);
+
+/* 다시 확인할 일이 남아 있는지 (멈춘 연결이나 미뤄둔 끊김 이벤트) */
+static inline bool flow_pending(const flow_t* f) {
+	return f->paused.count > 0 || f->pending_disc.count > 0;
+}
+
+#endif
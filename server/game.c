@@ -0,0 +1,243 @@
+#include "game.h"
+#include "sbuf.h"
+#include "net.h"
+#include "metrics.h"
+#include "log.h"
+
+/* 결과 payload 최대 길이 (tick 번호 4바이트를 뺀 나머지) */
+#define GAME_RESULT_MAX (MAX_PACKET_SIZE - 4)
+
+/* 기본 relay 결과에서 입력 하나의 머리 : session_id(4) + 길이(2) */
+#define GAME_RELAY_HDR 6
+
+typedef struct game_room {
+	room_t* room;
+	int room_id;					// 시작할 때의 room_id (방이 닫히고 슬롯이 재사용됐는지 확인용)
+	timer_wheel_t* wheel;			// 방 소유 worker의 휠
+	wheel_timer_t timer;
+	void* state;					// 시뮬레이션의 방별 상태
+
+	int tick_hz;
+	uint64_t period_ns;
+	uint64_t due_ns;				// 다음 tick 예정 시각 (주기대로 쌓으므로 휠 tick 반올림 오차가 누적되지 않음)
+	uint64_t last_ns;				// 직전 tick을 실행한 시각
+	uint64_t last_input_ns;
+	uint32_t tick;
+
+	/* 이번 tick 입력 버퍼 (relay 머리를 포함한 크기가 결과 프레임 하나를 넘지 않게 받음) */
+	int input_count;
+	int input_bytes;
+	game_input_t inputs[GAME_INPUT_MAX];
+	char data[GAME_RESULT_MAX];
+} game_room_t;
+
+/* 입력마다 session_id, 길이, 내용을 도착 순서대로 이어 붙임 */
+static bool relay_tick(game_tick_t* t) {
+	for (int i = 0; i < t->input_count; ++i) {
+		const game_input_t* in = &t->inputs[i];
+		if (t->out_len + GAME_RELAY_HDR + in->len > t->out_cap)
+			break;
+
+		uint32_t sid = htonl((uint32_t)in->session_id);
+		uint16_t len = htons(in->len);
+		memcpy(t->out + t->out_len, &sid, 4);
+		memcpy(t->out + t->out_len + 4, &len, 2);
+		memcpy(t->out + t->out_len + GAME_RELAY_HDR, in->data, in->len);
+		t->out_len += GAME_RELAY_HDR + in->len;
+	}
+
+	return t->idle_ms < GAME_IDLE_STOP_MS;
+}
+
+static const game_sim_t relay_sim = { .tick = relay_tick };
+static const game_sim_t* g_sim = &relay_sim;
+
+void game_set_sim(const game_sim_t* sim) {
+	g_sim = sim ? sim : &relay_sim;
+}
+
+static void game_set_rate(game_room_t* g, int hz) {
+	if (hz < 1)
+		hz = 1;
+	if (hz > GAME_TICK_HZ_MAX)
+		hz = GAME_TICK_HZ_MAX;
+	g->tick_hz = hz;
+	g->period_ns = 1000000000ull / (uint64_t)hz;
+}
+
+/* 예정 시각(ns)을 올림한 ms로 휠에 걺 */
+static void game_arm(game_room_t* g) {
+	timer_arm(g->wheel, &g->timer, (g->due_ns + 999999) / 1000000);
+}
+
+/*
+* 결과를 PKT_GAME_RESULT 프레임 하나로 직렬화해 방 멤버 전체에 보내는 함수
+* room_broadcast와 같이 멤버 목록 참조를 reactor마다 한 번씩 넘기며, 보낸 사람도 결과를 받음
+* reactor 깨우기는 타이머를 처리한 worker 루프가 한 번에 함
+*/
+static void game_emit(game_room_t* g, const char* out, int len) {
+	member_set_t* members = g->room->members;
+	if (!members || members->count == 0)
+		return;
+
+	sbuf_t* frame = sbuf_alloc(4 + 4 + (uint32_t)len);
+	if (!frame)
+		return;
+
+	uint16_t net_len = htons((uint16_t)(2 + 4 + len));
+	uint16_t net_type = htons(PKT_GAME_RESULT);
+	uint32_t net_tick = htonl(g->tick);
+	memcpy(frame->data, &net_len, 2);
+	memcpy(frame->data + 2, &net_type, 2);
+	memcpy(frame->data + 4, &net_tick, 4);
+	memcpy(frame->data + 8, out, len);
+	frame->len = 8 + (uint32_t)len;
+	frame->ts_ns = monotonic_ns();
+
+	net_push_multicast(frame, members, HANDLE_NONE);
+	sbuf_release(frame);
+}
+
+/*
+* tick 타이머 만료
+* 예정 시각보다 늦은 정도를 jitter로 기록하고, 한 주기 이상 늦었으면 밀린 tick은 실행하지 않고 건너뜀
+* (밀린 tick을 몰아서 실행하면 과부하 중인 worker가 더 늦어지므로, 시뮬레이션은 dt_ms로 경과 시간을 반영함)
+*/
+static void game_tick_expired(void* arg) {
+	game_room_t* g = arg;
+	room_t* room = g->room;
+
+	if (room_get(g->room_id) != room) {
+		game_room_stop(room, g->wheel);
+		return;
+	}
+
+	static __thread char out[GAME_RESULT_MAX];
+	uint64_t now = monotonic_ns();
+	uint64_t late = (now > g->due_ns) ? now - g->due_ns : 0;
+	metric_record(MH_GAME_TICK_JITTER, late);
+
+	if (late >= g->period_ns) {
+		uint64_t skipped = late / g->period_ns;
+		metric_add(MC_GAME_TICKS_SKIPPED, skipped);
+		g->due_ns += skipped * g->period_ns;
+	}
+
+	g->tick++;
+	game_tick_t t = {
+		.room = room,
+		.state = g->state,
+		.tick = g->tick,
+		.dt_ms = (uint32_t)((now - g->last_ns) / 1000000),
+		.idle_ms = (uint32_t)((now - g->last_input_ns) / 1000000),
+		.inputs = g->inputs,
+		.input_count = g->input_count,
+		.out = out,
+		.out_cap = GAME_RESULT_MAX,
+		.out_len = 0,
+		.tick_hz = g->tick_hz,
+	};
+
+	bool keep = g_sim->tick(&t);
+	if (t.out_len > 0)
+		game_emit(g, out, t.out_len);
+
+	g->input_count = 0;
+	g->input_bytes = 0;
+	g->last_ns = now;
+	metric_inc(MC_GAME_TICKS);
+	metric_record(MH_GAME_TICK_RUN, monotonic_ns() - now);
+
+	if (!keep) {
+		game_room_stop(room, g->wheel);
+		return;
+	}
+
+	if (t.tick_hz != g->tick_hz)
+		game_set_rate(g, t.tick_hz);
+	g->due_ns += g->period_ns;
+	game_arm(g);
+}
+
+static game_room_t* game_start(room_t* room, timer_wheel_t* w) {
+	game_room_t* g = malloc(sizeof(game_room_t));
+	if (!g) {
+		LOG_ERROR("[GAME] state alloc failed room=%d", room->room_id);
+		return NULL;
+	}
+
+	g->room = room;
+	g->room_id = room->room_id;
+	g->wheel = w;
+	g->tick = 0;
+	g->input_count = 0;
+	g->input_bytes = 0;
+
+	int hz = (room->kind == ROOM_KIND_MATCH) ? GAME_TICK_HZ : GAME_TICK_HZ_CHANNEL;
+	g->state = g_sim->start ? g_sim->start(room, &hz) : NULL;
+	game_set_rate(g, hz);
+
+	/*
+	* 첫 tick은 시작 시각부터 한 주기 뒤의 휠 tick 경계에 맞춤 (주기가 TIMER_TICK_MS의 배수면 이후 tick도 경계에 놓여 반올림 지연이 없음)
+	* 방마다 첫 입력 시각이 다르므로 방들의 tick은 주기 안의 여러 휠 tick에 흩어짐
+	*/
+	uint64_t now = monotonic_ns();
+	uint64_t tick_ns = (uint64_t)TIMER_TICK_MS * 1000000;
+	g->last_ns = now;
+	g->last_input_ns = now;
+	g->due_ns = (now + g->period_ns + tick_ns - 1) / tick_ns * tick_ns;
+	timer_init(&g->timer, game_tick_expired, g);
+	game_arm(g);
+
+	room->game = g;
+	metric_inc(MC_GAME_ROOMS_STARTED);
+	LOG_INFO("[GAME] started room=%d hz=%d", room->room_id, g->tick_hz);
+	return g;
+}
+
+void game_room_input(room_t* room, timer_wheel_t* w, conn_handle_t handle, int session_id, const packet_t* pkt) {
+	if (!room || !pkt)
+		return;
+
+	game_room_t* g = room->game ? room->game : game_start(room, w);
+	if (!g)
+		return;
+
+	int len = (int)pkt->length - 2;
+	if (len < 0)
+		len = 0;
+
+	if (g->input_count >= GAME_INPUT_MAX || g->input_bytes + GAME_RELAY_HDR + len > GAME_RESULT_MAX) {
+		metric_inc(MC_GAME_ACTIONS_DROPPED);
+		return;
+	}
+
+	/* 내용은 버퍼에 이어 쓰고, 입력 목록은 그 위치를 가리킴 (머리 크기는 버퍼 예산에만 반영) */
+	int off = g->input_bytes - g->input_count * GAME_RELAY_HDR;
+	memcpy(g->data + off, pkt->payload, len);
+
+	game_input_t* in = &g->inputs[g->input_count++];
+	in->handle = handle;
+	in->session_id = session_id;
+	in->len = (uint16_t)len;
+	in->data = g->data + off;
+
+	g->input_bytes += GAME_RELAY_HDR + len;
+	g->last_input_ns = monotonic_ns();
+}
+
+void game_room_stop(room_t* room, timer_wheel_t* w) {
+	game_room_t* g = room ? room->game : NULL;
+	if (!g)
+		return;
+
+	timer_cancel(w, &g->timer);
+	if (g_sim->stop)
+		g_sim->stop(room, g->state);
+
+	metric_inc(MC_GAME_ROOMS_STOPPED);
+	LOG_INFO("[GAME] stopped room=%d ticks=%u", g->room_id, g->tick);
+
+	room->game = NULL;
+	free(g);
+}
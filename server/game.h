@@ -0,0 +1,62 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "common.h"
+#include "state.h"
+#include "timer_wheel.h"
+
+/*
+* 방별 고정 주기 게임 tick 엔진
+* PKT_GAME_ACTION은 방 소유 worker에서 방의 이번 tick 입력 버퍼에 쌓이고, 주기마다 시뮬레이션 콜백을 한 번 호출함
+* 콜백이 쓴 결과는 PKT_GAME_RESULT 프레임 하나로 직렬화해 방 멤버 목록과 함께 참조만 넘기므로, 수신자는 tick마다 프레임 하나만 받음
+* tick 타이머는 방 소유 worker(슬롯 번호 % worker 수)의 타이머 휠에 걸리므로 방들의 tick 부하는 방 배치를 따라 worker들에 나뉨
+* 방 상태와 마찬가지로 방 소유 worker만 접근하므로 락이 없음
+*
+* PKT_GAME_RESULT payload : tick 번호(4바이트, network order) + 시뮬레이션 결과
+*/
+
+/* tick 하나에 모인 입력 (도착 순서) */
+typedef struct game_input {
+	conn_handle_t handle;
+	int session_id;
+	uint16_t len;
+	const char* data;
+} game_input_t;
+
+/* 시뮬레이션 콜백에 넘기는 tick 정보 */
+typedef struct game_tick {
+	room_t* room;
+	void* state;					// start가 돌려준 방별 상태
+	uint32_t tick;					// 방에서 실행한 tick 번호 (1부터)
+	uint32_t dt_ms;					// 직전 tick 이후 경과 시간 (늦어서 건너뛴 tick이 있으면 그만큼 김)
+	uint32_t idle_ms;				// 마지막 입력 이후 경과 시간
+	const game_input_t* inputs;
+	int input_count;
+	char* out;						// 결과를 쓸 곳 (PKT_GAME_RESULT의 tick 번호 뒤)
+	int out_cap;
+	int out_len;					// 콜백이 쓴 길이, 0이면 이번 tick은 보내지 않음
+	int tick_hz;					// 다음 tick부터 쓸 주기, 콜백이 바꿀 수 있음
+} game_tick_t;
+
+/*
+* 시뮬레이션 콜백 (start / stop은 NULL이어도 됨)
+* start : 방에 첫 입력이 와서 게임이 시작될 때, 방별 상태를 돌려주고 *tick_hz(방 종류별 기본값)로 주기를 정함
+* tick  : 주기마다 호출, false를 반환하면 tick을 멈추고 다음 입력에서 다시 시작함
+* stop  : tick이 멈추거나 방이 비었을 때
+*/
+typedef struct game_sim {
+	void* (*start)(room_t* room, int* tick_hz);
+	bool (*tick)(game_tick_t* t);
+	void (*stop)(room_t* room, void* state);
+} game_sim_t;
+
+/* 시뮬레이션 교체 (worker 시작 전에 호출, NULL이면 입력을 그대로 모아 보내는 기본 relay) */
+void game_set_sim(const game_sim_t* sim);
+
+/* 방 소유 worker 전용 : 입력을 이번 tick 버퍼에 넣음 (진행 중이 아니면 w에 tick을 걸어 시작) */
+void game_room_input(room_t* room, timer_wheel_t* w, conn_handle_t handle, int session_id, const packet_t* pkt);
+
+/* 방 소유 worker 전용 : tick을 멈추고 게임 상태 해제 (진행 중이 아니면 무시) */
+void game_room_stop(room_t* room, timer_wheel_t* w);
+
+#endif
@@ -0,0 +1,108 @@
+#include "io_buf.h"
+#include "metrics.h"
+
+/* size class별 블록 크기 */
+static const size_t class_size[IO_BUF_CLASSES] = { RECV_BUF_SIZE, IO_BUF_SEND_SIZE };
+
+/* 스레드 로컬 캐시 한도와, 전역 저장소와 한 번에 주고받는 묶음 크기 */
+#define IO_BUF_CACHE_MAX 64
+#define IO_BUF_BATCH 16
+
+/* 비어 있는 블록은 앞부분을 목록 연결에 사용함 */
+typedef struct io_buf_node {
+	struct io_buf_node* next;
+} io_buf_node_t;
+
+/*
+* 전역 저장소
+* 블록은 대부분 그 연결을 담당한 reactor 안에서 빌리고 돌려주므로, 캐시가 넘치거나 빌 때만 사용함
+*/
+typedef struct {
+	io_buf_node_t* head;
+	int count;
+	pthread_mutex_t lock;
+} io_buf_depot_t;
+
+static io_buf_depot_t depot[IO_BUF_CLASSES] = {
+	{ NULL, 0, PTHREAD_MUTEX_INITIALIZER },
+	{ NULL, 0, PTHREAD_MUTEX_INITIALIZER },
+};
+
+/* 스레드 로컬 캐시 (락 없이 접근) */
+typedef struct {
+	io_buf_node_t* head;
+	int count;
+} io_buf_cache_t;
+
+static __thread io_buf_cache_t cache[IO_BUF_CLASSES];
+
+/* 전역 저장소에서 최대 IO_BUF_BATCH개를 로컬 캐시로 가져오는 함수 */
+static void cache_refill(int c) {
+	io_buf_depot_t* d = &depot[c];
+
+	pthread_mutex_lock(&d->lock);
+	for (int i = 0; i < IO_BUF_BATCH && d->head; ++i) {
+		io_buf_node_t* n = d->head;
+		d->head = n->next;
+		d->count--;
+
+		n->next = cache[c].head;
+		cache[c].head = n;
+		cache[c].count++;
+	}
+	pthread_mutex_unlock(&d->lock);
+}
+
+/* 로컬 캐시에서 IO_BUF_BATCH개를 전역 저장소로 반납하는 함수 */
+static void cache_flush(int c) {
+	io_buf_depot_t* d = &depot[c];
+
+	pthread_mutex_lock(&d->lock);
+	for (int i = 0; i < IO_BUF_BATCH && cache[c].head; ++i) {
+		io_buf_node_t* n = cache[c].head;
+		cache[c].head = n->next;
+		cache[c].count--;
+
+		n->next = d->head;
+		d->head = n;
+		d->count++;
+	}
+	pthread_mutex_unlock(&d->lock);
+}
+
+/* 블록 하나를 빌리는 함수 (내용은 초기화하지 않음), 실패 시 NULL */
+void* io_buf_get(io_buf_class_t c) {
+	if (!cache[c].head)
+		cache_refill(c);
+
+	io_buf_node_t* n = cache[c].head;
+	if (n) {
+		cache[c].head = n->next;
+		cache[c].count--;
+	}
+	else {
+		n = malloc(class_size[c]);
+		if (!n)
+			return NULL;
+		metric_add(MC_IO_BUF_ALLOCATED, class_size[c]);
+	}
+
+	metric_add(MC_IO_BUF_ACQUIRED, class_size[c]);
+	return n;
+}
+
+/* 블록을 현재 스레드의 캐시로 돌려주는 함수, 캐시가 넘치면 일부를 전역 저장소로 보냄 */
+void io_buf_put(io_buf_class_t c, void* buf) {
+	if (!buf)
+		return;
+
+	io_buf_node_t* n = buf;
+	n->next = cache[c].head;
+	cache[c].head = n;
+	cache[c].count++;
+
+	metric_add(MC_IO_BUF_RELEASED, class_size[c]);
+
+	if (cache[c].count > IO_BUF_CACHE_MAX)
+		cache_flush(c);
+}
@@ -0,0 +1,24 @@
+#ifndef IO_BUF_H
+#define IO_BUF_H
+
+#include "common.h"
+
+/*
+* 연결 I/O 버퍼 풀
+* 수신 버퍼와 송신 큐 chunk를 연결마다 붙박이로 두지 않고, 데이터가 오가는 동안만 이 풀에서 빌려 씀
+* 즉 쉬고 있는 연결은 버퍼를 하나도 들고 있지 않음
+* 블록은 size class별 스레드 로컬 캐시 -> 전역 저장소 -> malloc 순서로 확보함 (packet_pool과 같은 구조)
+* 연결이 빌려 간 바이트 수는 io_buffer_bytes_held 지표로 확인할 수 있음
+*/
+typedef enum {
+	IO_BUF_RECV,					// 수신 버퍼 (RECV_BUF_SIZE)
+	IO_BUF_SEND,					// 송신 큐 chunk, io_uring 송신 인자 (IO_BUF_SEND_SIZE)
+	IO_BUF_CLASSES
+} io_buf_class_t;
+
+#define IO_BUF_SEND_SIZE 1024
+
+void* io_buf_get(io_buf_class_t c);
+void io_buf_put(io_buf_class_t c, void* buf);
+
+#endif
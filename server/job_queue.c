@@ -1,46 +1,106 @@
 #include "job_queue.h"
 
 /*
-*   ۾(job_t)    ũ circular queue
-* producer / consumer  
-* producer: job_queue_push() ۾ 
-* consumer: job_queue_pop() ۾ 
+* 스레드 간 작업(job_t) 전달을 위한 고정 크기의 circular queue
+* producer / consumer 패턴으로 구현
+* producer: job_queue_push()로 작업을 넣음
+* consumer: job_queue_pop()으로 작업을 꺼냄
 */
 
-/* ť ʱȭ Լ */
+/* 큐 초기화 함수 */
 void job_queue_init(job_queue_t* q) {
-	q->head = q->tail = q->count = 0;
+	q->head = q->tail = q->count = q->hwm = q->parked = 0;
+	atomic_init(&q->congested, false);
 	pthread_mutex_init(&q->mutex, NULL);
-	pthread_cond_init(&q->cond, NULL);
+
+	/* job_queue_pop_timed의 대기 기한은 단조 시계 기준 (시스템 시각이 바뀌어도 타이머가 밀리지 않게 함) */
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&q->cond, &attr);
+	pthread_condattr_destroy(&attr);
 }
 
-/* job ϳ pushϴ Լ */
+/* job 하나를 push하는 함수 */
 void job_queue_push(job_queue_t *q, job_t* job) {
 	
-	/*  mutex ȣ */
+	/* 연산은 mutex로 보호됨 */
 	pthread_mutex_lock(&q->mutex);
 
-	/* ť       */
+	/* 큐가 가득 차면 공간이 생길 때까지 대기 */
 	while(q->count == JOB_QUEUE_SIZE) 
 		pthread_cond_wait(&q->cond, &q->mutex);
 
-	/* push , circular queue̹Ƿ moular  push */
+	/* push 진행, circular queue이므로 moular 연산으로 push가 진행됨*/
 	q->jobs[q->tail] = *job;
 	q->tail = (q->tail + 1) % JOB_QUEUE_SIZE;
-	q->count++;
+	__atomic_store_n(&q->count, q->count + 1, __ATOMIC_SEQ_CST);
+	if (q->count > q->hwm)
+		q->hwm = q->count;
 
-	/* consumer    Ƿ  */
+	/* consumer가 대기 중일 수 있으므로 깨움 */
 	pthread_cond_signal(&q->cond);
 	pthread_mutex_unlock(&q->mutex);
 }
 
-/* job ϳ popϴ Լ */
+/*
+* job 하나를 대기 없이 push하는 함수 (적재량이 limit 이상이면 넣지 않음)
+* 넣지 못하면 JOBQ_FULL, 넣은 뒤 적재량이 HIGH 이상이면 JOBQ_CONGESTED 반환
+* 두 경우 모두 congested를 올려, worker가 LOW 이하로 비운 시점에 reactor를 깨우게 함
+*/
+static jobq_push_t try_push_below(job_queue_t* q, job_t* job, int limit) {
+	jobq_push_t rc = JOBQ_OK;
+
+	pthread_mutex_lock(&q->mutex);
+
+	if (q->count == JOB_QUEUE_SIZE || job_queue_depth(q) >= limit) {
+		rc = JOBQ_FULL;
+	}
+	else {
+		q->jobs[q->tail] = *job;
+		q->tail = (q->tail + 1) % JOB_QUEUE_SIZE;
+		__atomic_store_n(&q->count, q->count + 1, __ATOMIC_SEQ_CST);
+		if (q->count > q->hwm)
+			q->hwm = q->count;
+		if (job_queue_depth(q) >= LOGIC_Q_HIGH_WATERMARK)
+			rc = JOBQ_CONGESTED;
+
+		pthread_cond_signal(&q->cond);
+	}
+
+	pthread_mutex_unlock(&q->mutex);
+
+	if (rc != JOBQ_OK)
+		atomic_store(&q->congested, true);
+	return rc;
+}
+
+/*
+* job 하나를 대기 없이 push하는 함수 (끊김 이벤트 / worker 사이의 방 작업)
+* 가득 찰 때까지 넣으므로 패킷이 멈춘 HIGH 이상의 여유도 씀
+*/
+jobq_push_t job_queue_try_push(job_queue_t* q, job_t* job) {
+	return try_push_below(q, job, JOB_QUEUE_SIZE);
+}
+
+/* 맨 앞 job을 꺼내는 함수 (mutex를 잡은 상태에서 호출) */
+static void take(job_queue_t* q, job_t* out) {
+	/* pop 진행, circular queue이므로 moular 연산으로 pop이 진행됨*/
+	*out = q->jobs[q->head];
+	q->head = (q->head + 1) % JOB_QUEUE_SIZE;
+	__atomic_store_n(&q->count, q->count - 1, __ATOMIC_SEQ_CST);
+
+	/* producer가 가득 차 있어 대기 중일 수 있으므로 깨움 */
+	pthread_cond_signal(&q->cond);
+}
+
+/* job 하나를 pop하는 함수 */
 int job_queue_pop(job_queue_t* q, job_t* out, jobq_mode_t mode) {
 	
-	/*  mutex ȣ */
+	/* 연산은 mutex로 보호됨 */
 	pthread_mutex_lock(&q->mutex);
 
-	/* ť  mode  BLOCK Ǵ  ȯ */
+	/* 큐가 비어있으면 mode에 따라 BLOCK 또는 즉시 반환 */
 	while (q->count == 0) {
 		if (mode == JOBQ_NONBLOCK) {
 			pthread_mutex_unlock(&q->mutex);
@@ -49,36 +109,180 @@ int job_queue_pop(job_queue_t* q, job_t* out, jobq_mode_t mode) {
 		pthread_cond_wait(&q->cond, &q->mutex);
 	}
 
-	/* pop , circular queue̹Ƿ moular  pop */
-	*out = q->jobs[q->head];
-	q->head = (q->head + 1) % JOB_QUEUE_SIZE;
-	q->count--;
+	take(q, out);
+	pthread_mutex_unlock(&q->mutex);
+
+	return 1;
+}
+
+/*
+* job 하나를 최대 timeout_ms 동안 기다려 pop하는 함수 (timeout_ms < 0이면 들어올 때까지 대기)
+* 시간 안에 들어오지 않으면 0 반환 (worker가 다음 타이머 만료 시각까지만 기다릴 때 사용)
+*/
+int job_queue_pop_timed(job_queue_t* q, job_t* out, int timeout_ms) {
+	if (timeout_ms < 0)
+		return job_queue_pop(q, out, JOBQ_BLOCK);
+
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += timeout_ms / 1000;
+	deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&q->mutex);
+
+	while (q->count == 0) {
+		if (pthread_cond_timedwait(&q->cond, &q->mutex, &deadline) == ETIMEDOUT && q->count == 0) {
+			pthread_mutex_unlock(&q->mutex);
+			return 0;
+		}
+	}
 
-	/* producer   ־    Ƿ  */
-	pthread_cond_signal(&q->cond);1
+	take(q, out);
 	pthread_mutex_unlock(&q->mutex);
 
 	return 1;
 }
 
-/* =======================  helper Լ ======================= */
-/* job ŸԺ ʼ ʵ尡 ٸǷ,  Ģ    */
-/* , job_t   ٲ(ʵ ߰/ʱȭ Ģ ) helper ϸ  */
+/*
+* 현재 적재량 (락 없이 읽는 근사값)
+* worker가 넘기지 못하고 들고 있는 방 작업도 더해, 그 worker로 패킷을 보내던 연결의 읽기를 멈추게 함
+* (큐만 보면 worker는 계속 비워 가므로 들고 있는 작업이 끝없이 늘어날 수 있음)
+*/
+int job_queue_depth(job_queue_t* q) {
+	return __atomic_load_n(&q->count, __ATOMIC_SEQ_CST) + __atomic_load_n(&q->parked, __ATOMIC_SEQ_CST);
+}
 
-/* Ŷ  ̺Ʈ job (JOB_PACKET)  ť  */
-void job_queue_push_packet(job_queue_t* q, int fd, packet_t* pkt) {
-	job_t job = {.type = JOB_PACKET, .fd = fd, .packet = *pkt };
-	job_queue_push(q, &job);
+/* 큐의 worker가 들고 있는 방 작업 수를 바꾸는 함수 (그 worker 전용) */
+void job_queue_park(job_queue_t* q, int delta) {
+	__atomic_add_fetch(&q->parked, delta, __ATOMIC_SEQ_CST);
 }
 
-/*   ̺Ʈ job (JOB_DISCONNECT)  ť  */
-void job_queue_push_disconnect(job_queue_t* q, int fd) {
-	job_t job = { .type = JOB_DISCONNECT,.fd = fd };
-	job_queue_push(q, &job);
+/*
+* worker가 pop한 뒤 호출하는 함수
+* reactor가 읽기를 멈춘 큐가 LOW 이하로 비었으면 congested를 내리고 true를 반환하며, 호출자는 reactor를 깨워야 함
+* reactor는 멈춘 뒤 적재량을 직접 다시 확인하므로, 그 사이에 이미 비워진 경우도 놓치지 않음
+*/
+bool job_queue_uncongest(job_queue_t* q) {
+	if (!atomic_load(&q->congested))
+		return false;
+	if (job_queue_depth(q) > LOGIC_Q_LOW_WATERMARK)
+		return false;
+	return atomic_exchange(&q->congested, false);
 }
 
-/*   û job (JOB_SHUTDOWN)  ť  */
+/* ======================= 이하 helper 함수 ======================= */
+/* job 타입별로 필수 필드가 다르므로, 생성 규칙을 한 곳에 모음 */
+/* 또한, job_t의 내부 구조가 바뀌어도(필드 추가/초기화 규칙 변경) helper만 수정하면 됨 */
+
+/*
+* 패킷 수신 이벤트를 job 형태(JOB_PACKET)로 만들어 대기 없이 큐에 삽입 (JOBQ_FULL이면 패킷 소유권은 호출자에게 남음)
+* 적재량이 HIGH 이상이면 연결과 관계없이 넣지 않아, HIGH부터 가득 찰 때까지는 끊김 이벤트와 방 작업만 들어감
+*/
+jobq_push_t job_queue_try_push_packet(job_queue_t* q, conn_handle_t handle, packet_t* pkt) {
+	job_t job = {.type = JOB_PACKET, .handle = handle, .packet = pkt };
+	return try_push_below(q, &job, LOGIC_Q_HIGH_WATERMARK);
+}
+
+/* 연결 종료 이벤트를 job 형태(JOB_DISCONNECT)로 만들어 대기 없이 큐에 삽입 */
+jobq_push_t job_queue_try_push_disconnect(job_queue_t* q, conn_handle_t handle) {
+	job_t job = { .type = JOB_DISCONNECT,.handle = handle };
+	return job_queue_try_push(q, &job);
+}
+
+/* 서버 종료 요청을 job 형태(JOB_SHUTDOWN)로 만들어 큐에 삽입 */
 void job_queue_push_shutdown(job_queue_t* q) {
 	job_t job = { .type = JOB_SHUTDOWN };
 	job_queue_push(q, &job);
 }
+
+/* ======================= MPSC lock-free ring ======================= */
+/*
+* 슬롯 seq 규칙 (pos는 단조 증가하는 위치, 실제 인덱스는 pos % JOB_QUEUE_SIZE)
+* seq == pos                      : 비어 있어 pos 위치의 생산자가 쓸 수 있음
+* seq == pos + 1                  : pos 위치의 작업이 채워져 소비자가 읽을 수 있음
+* seq == pos + JOB_QUEUE_SIZE     : 소비 완료, 다음 바퀴의 생산자가 쓸 수 있음
+*/
+_Static_assert((JOB_QUEUE_SIZE & (JOB_QUEUE_SIZE - 1)) == 0, "JOB_QUEUE_SIZE must be a power of two");
+
+#define MPSC_MASK (JOB_QUEUE_SIZE - 1)
+
+/* ring 초기화 함수 */
+void mpsc_queue_init(mpsc_queue_t* q) {
+	for (size_t i = 0; i < JOB_QUEUE_SIZE; ++i)
+		atomic_init(&q->slots[i].seq, i);
+	atomic_init(&q->tail, 0);
+	q->head = 0;
+	q->hwm = 0;
+}
+
+/*
+* job 하나를 push하는 함수 (여러 생산자가 동시에 호출 가능)
+* ring이 가득 차 있으면 대기하지 않고 false 반환, 재시도 정책은 호출자가 결정
+*/
+bool mpsc_queue_try_push(mpsc_queue_t* q, const job_t* job) {
+	size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+	for (;;) {
+		mpsc_slot_t* slot = &q->slots[pos & MPSC_MASK];
+		size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+		intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+		if (diff == 0) {
+			/* 빈 슬롯이므로 위치 예약 시도, 실패하면 pos가 최신 tail로 갱신됨 */
+			if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+				memory_order_relaxed, memory_order_relaxed))
+			{
+				slot->job = *job;
+				atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+				return true;
+			}
+		}
+		else if (diff < 0) {
+			/* 소비자가 아직 이전 바퀴의 작업을 꺼내지 않음 -> 가득 참 */
+			return false;
+		}
+		else {
+			/* 다른 생산자가 먼저 예약함 */
+			pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+		}
+	}
+}
+
+/*
+* 최대 max개의 job을 한 번에 pop하는 함수 (소비자 전용)
+* 꺼낸 job 개수를 반환하며, 비어 있으면 0 반환
+*/
+int mpsc_queue_pop_batch(mpsc_queue_t* q, job_t* out, int max) {
+	int n = 0;
+
+	/* 꺼내기 전 적재량으로 최고치 갱신 (예약만 되고 아직 쓰는 중인 슬롯도 포함) */
+	size_t depth = atomic_load_explicit(&q->tail, memory_order_relaxed) - q->head;
+	if (depth > q->hwm)
+		__atomic_store_n(&q->hwm, depth, __ATOMIC_RELAXED);
+
+	while (n < max) {
+		mpsc_slot_t* slot = &q->slots[q->head & MPSC_MASK];
+		size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+		/* 아직 채워지지 않았거나(예약 후 쓰는 중 포함) 비어 있음 */
+		if (seq != q->head + 1)
+			break;
+
+		out[n++] = slot->job;
+		atomic_store_explicit(&slot->seq, q->head + JOB_QUEUE_SIZE, memory_order_release);
+		q->head++;
+	}
+
+	return n;
+}
+
+/* 현재 적재량 (다른 스레드에서 지표용으로 읽는 근사값) */
+size_t mpsc_queue_depth(mpsc_queue_t* q) {
+	size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+	size_t head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+	return (tail > head) ? tail - head : 0;
+}
@@ -8,7 +8,13 @@ typedef enum {
 	JOB_PACKET,
 	JOB_DISCONNECT,
 	JOB_SHUTDOWN,
-	JOB_SEND
+	JOB_SEND,
+	JOB_MULTICAST,		// 방 멤버 목록 참조를 받아 reactor가 담당 fd들에게 전송
+	JOB_ROOM_JOIN,		// home worker -> 방 소유 worker
+	JOB_ROOM_LEAVE,		// home worker -> 방 소유 worker
+	JOB_ROOM_CHAT,		// home worker -> 방 소유 worker
+	JOB_ROOM_GAME,		// home worker -> 방 소유 worker, 게임 입력
+	JOB_CLOSE			// worker -> 담당 reactor, 연결을 끊도록 요청
 } job_type_t;
 
 typedef enum {
@@ -18,8 +24,13 @@ typedef enum {
 
 typedef struct {
 	job_type_t type;
-	int fd;
-	packet_t packet;
+	int reason;			// JOB_CLOSE 전용, 끊는 이유 (disc_reason_t)
+	conn_handle_t handle;	// 대상 연결 (JOB_MULTICAST에서는 제외할 송신자)
+	int session_id;		// JOB_ROOM_* 전용
+	int room_id;		// JOB_ROOM_* 전용
+	struct sbuf* buf;	// JOB_SEND / JOB_MULTICAST 전용, 직렬화된 프레임 참조
+	struct member_set* members;	// JOB_MULTICAST 전용, 수신 대상 목록 참조
+	packet_t* packet;	// JOB_PACKET / JOB_ROOM_CHAT / JOB_ROOM_GAME 전용, 풀 버퍼 소유권을 함께 넘김
 } job_t;
 
 typedef struct {
@@ -27,16 +38,53 @@ typedef struct {
 	int head;
 	int tail;
 	int count;
+	int hwm;			// count의 최고치 (지표용)
+	int parked;			// 이 큐의 worker가 방 소유 worker 큐가 가득 차 들고 있는 방 작업 수 (적재량에 포함)
+	atomic_bool congested;	// reactor가 HIGH 이상을 보고 읽기를 멈춤, LOW 이하가 되면 worker가 내리고 reactor를 깨움
 	pthread_mutex_t mutex;
 	pthread_cond_t cond;
 } job_queue_t;
 
+/*
+* 다중 생산자 / 단일 소비자(MPSC) lock-free ring
+* logic -> net 방향(reactor별 io_q) 전용으로, 생산자는 여러 worker, 소비자는 reactor 하나
+* 각 슬롯의 seq 값으로 슬롯 상태(비었음/채워짐)를 표시하여 mutex 없이 동작함
+*/
+typedef struct {
+	atomic_size_t seq;
+	job_t job;
+} mpsc_slot_t;
+
+typedef struct {
+	mpsc_slot_t slots[JOB_QUEUE_SIZE];
+	_Alignas(64) atomic_size_t tail;	// 생산자들이 CAS로 예약하는 위치
+	_Alignas(64) size_t head;			// 소비자 전용 위치
+	size_t hwm;							// drain 시점에 관측한 최대 적재량 (소비자만 기록, 지표용)
+} mpsc_queue_t;
+
+/* job_queue_try_push 결과 */
+typedef enum {
+	JOBQ_FULL = -1,		// 가득 차서 넣지 못함 (패킷은 HIGH 이상이면)
+	JOBQ_OK = 0,
+	JOBQ_CONGESTED = 1	// 넣었지만 적재량이 HIGH 이상이므로 더 넣지 말아야 함
+} jobq_push_t;
+
 void job_queue_init(job_queue_t* q);
 void job_queue_push(job_queue_t* q, job_t* job);
+jobq_push_t job_queue_try_push(job_queue_t* q, job_t* job);
 int job_queue_pop(job_queue_t* q, job_t* out, jobq_mode_t mode);
+int job_queue_pop_timed(job_queue_t* q, job_t* out, int timeout_ms);
+int job_queue_depth(job_queue_t* q);
+void job_queue_park(job_queue_t* q, int delta);
+bool job_queue_uncongest(job_queue_t* q);
 
-void job_queue_push_packet(job_queue_t* q, int fd, packet_t* pkt);
-void job_queue_push_disconnect(job_queue_t* q, int fd);
+jobq_push_t job_queue_try_push_packet(job_queue_t* q, conn_handle_t handle, packet_t* pkt);
+jobq_push_t job_queue_try_push_disconnect(job_queue_t* q, conn_handle_t handle);
 void job_queue_push_shutdown(job_queue_t* q);
 
+void mpsc_queue_init(mpsc_queue_t* q);
+bool mpsc_queue_try_push(mpsc_queue_t* q, const job_t* job);
+int mpsc_queue_pop_batch(mpsc_queue_t* q, job_t* out, int max);
+size_t mpsc_queue_depth(mpsc_queue_t* q);
+
 #endif
@@ -0,0 +1,352 @@
+#define _GNU_SOURCE
+
+#include "log.h"
+
+#include <stdarg.h>
+#include <strings.h>
+
+/* 스레드별 ring 크기 (레코드 수, 2의 거듭제곱) */
+#define LOG_RING_SIZE 4096
+
+/* ring을 가질 수 있는 최대 스레드 수 */
+#define LOG_MAX_THREADS 64
+
+/* 로그 스레드의 출력 버퍼 크기, 한 번에 모아서 write함 */
+#define LOG_OUT_BUF_SIZE (64 * 1024)
+
+/* 처리할 레코드가 없을 때 로그 스레드가 쉬는 시간 */
+#define LOG_IDLE_SLEEP_NS (1000 * 1000)
+
+int g_log_level = LOG_LEVEL_INFO;
+
+/* 바이너리 레코드 (캐시 라인 하나인 64바이트, 8 + 8 + 1 + 1 + 패딩 6 + 인자 5 x 8) */
+typedef struct {
+	uint64_t ts_ns;					// CLOCK_REALTIME 기준 시각
+	const char* fmt;				// 포맷 문자열 (리터럴 주소)
+	uint8_t level;
+	uint8_t nargs;
+	int64_t args[LOG_MAX_ARGS];
+} log_record_t;
+
+_Static_assert(sizeof(log_record_t) == 64, "log_record_t must fill exactly one cache line");
+
+/*
+* 스레드별 SPSC ring (생산자: 소유 스레드, 소비자: 로그 스레드)
+* head/tail은 서로 다른 캐시 라인에 두어 생산자와 소비자가 같은 라인을 번갈아 가져가지 않게 함
+*/
+typedef struct {
+	_Alignas(64) atomic_uint tail;	// 생산자가 다음에 쓸 위치
+	_Alignas(64) atomic_uint head;	// 소비자가 다음에 읽을 위치
+	_Alignas(64) atomic_ulong dropped;	// ring이 가득 차 버린 레코드 수
+	unsigned long dropped_reported;	// 로그 스레드가 마지막으로 알린 버린 수 (로그 스레드 전용)
+	int id;
+	_Alignas(64) log_record_t recs[LOG_RING_SIZE];	// 레코드 하나가 캐시 라인 하나에 맞게 정렬
+} log_ring_t;
+
+static log_ring_t* rings[LOG_MAX_THREADS];
+static atomic_int ring_count;
+
+/* ring을 받지 못한 스레드(LOG_MAX_THREADS 초과)에서 버린 레코드 수 */
+static atomic_ulong unregistered_dropped;
+
+static __thread log_ring_t* t_ring;
+static __thread bool t_ring_failed;
+
+static pthread_t log_tid;
+static atomic_bool log_running;
+static bool log_started;
+
+static const char* level_name[] = { "DEBUG", "INFO ", "WARN ", "ERROR" };
+
+static uint64_t realtime_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* 현재 스레드의 ring을 처음 로그를 남길 때 만들어 등록하는 함수 */
+static log_ring_t* ring_register(void) {
+	if (t_ring_failed)
+		return NULL;
+
+	int id = atomic_fetch_add(&ring_count, 1);
+	log_ring_t* r = (id < LOG_MAX_THREADS) ? aligned_alloc(64, sizeof(log_ring_t)) : NULL;
+	if (!r) {
+		t_ring_failed = true;
+		return NULL;
+	}
+
+	atomic_init(&r->tail, 0);
+	atomic_init(&r->head, 0);
+	atomic_init(&r->dropped, 0);
+	r->dropped_reported = 0;
+	r->id = id;
+
+	/* 로그 스레드는 rings[id]가 채워진 뒤에만 읽음 */
+	__atomic_store_n(&rings[id], r, __ATOMIC_RELEASE);
+	t_ring = r;
+	return r;
+}
+
+/*
+* 레코드 하나를 현재 스레드의 ring에 넣는 함수
+* 문자열 변환 없이 인자만 복사하며, ring이 가득 차 있으면 버리고 개수만 셈
+*/
+void log_write(int level, const char* fmt, const int64_t* args, int nargs) {
+	log_ring_t* r = t_ring ? t_ring : ring_register();
+	if (!r) {
+		atomic_fetch_add_explicit(&unregistered_dropped, 1, memory_order_relaxed);
+		return;
+	}
+
+	unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+	if (tail - atomic_load_explicit(&r->head, memory_order_acquire) >= LOG_RING_SIZE) {
+		atomic_fetch_add_explicit(&r->dropped, 1, memory_order_relaxed);
+		return;
+	}
+
+	log_record_t* rec = &r->recs[tail & (LOG_RING_SIZE - 1)];
+	rec->ts_ns = realtime_ns();
+	rec->fmt = fmt;
+	rec->level = (uint8_t)level;
+	rec->nargs = (uint8_t)nargs;
+	for (int i = 0; i < nargs; ++i)
+		rec->args[i] = args[i];
+
+	atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+}
+
+/* 출력 버퍼 */
+typedef struct {
+	char data[LOG_OUT_BUF_SIZE];
+	size_t len;
+} log_out_t;
+
+static void out_flush(log_out_t* out) {
+	size_t off = 0;
+	while (off < out->len) {
+		ssize_t n = write(STDOUT_FILENO, out->data + off, out->len - off);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		off += (size_t)n;
+	}
+	out->len = 0;
+}
+
+static void out_putc(log_out_t* out, char c) {
+	if (out->len == sizeof(out->data))
+		out_flush(out);
+	out->data[out->len++] = c;
+}
+
+static void out_puts(log_out_t* out, const char* s) {
+	while (*s)
+		out_putc(out, *s++);
+}
+
+static void out_printf(log_out_t* out, const char* fmt, ...) {
+	char tmp[64];
+	va_list ap;
+	va_start(ap, fmt);
+	vsnprintf(tmp, sizeof(tmp), fmt, ap);
+	va_end(ap);
+	out_puts(out, tmp);
+}
+
+/*
+* 레코드 하나를 문자열로 변환해 출력 버퍼에 붙이는 함수 (로그 스레드 전용)
+* 형식 : HH:MM:SS.uuuuuu LEVEL 메시지
+*/
+static void format_record(log_out_t* out, const log_record_t* rec) {
+	time_t sec = (time_t)(rec->ts_ns / 1000000000ull);
+	struct tm tm;
+	localtime_r(&sec, &tm);
+	out_printf(out, "%02d:%02d:%02d.%06u %s ", tm.tm_hour, tm.tm_min, tm.tm_sec,
+		(unsigned)(rec->ts_ns % 1000000000ull / 1000), level_name[rec->level]);
+
+	int argi = 0;
+	for (const char* p = rec->fmt; *p; ++p) {
+		if (*p != '%' || p[1] == '\0') {
+			out_putc(out, *p);
+			continue;
+		}
+
+		char conv = *++p;
+		if (conv == '%') {
+			out_putc(out, '%');
+			continue;
+		}
+
+		int64_t v = (argi < rec->nargs) ? rec->args[argi++] : 0;
+		switch (conv) {
+		case 'd':
+			out_printf(out, "%lld", (long long)v);
+			break;
+		case 'u':
+			out_printf(out, "%llu", (unsigned long long)v);
+			break;
+		case 'x':
+			out_printf(out, "%llx", (unsigned long long)v);
+			break;
+		case 's':
+			out_puts(out, v ? (const char*)(intptr_t)v : "(null)");
+			break;
+		case 'I': {
+			uint32_t a = ntohl((uint32_t)v);
+			out_printf(out, "%u.%u.%u.%u", a >> 24, (a >> 16) & 0xff, (a >> 8) & 0xff, a & 0xff);
+			break;
+		}
+		case 'E': {
+			char buf[128];
+			out_puts(out, strerror_r((int)v, buf, sizeof(buf)));
+			break;
+		}
+		default:
+			out_putc(out, '%');
+			out_putc(out, conv);
+			break;
+		}
+	}
+
+	out_putc(out, '\n');
+}
+
+/*
+* 모든 ring에 쌓인 레코드를 시각 순으로 합쳐 출력하는 함수
+* 시작 시점에 보인 레코드만 처리하며, 처리한 레코드 수를 반환
+*/
+static int drain_rings(log_out_t* out) {
+	int n = atomic_load_explicit(&ring_count, memory_order_acquire);
+	if (n > LOG_MAX_THREADS)
+		n = LOG_MAX_THREADS;
+
+	unsigned head[LOG_MAX_THREADS];
+	unsigned tail[LOG_MAX_THREADS];
+	log_ring_t* rs[LOG_MAX_THREADS];
+
+	for (int i = 0; i < n; ++i) {
+		rs[i] = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+		if (!rs[i]) {
+			head[i] = tail[i] = 0;
+			continue;
+		}
+		head[i] = atomic_load_explicit(&rs[i]->head, memory_order_relaxed);
+		tail[i] = atomic_load_explicit(&rs[i]->tail, memory_order_acquire);
+	}
+
+	int total = 0;
+	for (;;) {
+		/* 각 ring의 맨 앞 레코드 중 가장 이른 것을 고름 */
+		int pick = -1;
+		uint64_t best = 0;
+		for (int i = 0; i < n; ++i) {
+			if (head[i] == tail[i])
+				continue;
+			uint64_t ts = rs[i]->recs[head[i] & (LOG_RING_SIZE - 1)].ts_ns;
+			if (pick < 0 || ts < best) {
+				pick = i;
+				best = ts;
+			}
+		}
+
+		if (pick < 0)
+			break;
+
+		format_record(out, &rs[pick]->recs[head[pick] & (LOG_RING_SIZE - 1)]);
+		head[pick]++;
+		total++;
+
+		/* 변환이 끝난 자리는 바로 돌려줘서 생산자가 기다리지 않게 함 */
+		atomic_store_explicit(&rs[pick]->head, head[pick], memory_order_release);
+	}
+
+	/* 가득 차서 버린 레코드가 새로 생겼으면 알림 */
+	for (int i = 0; i < n; ++i) {
+		if (!rs[i])
+			continue;
+		unsigned long d = atomic_load_explicit(&rs[i]->dropped, memory_order_relaxed);
+		if (d != rs[i]->dropped_reported) {
+			out_printf(out, "[LOG] ring=%d dropped %lu records\n", rs[i]->id, d - rs[i]->dropped_reported);
+			rs[i]->dropped_reported = d;
+		}
+	}
+
+	return total;
+}
+
+static void* log_thread(void* arg) {
+	(void)arg;
+	static log_out_t out;
+
+	for (;;) {
+		bool running = atomic_load(&log_running);
+		int n = drain_rings(&out);
+		out_flush(&out);
+
+		/* 종료 요청 이후에는 남은 레코드를 모두 비운 뒤 끝냄 */
+		if (n == 0) {
+			if (!running)
+				break;
+			struct timespec ts = { 0, LOG_IDLE_SLEEP_NS };
+			nanosleep(&ts, NULL);
+		}
+	}
+
+	unsigned long lost = atomic_load(&unregistered_dropped);
+	if (lost) {
+		out_printf(&out, "[LOG] dropped %lu records from threads without a ring\n", lost);
+		out_flush(&out);
+	}
+
+	return NULL;
+}
+
+/*
+* 로그 스레드 시작 함수
+* 종료 시그널이 로그 스레드로 전달되지 않도록 막은 상태로 생성함
+*/
+int log_init(void) {
+	sigset_t set, old;
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &set, &old);
+
+	atomic_store(&log_running, true);
+	int rc = pthread_create(&log_tid, NULL, log_thread, NULL);
+
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	if (rc != 0)
+		return -1;
+
+	log_started = true;
+	return 0;
+}
+
+/* 남은 로그를 모두 출력하고 로그 스레드를 종료하는 함수 */
+void log_shutdown(void) {
+	if (!log_started)
+		return;
+
+	atomic_store(&log_running, false);
+	pthread_join(log_tid, NULL);
+	log_started = false;
+}
+
+void log_set_level(int level) {
+	g_log_level = level;
+}
+
+/* "debug" / "info" / "warn" / "error" / "off" -> 레벨, 알 수 없으면 -1 */
+int log_level_from_str(const char* s) {
+	static const char* names[] = { "debug", "info", "warn", "error", "off" };
+	for (int i = 0; i <= LOG_LEVEL_OFF; ++i) {
+		if (strcasecmp(s, names[i]) == 0)
+			return i;
+	}
+	return -1;
+}
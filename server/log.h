@@ -0,0 +1,52 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include "common.h"
+
+/*
+* 비동기 로그
+* 각 스레드는 printf 대신 고정 크기 바이너리 레코드(시각, 레벨, 포맷 문자열 주소, 정수 인자)를
+* 자신의 lock-free ring에 넣기만 하고, 문자열 변환과 출력은 로그 스레드가 모아서 처리함
+* ring이 가득 차면 레코드를 버리고 개수만 세며, 버린 수는 로그 스레드가 주기적으로 알려줌
+*
+* 포맷 문자열은 반드시 문자열 리터럴이어야 하며(주소만 기록함), 지원하는 변환은 다음과 같음
+* %d %u %x : 정수, %s : 수명이 프로그램 전체인 문자열(리터럴 등), %I : IPv4 주소(network order), %E : errno 값, %% : '%'
+*/
+typedef enum {
+	LOG_LEVEL_DEBUG = 0,
+	LOG_LEVEL_INFO,
+	LOG_LEVEL_WARN,
+	LOG_LEVEL_ERROR,
+	LOG_LEVEL_OFF,
+} log_level_t;
+
+/* 레코드 하나에 담을 수 있는 최대 인자 수 (레코드가 64바이트가 되도록 맞춘 값, log.c) */
+#define LOG_MAX_ARGS 5
+
+/* 현재 출력 레벨, 이보다 낮은 레벨의 로그는 분기 한 번으로 건너뜀 */
+extern int g_log_level;
+
+int log_init(void);
+void log_shutdown(void);
+void log_set_level(int level);
+int log_level_from_str(const char* s);
+
+void log_write(int level, const char* fmt, const int64_t* args, int nargs);
+
+/* %s 인자로 넘길 문자열 주소 변환 */
+#define LOG_STR(s) ((int64_t)(intptr_t)(s))
+
+#define LOG_AT(level, fmt, ...) do { \
+	if ((level) >= g_log_level) { \
+		const int64_t log_args_[] = { 0, ##__VA_ARGS__ }; \
+		_Static_assert(sizeof(log_args_) / sizeof(int64_t) - 1 <= LOG_MAX_ARGS, "too many log arguments"); \
+		log_write((level), (fmt), log_args_ + 1, (int)(sizeof(log_args_) / sizeof(int64_t)) - 1); \
+	} \
+} while (0)
+
+#define LOG_DEBUG(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...) LOG_AT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...) LOG_AT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+#endif
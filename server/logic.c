@@ -1,125 +1,386 @@
 #include "logic.h"
 #include "job_queue.h"
 #include "state.h"
+#include "packet_pool.h"
+#include "log.h"
+#include "metrics.h"
+#include "ebr.h"
+#include "net.h"
+#include "timer_wheel.h"
+#include "game.h"
 #include <stdio.h>
 
-extern job_queue_t g_logic_q;
+extern job_queue_t g_logic_q[WORKER_THREAD_NUM];
+
+/*
+* worker 배치 규칙
+* 세션은 연결 id 기준 home worker(id % N)에 고정되어, 한 연결의 패킷은 항상 같은 worker에서 순서대로 처리됨
+* 방은 슬롯 번호 기준 소유 worker(slot % N)에 고정되어, 방 상태 변경과 브로드캐스트는 락 없이 단일 스레드로 처리됨
+* 방 입장 시점부터 방 관련 작업(입장/퇴장/채팅/게임 입력)은 JOB_ROOM_*으로 방 소유 worker에게 넘김
+* home worker -> 방 소유 worker 방향의 push는 항상 같은 생산자가 하므로 세션 단위 순서가 유지됨
+* (대상 큐가 가득 차 밀린 작업도 대상별 FIFO로 두었다가 넣으므로 순서가 바뀌지 않음)
+*/
+#define HOME_WORKER(id)		((id) % WORKER_THREAD_NUM)
+/* 슬롯이 다른 세대로 재사용되어도 같은 worker가 맡으므로 한 슬롯의 멤버 목록은 항상 한 스레드만 건드림 */
+#define ROOM_WORKER(id)		(ROOM_SLOT(id) % WORKER_THREAD_NUM)
+
+/* 현재 worker 번호 */
+static __thread int t_worker_id;
+
+/*
+* 방 소유 worker의 큐가 가득 차 아직 넘기지 못한 방 작업 (대상 worker별 FIFO, 현재 worker 전용)
+* worker끼리 서로의 큐에 대기하며 넣으면 두 worker가 동시에 상대 큐가 비기를 기다리다 함께 멈출 수 있으므로,
+* 방 작업은 대기 없이 넣고 넣지 못한 것은 여기 두었다가 루프마다 다시 넣음
+* 대상별로 이미 밀린 작업이 있으면 뒤에 붙여 세션 단위 순서를 지킴
+*/
+typedef struct {
+	job_t* items;
+	int head;
+	int count;
+	int cap;
+} room_backlog_t;
+
+static __thread room_backlog_t t_room_backlog[WORKER_THREAD_NUM];
+static __thread int t_room_backlog_count;
+
+/* 현재 worker의 타이머 휠 (home worker로서 소유한 세션의 입장 기한과, 방 소유 worker로서 소유한 방의 게임 tick이 걸림) */
+static __thread timer_wheel_t t_timers;
+
+/*
+* 하나의 패킷에 대해, 패킷 타입별 로직을 수행하는 함수
+* 패킷 버퍼를 다른 worker로 넘기는 경우 job->packet을 NULL로 비움
+*/
+static void handle_packet(session_t* s, job_t* job);
+
+/* 방 소유 worker에서 방 관련 작업을 수행하는 함수 */
+static void handle_room_job(job_t* job);
+
+/* 연결 종료 처리 함수 */
+static void handle_disconnect(conn_handle_t handle);
+
+/* 서버 정상 종료 시 현재 worker가 소유한 세션 및 방 정리 함수 */
+static void handle_shutdown(void);
+
+/* net thread가 연결의 패킷/끊김 이벤트를 넣을 큐를 반환하는 함수 (연결 id 기준) */
+job_queue_t* logic_queue_for(conn_handle_t handle)
+{
+	return &g_logic_q[HOME_WORKER(HANDLE_ID(handle))];
+}
 
-/* ϳ Ŷ , Ŷ ŸԺ  ϴ Լ */
-static void handle_packet(session_t* s, packet_t* pkt);
+bool logic_overloaded(void)
+{
+	for (int i = 0; i < WORKER_THREAD_NUM; ++i) {
+		if (job_queue_depth(&g_logic_q[i]) >= LOGIC_Q_HIGH_WATERMARK)
+			return true;
+	}
+	return false;
+}
 
-/* fd   ó Լ */
-static void handle_disconnect(int fd);
+/* 밀린 방 작업 목록 뒤에 붙이는 함수 (목록을 늘리지 못하면 -1) */
+static int room_backlog_push(room_backlog_t* b, const job_t* job)
+{
+	if (b->head + b->count == b->cap) {
+		if (b->head > 0) {
+			memmove(b->items, b->items + b->head, sizeof(job_t) * (size_t)b->count);
+			b->head = 0;
+		}
+		else {
+			int cap = b->cap ? b->cap * 2 : 64;
+			job_t* items = realloc(b->items, sizeof(job_t) * (size_t)cap);
+			if (!items)
+				return -1;
+			b->items = items;
+			b->cap = cap;
+		}
+	}
 
-/*     ü     Լ */
-static void handle_shutdown(void);
+	b->items[b->head + b->count++] = *job;
+	return 0;
+}
+
+/*
+* 방 소유 worker에게 방 관련 작업을 넘기는 함수
+* 방 소유 worker가 자기 자신이면 큐를 거치지 않고 바로 처리함
+* 다른 worker면 대기 없이 넣고, 큐가 가득 찼거나 앞서 밀린 작업이 있으면 밀린 목록에 둠
+*/
+static void post_room_job(job_type_t type, session_t* s, int room_id, packet_t* pkt)
+{
+	job_t job = { .type = type, .handle = s->handle, .session_id = s->session_id, .room_id = room_id, .packet = pkt };
+	int owner = ROOM_WORKER(room_id);
+
+	if (owner == t_worker_id) {
+		handle_room_job(&job);
+		packet_free(job.packet);
+		return;
+	}
+
+	room_backlog_t* b = &t_room_backlog[owner];
+	if (b->count == 0 && job_queue_try_push(&g_logic_q[owner], &job) != JOBQ_FULL)
+		return;
+
+	metric_inc(MC_ROOM_JOBS_DEFERRED);
+	if (room_backlog_push(b, &job) < 0) {
+		/* 목록조차 늘릴 수 없으면 작업을 잃지 않도록 자리가 날 때까지 기다림 */
+		LOG_ERROR("room job backlog alloc failed, blocking on worker %d queue", owner);
+		job_queue_push(&g_logic_q[owner], &job);
+		return;
+	}
+	t_room_backlog_count++;
+	job_queue_park(&g_logic_q[t_worker_id], 1);
+}
 
-/*     */
+/*
+* 밀린 방 작업을 대상 worker별로 순서대로 다시 넣는 함수 (가득 찬 대상은 다음 루프로 미룸)
+* 들고 있던 작업도 자기 큐의 적재량에 들어가므로, 넣은 뒤 LOW 아래로 내려갔으면 reactor들을 깨움
+*/
+static void room_backlog_flush(void)
+{
+	int before = t_room_backlog_count;
+
+	for (int w = 0; w < WORKER_THREAD_NUM && t_room_backlog_count > 0; ++w) {
+		room_backlog_t* b = &t_room_backlog[w];
+		while (b->count > 0 && job_queue_try_push(&g_logic_q[w], &b->items[b->head]) != JOBQ_FULL) {
+			b->head++;
+			b->count--;
+			t_room_backlog_count--;
+		}
+		if (b->count == 0)
+			b->head = 0;
+	}
+
+	if (t_room_backlog_count < before) {
+		job_queue_park(&g_logic_q[t_worker_id], t_room_backlog_count - before);
+		if (job_queue_uncongest(&g_logic_q[t_worker_id]))
+			net_wakeup_all();
+	}
+}
+
+/* 종료 시 넘기지 못한 방 작업의 패킷과 목록 해제 (다른 worker도 종료 중이므로 처리하지 않음) */
+static void room_backlog_destroy(void)
+{
+	for (int w = 0; w < WORKER_THREAD_NUM; ++w) {
+		room_backlog_t* b = &t_room_backlog[w];
+		for (int i = 0; i < b->count; ++i)
+			packet_free(b->items[b->head + i].packet);
+		free(b->items);
+		memset(b, 0, sizeof(*b));
+	}
+	job_queue_park(&g_logic_q[t_worker_id], -t_room_backlog_count);
+	t_room_backlog_count = 0;
+}
+
+/* 입장 기한 안에 방에 들어가지 않은 세션의 연결을 끊도록 담당 reactor에 요청 */
+static void join_deadline_expired(void* arg)
+{
+	session_t* s = arg;
+	LOG_INFO("[LOGIC] conn=%d join deadline expired", HANDLE_ID(s->handle));
+	net_close(s->handle, DISC_JOIN_TIMEOUT);
+}
+
+/* 방에 들어가 있지 않은 세션의 입장 기한을 거는 함수 (JOIN_DEADLINE_MS가 0이면 걸지 않음) */
+static void join_deadline_arm(session_t* s)
+{
+	if (JOIN_DEADLINE_MS > 0)
+		timer_arm(&t_timers, &s->join_timer, monotonic_ms() + JOIN_DEADLINE_MS);
+}
+
+/* 로직 스레드 메인 루프 */
 void* worker_thread(void* arg)
 {
-	(void)arg;
+	t_worker_id = (int)(intptr_t)arg;
+	job_queue_t* q = &g_logic_q[t_worker_id];
 	job_t job;
 
+	timer_wheel_init(&t_timers, monotonic_ms());
+
 	while (1) {
-		/* ť ۾    */
-		job_queue_pop(&g_logic_q, &job, JOBQ_BLOCK);
+		/*
+		* 걸린 타이머가 있으면 만료된 것을 처리하고, 다음 만료 시각까지만 기다림
+		* 게임 tick이 휠 tick 경계에서 바로 돌도록 coarse 시계 대신 정밀 시계로 시각을 읽음
+		*/
+		int timeout = -1;
+		if (t_timers.count > 0) {
+			uint64_t now = monotonic_ns() / 1000000;
+			int fired = timer_wheel_advance(&t_timers, now);
+			if (fired > 0) {
+				metric_add(MC_TIMERS_FIRED, (uint64_t)fired);
+				net_wakeup();
+			}
+			timeout = timer_wheel_timeout(&t_timers, now);
+		}
+
+		/* 밀린 방 작업이 남아 있으면 대상 큐가 비는 것을 알 방법이 없으므로 짧게만 기다리고 다시 넣어 봄 */
+		if (t_room_backlog_count > 0) {
+			room_backlog_flush();
+			if (t_room_backlog_count > 0 && (timeout < 0 || timeout > LOGIC_ROOM_RETRY_MS))
+				timeout = LOGIC_ROOM_RETRY_MS;
+		}
+
+		/* 자신의 큐에 작업이 들어올 때까지 대기 */
+		if (!job_queue_pop_timed(q, &job, timeout))
+			continue;
+
+		/* 적체가 LOW 수위 아래로 풀렸으면 읽기를 멈춘 연결을 다시 확인하도록 reactor들을 깨움 */
+		if (job_queue_uncongest(q))
+			net_wakeup_all();
+
+		/* 작업 하나를 처리하는 동안만 EBR 읽기 구간에 머묾 (대기 중에는 다른 worker의 세션 회수를 막지 않음) */
+		ebr_enter();
 
 		switch (job.type) {
 
 		/*
-		* Ʈũ ̺Ʈκ  Ŷ ó
-		* fd -> session  Ȯ
-		*  session   
+		* 네트워크 이벤트로부터 온 패킷 처리
+		* handle -> session 매핑 확보
+		* 만약 session이 없으면 새로 생성함
+		* reactor는 연결 id를 반납한 뒤에 끊김을 넣으므로, 같은 id를 받은 새 연결의 패킷이 이전 연결의 끊김보다 먼저 올 수 있음
+		* 이때 id 자리에 남은 이전 세션은 여기서 먼저 정리하고, 뒤늦게 온 끊김은 handle이 달라 무시됨
 		*/
 		case JOB_PACKET: {
-			session_t* s = session_get(job.fd);
-			if (!s) s = session_create(job.fd);
+			/* reactor가 파싱한 시점부터 worker가 꺼내기까지의 큐 대기 시간 */
+			metric_record(MH_RECV_TO_LOGIC, monotonic_ns() - job.packet->recv_ns);
+
+			int id = HANDLE_ID(job.handle);
+			session_t* s = session_get(job.handle);
+			if (!s) {
+				session_t* stale = session_at(id);
+				if (stale)
+					handle_disconnect(stale->handle);
+				s = session_create(job.handle);
+				if (s) {
+					timer_init(&s->join_timer, join_deadline_expired, s);
+					join_deadline_arm(s);
+				}
+			}
 
 			if (!s || !s->alive) {
-				printf("[ERROR] session create failed fd=%d\n", job.fd);
+				LOG_ERROR("session create failed conn=%d", id);
 				break;
 			}
 
-			/* Ŷ ŸԺ  ó */
-			handle_packet(s, &job.packet);
+			LOG_DEBUG("[WORKER] w=%d sid=%d conn=%d type=%d len=%d", t_worker_id, s->session_id, id, job.packet->type, job.packet->length);
 
-			printf("[WORKER] sid=%d fd=%d type=%d len=%d\n", s->session_id, job.fd, job.packet.type, job.packet.length);
+			/* 패킷 타입별 논리 처리 */
+			handle_packet(s, &job);
 			break;
 		}
 
 		/*
-		*   ó
-		* net thread epoll/err  disconnect ϸ  ť JOB_DISCONNECT 
+		* 연결 종료 처리
+		* net thread에서 epoll/err 등으로 disconnect를 감지하면 로직 큐에 JOB_DISCONNECT 삽입
 		*/
 		case JOB_DISCONNECT: {
-			handle_disconnect(job.fd);
+			handle_disconnect(job.handle);
+			break;
+		}
+
+		/* home worker로부터 넘겨받은 방 관련 작업 처리 */
+		case JOB_ROOM_JOIN:
+		case JOB_ROOM_LEAVE:
+		case JOB_ROOM_CHAT:
+		case JOB_ROOM_GAME: {
+			handle_room_job(&job);
 			break;
 		}
 
 		/*
-		*   ó
-		*   ȸϸ 濡    
-		*  Ϸ  worker thread 
+		* 정상 종료 처리
+		* 현재 worker가 소유한 세션과 방을 정리
+		* 정리 완료 후 worker thread 종료
 		*/
 		case JOB_SHUTDOWN: {
 			handle_shutdown();
+			room_backlog_destroy();
+			ebr_exit();
 			return NULL;   
 		}
 
 		default:
 			break;
 		}
+
+		ebr_exit();
+
+		/* 처리가 끝난 패킷 버퍼는 풀로 반납 (다른 worker로 넘긴 경우 NULL) */
+		packet_free(job.packet);
 	}
 
 	return NULL;
 }
 
-static void handle_packet(session_t* s, packet_t* pkt) {
+static void handle_packet(session_t* s, job_t* job) {
+	packet_t* pkt = job->packet;
 	if (!s || !s->alive)
 		return;
 
 	switch (pkt->type) {
 
-	/*  
-	* ̹ 濡  ִ  ߺ 
-	*    Ž ,     
-	*    濡 
+	/* 방 입장
+	* 이미 방에 들어가 있는 경우 중복 방지
+	* payload가 없으면 자동 배정 방, 채널 번호(2바이트)가 있으면 해당 채널 방(0 : 로비)의 좌석을 예약
+	* (방이 존재하지 않으면 방 생성)
+	* 이후 실제 입장은 방 소유 worker에게 넘김
 	*/
 	case PKT_JOIN_ROOM: {
 		if (s->room_id >= 0)
 			break;
 
-		room_t* r = room_find();
-		if (!r) r = room_create();
-		room_join(r, s);
+		room_t* r;
+		if (pkt->length - 2 >= 2) {
+			uint16_t channel;
+			memcpy(&channel, pkt->payload, 2);
+			r = room_reserve_channel(ntohs(channel));
+		}
+		else {
+			r = room_reserve();
+		}
+		if (!r)
+			break;
+
+		s->room_id = r->room_id;
+		timer_cancel(&t_timers, &s->join_timer);
+		post_room_job(JOB_ROOM_JOIN, s, r->room_id, NULL);
 		break;
 	}
 
-	/* ä ޽ ó
-	*    ä 
-	*  room_id    
-	* εĳ    ǵ鿡 ä 
+	/* 채팅 메시지 처리
+	* 방 미입장 시의 채팅은 무시
+	* 세션의 room_id를 통해 방 소유 worker에게 채팅을 넘김
+	* 브로드캐스팅은 방 소유 worker에서 수행됨
 	*/
 	case PKT_CHAT: {
 		if (s->room_id < 0)
 			break;
 
-		room_t* r = room_get(s->room_id);
-		if (!r)
+		post_room_job(JOB_ROOM_CHAT, s, s->room_id, pkt);
+		job->packet = NULL;
+		break;
+	}
+
+	/*
+	* 게임 입력
+	* 채팅과 같이 방 소유 worker에게 넘기며, 방 소유 worker는 방의 이번 tick 입력 버퍼에 모았다가 tick마다 결과를 보냄
+	*/
+	case PKT_GAME_ACTION: {
+		if (s->room_id < 0)
 			break;
-		room_broadcast(r, s, pkt);
+
+		post_room_job(JOB_ROOM_GAME, s, s->room_id, pkt);
+		job->packet = NULL;
 		break;
 	}
 
 	/*
-	*  
-	* room_leave Լ   room_id      
+	* 방 퇴장
+	* 방 목록 정리는 방 소유 worker에게 넘기고, 세션의 room_id는 즉시 갱신
 	*/
 	case PKT_LEAVE_ROOM: {
 		if (s->room_id < 0)
 			break;
 
-		room_leave(s);
+		post_room_job(JOB_ROOM_LEAVE, s, s->room_id, NULL);
+		s->room_id = -1;
+		join_deadline_arm(s);
 		break;
 	}
 
@@ -128,44 +389,79 @@ static void handle_packet(session_t* s, packet_t* pkt) {
 	}
 }
 
-static void handle_disconnect(int fd) {
-	session_t* s = session_get(fd);
+static void handle_room_job(job_t* job) {
+	room_t* r = room_get(job->room_id);
+	if (!r)
+		return;
 
-	/* ̹ ưų,      */
+	switch (job->type) {
+	/*
+	* 입장 작업이 큐에 있는 동안 연결이 끊겼으면 멤버로 넣지 않음 (좌석은 뒤따르는 퇴장 작업이 반납함)
+	* 세션은 home worker 소유지만 handle 조회는 EBR 읽기 구간 안이므로 락 없이 안전함
+	*/
+	case JOB_ROOM_JOIN:
+		if (!session_get(job->handle)) {
+			metric_inc(MC_STALE_HANDLES);
+			break;
+		}
+		room_join(r, job->handle, job->session_id);
+		break;
+
+	/* 마지막 멤버가 나가면 게임 tick도 멈춤 (다시 입력이 오면 새로 시작) */
+	case JOB_ROOM_LEAVE:
+		room_leave(r, job->handle);
+		if (!r->members || r->members->count == 0)
+			game_room_stop(r, &t_timers);
+		break;
+
+	case JOB_ROOM_CHAT:
+		room_broadcast(r, job->handle, job->packet);
+		break;
+
+	case JOB_ROOM_GAME:
+		game_room_input(r, &t_timers, job->handle, job->session_id, job->packet);
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void handle_disconnect(conn_handle_t handle) {
+	session_t* s = session_get(handle);
+
+	/* 이미 정리됐거나, 세션 생성 전 끊긴 경우 */
 	if (!s) {
 		return;
 	}
 
-	printf("[LOGIC] fd=%d disconnect event\n", fd);
+	LOG_INFO("[LOGIC] conn=%d disconnect event", HANDLE_ID(handle));
 
-	/* 濡  ־ٸ 濡  */
+	/* 방에 들어가 있었다면 방 소유 worker에게 퇴장을 넘김 */
 	if (s->room_id >= 0) {
-		room_leave(s);
+		post_room_job(JOB_ROOM_LEAVE, s, s->room_id, NULL);
+		s->room_id = -1;
 	}
 
-	/*   */
-	session_remove(fd);
+	/* 세션 제거 (해제되기 전에 휠에서 먼저 뺌) */
+	timer_cancel(&t_timers, &s->join_timer);
+	session_remove(handle);
 }
 
 static void handle_shutdown(void)
 {
-	printf("[LOGIC] graceful shutdown started\n");
+	LOG_INFO("[LOGIC] w=%d graceful shutdown started", t_worker_id);
 
 	/*
-	* fd ȸ  ϴ  ã 
-	* 濡 ϴ ǵ  room_leave ó   
+	* 모든 worker가 JOB_SHUTDOWN을 하나씩 받으므로, 각자 소유한 방과 세션만 정리함
+	* 다른 worker도 함께 종료 중이므로 방 퇴장을 넘기지 않고 방 멤버 목록을 직접 비움
 	*/
-	for (int fd = 0; fd < MAX_CLIENTS; ++fd) {
-		session_t* s = session_get(fd);
-		if (!s)
-			continue;
-
-		if (s->room_id >= 0) {
-			room_leave(s);
-		}
-
-		session_remove(fd);
+	for (int slot = t_worker_id; slot < MAX_ROOMS; slot += WORKER_THREAD_NUM) {
+		game_room_stop(room_at(slot), &t_timers);
+		room_clear(room_at(slot));
 	}
 
-	printf("[LOGIC] graceful shutdown completed\n");
+	session_remove_all(t_worker_id);
+
+	LOG_INFO("[LOGIC] w=%d graceful shutdown completed", t_worker_id);
 }
\ No newline at end of file
@@ -2,7 +2,13 @@
 #define LOGIC_H
 
 #include <pthread.h>
+#include "job_queue.h"
 
 void* worker_thread(void* arg);
 
+job_queue_t* logic_queue_for(conn_handle_t handle);
+
+/* worker 큐 중 하나라도 HIGH 수위 이상인지 (새 연결을 받지 않을 상태) */
+bool logic_overloaded(void);
+
 #endif
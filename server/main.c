@@ -7,24 +7,27 @@
 #include "net.h"
 #include "logic.h"
 #include "job_queue.h"
+#include "log.h"
+#include "metrics.h"
+#include "conn_table.h"
+#include "state.h"
 
 /*
-* g_logic_q : net -> logic( Ŷ//  "̺Ʈ ")
-* g_io_q : logic -> net(send û  "I/O  û")
+* g_logic_q : net -> logic(수신 패킷/끊김/종료 같은 "이벤트 전달"), worker마다 하나씩 소유
+* io_q : logic -> net(send 요청 같은 "I/O 수행 요청"), reactor마다 하나씩 소유하며 소비자가 하나이므로 lock-free MPSC ring 사용 (net.c)
 * 
-* net thread epoll loop  I/O ؾ ϰ, logic thread  Ű εĳƮ  ؾ ϹǷ ť и
-*  ⼺ ٸ ۾ иؼ åӰ 帧 Ȯ ϱ  ť и
+* net thread는 epoll loop를 돌며 I/O에 집중해야 하고, logic thread는 상태 갱신과 브로드캐스트 결정을 담당해야 하므로 큐를 분리함
+* 즉 방향성이 다른 작업을 분리해서 책임과 흐름을 명확히 하기 위해 큐를 분리함
 */
-job_queue_t g_logic_q;
-job_queue_t g_io_q;
+job_queue_t g_logic_q[WORKER_THREAD_NUM];
 
 /*
-* g_terminate ñ׳ ڵ鷯 񵿱 ǹǷ, Ϸ   Ϳ ĳϰų б⸦ ϴ ȭ ϸ        
-* volatile Ű带  ̷ ȭ  Ź ޸𸮿  ٽ а ؼ, ñ׳η ٲ  ÷׸ ġ ʰ 
+* g_terminate는 시그널 핸들러에서 비동기적으로 변경되므로, 컴파일러가 루프에서 값을 레지스터에 캐시하거나 읽기를 생략하는 최적화를 하면 변경을 못 보고 무한 루프가 될 수 있음
+* volatile 키워드를 통해 이런 최적화를 막아 매번 메모리에서 값을 다시 읽게 해서, 시그널로 바뀐 종료 플래그를 놓치지 않게 함
 */
 volatile sig_atomic_t g_terminate = 0;
 
-/* SIGINT(Ctrl+C) / SIGTERM( û)    ÷  */
+/* SIGINT(Ctrl+C) / SIGTERM(종료 요청) 수신 시 종료 플래그 설정 */
 void handle_sigint(int sig) {
 	if (sig == SIGINT || sig == SIGTERM)
 		g_terminate = 1;
@@ -32,40 +35,87 @@ void handle_sigint(int sig) {
 
 int main() {
 
-	/*  ñ׳ ó */
+	/* 종료 시그널 처리 */
 	signal(SIGPIPE, SIG_IGN);
 	signal(SIGINT, handle_sigint);
 	signal(SIGTERM, handle_sigint);
 
-	/*   ۾ ť ʱȭ */
-	job_queue_init(&g_logic_q);
-	job_queue_init(&g_io_q);
+	/*
+	* 비동기 로그 시작
+	* LOG_LEVEL 환경 변수(debug / info / warn / error / off)로 출력 레벨을 정하며, 기본은 info
+	* 패킷 단위 추적 로그는 debug 레벨이므로 기본 설정에서는 분기 한 번으로 건너뜀
+	*/
+	const char* level = getenv("LOG_LEVEL");
+	if (level && log_level_from_str(level) >= 0)
+		log_set_level(log_level_from_str(level));
+
+	if (log_init() < 0) {
+		fprintf(stderr, "log_init failed\n");
+		exit(1);
+	}
+
+	/*
+	* 연결/세션 테이블 초기화
+	* 연결 id 한도는 RLIMIT_NOFILE에서 정하며, worker와 reactor가 테이블을 쓰기 전에 준비되어야 함
+	*/
+	if (conn_table_init() < 0 || session_table_init(conn_table_limit()) < 0) {
+		fprintf(stderr, "connection table init failed\n");
+		exit(1);
+	}
 
-	/*  worker thread  */
+	/* 스레드 간 작업 큐 초기화 */
+	for (int i = 0; i < WORKER_THREAD_NUM; ++i)
+		job_queue_init(&g_logic_q[i]);
+
+	/*
+	* 종료 시그널이 worker thread로 전달되면 epoll_wait 중인 main 스레드가 깨어나지 못하므로,
+	* worker thread 생성 동안에는 시그널을 막아 새 스레드가 막힌 마스크를 물려받게 함
+	*/
+	sigset_t set, old;
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &set, &old);
+
+	/* 로직 worker thread 생성 */
 	for(int i = 0; i < WORKER_THREAD_NUM; ++i) {
 		pthread_t tid;
-		if (pthread_create(&tid, NULL, worker_thread, NULL) != 0) {
+		if (pthread_create(&tid, NULL, worker_thread, (void*)(intptr_t)i) != 0) {
 			perror("pthread_create");
 			exit(1);
 		}
 		pthread_detach(tid);
 	}
 
-	/* Ʈũ  ʱȭ */
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	/* 네트워크 모듈 초기화 */
 	if (net_init() < 0) {
 		fprintf(stderr, "net_init failed\n");
 		exit(1);
 	}
 
+	/*
+	* 지표 admin 소켓 시작
+	* 지표는 운영 편의 기능이므로 소켓을 열지 못해도 서버는 계속 실행함
+	*/
+	if (metrics_start(ADMIN_SOCKET_PATH) < 0)
+		LOG_WARN("metrics admin socket unavailable at %s", LOG_STR(ADMIN_SOCKET_PATH));
+
 	/* 
-	* Ʈũ ̺Ʈ   
-	* net_run ȯϸ   
-	*    worker thread shutdown ϳ   ְ ϵ 
+	* 네트워크 이벤트 루프 실행 
+	* net_run이 반환하면 종료 절차를 수행
+	* 종료 절차는 각 worker thread가 shutdown을 하나씩 받을 수 있게 하도록 함
 	*/
 	net_run();
 	for (int i = 0; i < WORKER_THREAD_NUM; i++) {
-		job_queue_push_shutdown(&g_logic_q);
+		job_queue_push_shutdown(&g_logic_q[i]);
 	}
 
+	metrics_stop();
+
+	/* 남은 로그 출력 */
+	log_shutdown();
+
 	return 0;
 }
@@ -0,0 +1,39 @@
+#include "member_set.h"
+
+/* cap명을 담을 수 있는 빈 목록을 참조 카운트 1로 할당하는 함수 */
+member_set_t* member_set_alloc(int cap) {
+	member_set_t* s = malloc(sizeof(member_set_t) + sizeof(room_member_t) * (size_t)cap);
+	if (!s)
+		return NULL;
+
+	atomic_init(&s->refcnt, 1);
+	s->count = 0;
+	s->cap = cap;
+	return s;
+}
+
+/* src의 멤버를 담은 cap 크기의 새 목록을 만드는 함수 (cap은 src->count 이상이어야 함) */
+member_set_t* member_set_copy(const member_set_t* src, int cap) {
+	member_set_t* s = member_set_alloc(cap);
+	if (!s)
+		return NULL;
+
+	s->count = src->count;
+	memcpy(s->members, src->members, sizeof(room_member_t) * (size_t)src->count);
+	return s;
+}
+
+/* 참조를 하나 추가하는 함수, 이미 참조를 가진 쪽에서만 호출하므로 relaxed로 충분 */
+member_set_t* member_set_ref(member_set_t* s) {
+	atomic_fetch_add_explicit(&s->refcnt, 1, memory_order_relaxed);
+	return s;
+}
+
+/* 참조를 하나 반납하는 함수, 마지막 참조였다면 목록 해제 */
+void member_set_release(member_set_t* s) {
+	if (!s)
+		return;
+
+	if (atomic_fetch_sub_explicit(&s->refcnt, 1, memory_order_acq_rel) == 1)
+		free(s);
+}
@@ -0,0 +1,31 @@
+#ifndef MEMBER_SET_H
+#define MEMBER_SET_H
+
+#include "common.h"
+
+// 방 멤버 정보 (세션은 다른 worker 소유이므로 포인터 대신 연결 handle/sid만 보관)
+typedef struct room_member {
+	conn_handle_t handle;
+	int session_id;
+} room_member_t;
+
+/*
+* 참조 카운트 기반 방 멤버 목록 (dense 배열)
+* 브로드캐스트는 목록을 복사하지 않고 참조만 reactor들에게 넘기며, reactor는 자신이 담당한 연결 중 handle이 일치하는 연결에만 프레임을 보냄
+* 방 소유 worker는 목록을 바꾸기 전에 다른 참조가 남아 있으면 새 목록으로 복사해서 바꿈(copy-on-write)
+* 즉 reactor가 보고 있는 목록은 절대 바뀌지 않으므로 읽는 쪽에 락이 필요 없음
+*/
+typedef struct member_set {
+	atomic_int refcnt;
+	int count;
+	int cap;
+	room_member_t members[];
+} member_set_t;
+
+member_set_t* member_set_alloc(int cap);
+member_set_t* member_set_copy(const member_set_t* src, int cap);
+
+member_set_t* member_set_ref(member_set_t* s);
+void member_set_release(member_set_t* s);
+
+#endif
@@ -0,0 +1,341 @@
+#define _GNU_SOURCE
+
+#include "metrics.h"
+#include "job_queue.h"
+#include "net.h"
+#include "conn_table.h"
+#include "log.h"
+
+#include <stdarg.h>
+#include <sys/un.h>
+
+/* 지표 블록을 가질 수 있는 최대 스레드 수 */
+#define METRICS_MAX_THREADS 64
+
+/* admin 응답 버퍼 크기 */
+#define METRICS_OUT_SIZE (32 * 1024)
+
+extern job_queue_t g_logic_q[WORKER_THREAD_NUM];
+
+__thread metrics_thread_t* t_metrics;
+static __thread bool t_metrics_failed;
+
+static metrics_thread_t* blocks[METRICS_MAX_THREADS];
+static atomic_int block_count;
+
+static int admin_fd = -1;
+static pthread_t admin_tid;
+static char admin_path_buf[108];
+
+static const char* pkt_type_name[METRIC_PKT_TYPES] = {
+	"other", "chat", "join_room", "leave_room", "game_action", "game_result", "heartbeat", "bundle"
+};
+
+static const char* disc_reason_name[DISC_REASON_COUNT] = {
+	"peer_closed", "recv_error", "protocol", "send_failed", "socket_error", "setup_failed", "rate_limited", "idle_timeout", "join_timeout"
+};
+
+/* 속도 제한 대상 이름 (0번은 연결 전체 한도) */
+static const char* rate_limit_name[RATE_LIMITS] = {
+	"connection", "chat", "join_room", "leave_room", "game_action", "game_result"
+};
+
+static const char* rl_action_name[RL_ACTION_COUNT] = {
+	"pass", "drop", "delay", "disconnect"
+};
+
+static const char* hist_name[MH_COUNT] = {
+	"recv_to_logic", "logic_to_send", "game_tick_jitter", "game_tick_run"
+};
+
+/* 현재 스레드의 지표 블록을 만들어 등록하는 함수 */
+metrics_thread_t* metrics_register(void) {
+	if (t_metrics_failed)
+		return NULL;
+
+	int id = atomic_fetch_add(&block_count, 1);
+	metrics_thread_t* m = (id < METRICS_MAX_THREADS) ? aligned_alloc(64, sizeof(metrics_thread_t)) : NULL;
+	if (!m) {
+		t_metrics_failed = true;
+		return NULL;
+	}
+
+	memset(m, 0, sizeof(*m));
+	__atomic_store_n(&blocks[id], m, __ATOMIC_RELEASE);
+	t_metrics = m;
+	return m;
+}
+
+/* 값(ns)이 들어갈 히스토그램 칸 번호 */
+static int hist_bucket(uint64_t v) {
+	if (v >= (1ull << HIST_MAX_BITS))
+		return HIST_BUCKETS - 1;
+	if (v < HIST_SUB)
+		return (int)v;
+
+	int msb = 63 - __builtin_clzll(v);
+	int e = msb - HIST_SUB_BITS + 1;
+	return e * HIST_SUB + (int)((v >> (e - 1)) - HIST_SUB);
+}
+
+/* 칸 하나가 나타내는 값 범위의 상한 */
+static uint64_t hist_bucket_upper(int idx) {
+	int e = idx / HIST_SUB;
+	uint64_t m = idx % HIST_SUB;
+	if (e == 0)
+		return m;
+	return ((HIST_SUB + m + 1) << (e - 1)) - 1;
+}
+
+void metric_record(metric_hist_t h, uint64_t value_ns) {
+	metrics_thread_t* m = metrics_local();
+	if (!m)
+		return;
+
+	metric_histogram_t* hs = &m->hist[h];
+	int b = hist_bucket(value_ns);
+	__atomic_store_n(&hs->buckets[b], hs->buckets[b] + 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&hs->count, hs->count + 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&hs->sum, hs->sum + value_ns, __ATOMIC_RELAXED);
+	if (value_ns > hs->max)
+		__atomic_store_n(&hs->max, value_ns, __ATOMIC_RELAXED);
+}
+
+/* 응답 텍스트 버퍼 */
+typedef struct {
+	char data[METRICS_OUT_SIZE];
+	size_t len;
+} metrics_out_t;
+
+static void out_printf(metrics_out_t* out, const char* fmt, ...) {
+	if (out->len >= sizeof(out->data))
+		return;
+
+	va_list ap;
+	va_start(ap, fmt);
+	int n = vsnprintf(out->data + out->len, sizeof(out->data) - out->len, fmt, ap);
+	va_end(ap);
+
+	if (n > 0)
+		out->len += ((size_t)n < sizeof(out->data) - out->len) ? (size_t)n : sizeof(out->data) - out->len;
+}
+
+/* 합산한 히스토그램에서 q 분위수에 해당하는 칸의 상한 */
+static uint64_t hist_quantile(const metric_histogram_t* h, double q) {
+	if (h->count == 0)
+		return 0;
+
+	uint64_t target = (uint64_t)(q * (double)h->count);
+	if (target >= h->count)
+		target = h->count - 1;
+
+	uint64_t seen = 0;
+	for (int i = 0; i < HIST_BUCKETS; ++i) {
+		seen += h->buckets[i];
+		if (seen > target)
+			return hist_bucket_upper(i) < h->max ? hist_bucket_upper(i) : h->max;
+	}
+	return h->max;
+}
+
+/*
+* 모든 스레드 블록을 합산해 텍스트로 만드는 함수 (admin thread 전용)
+* 한 줄에 "이름{라벨} 값" 하나씩 기록하는 Prometheus text 형식
+*/
+static void metrics_render(metrics_out_t* out) {
+	static uint64_t counters[MC_COUNT];
+	static metric_histogram_t hist[MH_COUNT];
+
+	memset(counters, 0, sizeof(counters));
+	memset(hist, 0, sizeof(hist));
+
+	int n = atomic_load(&block_count);
+	if (n > METRICS_MAX_THREADS)
+		n = METRICS_MAX_THREADS;
+
+	for (int t = 0; t < n; ++t) {
+		metrics_thread_t* m = __atomic_load_n(&blocks[t], __ATOMIC_ACQUIRE);
+		if (!m)
+			continue;
+
+		for (int c = 0; c < MC_COUNT; ++c)
+			counters[c] += __atomic_load_n(&m->counters[c], __ATOMIC_RELAXED);
+
+		for (int h = 0; h < MH_COUNT; ++h) {
+			metric_histogram_t* src = &m->hist[h];
+			hist[h].count += __atomic_load_n(&src->count, __ATOMIC_RELAXED);
+			hist[h].sum += __atomic_load_n(&src->sum, __ATOMIC_RELAXED);
+			uint64_t mx = __atomic_load_n(&src->max, __ATOMIC_RELAXED);
+			if (mx > hist[h].max)
+				hist[h].max = mx;
+			for (int b = 0; b < HIST_BUCKETS; ++b)
+				hist[h].buckets[b] += __atomic_load_n(&src->buckets[b], __ATOMIC_RELAXED);
+		}
+	}
+
+	out_printf(out, "accepts_total %llu\n", (unsigned long long)counters[MC_ACCEPTS]);
+	out_printf(out, "bytes_in_total %llu\n", (unsigned long long)counters[MC_BYTES_IN]);
+	out_printf(out, "bytes_out_total %llu\n", (unsigned long long)counters[MC_BYTES_OUT]);
+
+	for (int i = 0; i < METRIC_PKT_TYPES; ++i)
+		out_printf(out, "packets_in_total{type=\"%s\"} %llu\n", pkt_type_name[i], (unsigned long long)counters[MC_PKT_IN + i]);
+	for (int i = 0; i < METRIC_PKT_TYPES; ++i)
+		out_printf(out, "packets_out_total{type=\"%s\"} %llu\n", pkt_type_name[i], (unsigned long long)counters[MC_PKT_OUT + i]);
+	for (int i = 0; i < DISC_REASON_COUNT; ++i)
+		out_printf(out, "disconnects_total{reason=\"%s\"} %llu\n", disc_reason_name[i], (unsigned long long)counters[MC_DISCONNECTS + i]);
+
+	for (int i = 0; i < RATE_LIMITS; ++i) {
+		for (int a = RL_DROP; a < RL_ACTION_COUNT; ++a)
+			out_printf(out, "rate_limited_total{limit=\"%s\",action=\"%s\"} %llu\n", rate_limit_name[i], rl_action_name[a],
+				(unsigned long long)counters[MC_RATE_LIMITED + i * (RL_ACTION_COUNT - 1) + (a - 1)]);
+	}
+
+	out_printf(out, "accepts_shed_total %llu\n", (unsigned long long)counters[MC_ACCEPTS_SHED]);
+	out_printf(out, "reads_paused_total %llu\n", (unsigned long long)counters[MC_READS_PAUSED]);
+	out_printf(out, "reads_resumed_total %llu\n", (unsigned long long)counters[MC_READS_RESUMED]);
+	out_printf(out, "recv_budget_exhausted_total %llu\n", (unsigned long long)counters[MC_RECV_BUDGET_EXHAUSTED]);
+	out_printf(out, "disconnects_deferred_total %llu\n", (unsigned long long)counters[MC_DISCONNECTS_DEFERRED]);
+	out_printf(out, "room_jobs_deferred_total %llu\n", (unsigned long long)counters[MC_ROOM_JOBS_DEFERRED]);
+	out_printf(out, "heartbeats_sent_total %llu\n", (unsigned long long)counters[MC_HEARTBEATS_SENT]);
+	out_printf(out, "timers_fired_total %llu\n", (unsigned long long)counters[MC_TIMERS_FIRED]);
+	out_printf(out, "send_calls_total %llu\n", (unsigned long long)counters[MC_SEND_CALLS]);
+	out_printf(out, "game_rooms_active %lld\n", (long long)(counters[MC_GAME_ROOMS_STARTED] - counters[MC_GAME_ROOMS_STOPPED]));
+	out_printf(out, "game_ticks_total %llu\n", (unsigned long long)counters[MC_GAME_TICKS]);
+	out_printf(out, "game_ticks_skipped_total %llu\n", (unsigned long long)counters[MC_GAME_TICKS_SKIPPED]);
+	out_printf(out, "game_actions_dropped_total %llu\n", (unsigned long long)counters[MC_GAME_ACTIONS_DROPPED]);
+	out_printf(out, "send_overflows_total %llu\n", (unsigned long long)counters[MC_SEND_OVERFLOWS]);
+	out_printf(out, "stale_handles_total %llu\n", (unsigned long long)counters[MC_STALE_HANDLES]);
+	out_printf(out, "sessions_created_total %llu\n", (unsigned long long)counters[MC_SESSIONS_CREATED]);
+	out_printf(out, "sessions_active %lld\n", (long long)(counters[MC_SESSIONS_CREATED] - counters[MC_SESSIONS_REMOVED]));
+	out_printf(out, "rooms_created_total %llu\n", (unsigned long long)counters[MC_ROOMS_CREATED]);
+	out_printf(out, "rooms_closed_total %llu\n", (unsigned long long)counters[MC_ROOMS_CLOSED]);
+	out_printf(out, "rooms_open %lld\n", (long long)(counters[MC_ROOMS_CREATED] - counters[MC_ROOMS_CLOSED]));
+	out_printf(out, "room_members %lld\n", (long long)(counters[MC_ROOM_JOINS] - counters[MC_ROOM_LEAVES]));
+	out_printf(out, "io_buffer_bytes_held %lld\n", (long long)(counters[MC_IO_BUF_ACQUIRED] - counters[MC_IO_BUF_RELEASED]));
+	out_printf(out, "io_buffer_bytes_allocated %llu\n", (unsigned long long)counters[MC_IO_BUF_ALLOCATED]);
+	out_printf(out, "connections_limit %d\n", conn_table_limit());
+	out_printf(out, "connection_slots %d\n", slot_map_capacity(&g_conn_slots));
+
+	for (int i = 0; i < WORKER_THREAD_NUM; ++i) {
+		out_printf(out, "logic_queue_depth{worker=\"%d\"} %d\n", i, __atomic_load_n(&g_logic_q[i].count, __ATOMIC_RELAXED));
+		out_printf(out, "logic_queue_hwm{worker=\"%d\"} %d\n", i, __atomic_load_n(&g_logic_q[i].hwm, __ATOMIC_RELAXED));
+		out_printf(out, "logic_room_jobs_parked{worker=\"%d\"} %d\n", i, __atomic_load_n(&g_logic_q[i].parked, __ATOMIC_RELAXED));
+	}
+
+	for (int i = 0; i < NET_THREAD_NUM; ++i) {
+		size_t depth, hwm;
+		net_io_queue_stats(i, &depth, &hwm);
+		out_printf(out, "io_queue_depth{reactor=\"%d\"} %zu\n", i, depth);
+		out_printf(out, "io_queue_hwm{reactor=\"%d\"} %zu\n", i, hwm);
+	}
+
+	static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+	for (int h = 0; h < MH_COUNT; ++h) {
+		for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); ++q) {
+			out_printf(out, "latency_ns{path=\"%s\",quantile=\"%g\"} %llu\n", hist_name[h], quantiles[q],
+				(unsigned long long)hist_quantile(&hist[h], quantiles[q]));
+		}
+		out_printf(out, "latency_ns_max{path=\"%s\"} %llu\n", hist_name[h], (unsigned long long)hist[h].max);
+		out_printf(out, "latency_ns_sum{path=\"%s\"} %llu\n", hist_name[h], (unsigned long long)hist[h].sum);
+		out_printf(out, "latency_ns_count{path=\"%s\"} %llu\n", hist_name[h], (unsigned long long)hist[h].count);
+	}
+}
+
+/*
+* admin thread
+* 접속한 클라이언트마다 합산한 지표를 한 번 써 주고 연결을 닫음 (예: socat - UNIX-CONNECT:경로)
+*/
+static void* admin_thread(void* arg) {
+	(void)arg;
+	static metrics_out_t out;
+
+	for (;;) {
+		int cfd = accept4(admin_fd, NULL, NULL, SOCK_CLOEXEC);
+		if (cfd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			break;		// metrics_stop에서 shutdown한 경우
+		}
+
+		out.len = 0;
+		metrics_render(&out);
+
+		size_t off = 0;
+		while (off < out.len) {
+			ssize_t n = write(cfd, out.data + off, out.len - off);
+			if (n < 0) {
+				if (errno == EINTR)
+					continue;
+				break;
+			}
+			off += (size_t)n;
+		}
+		close(cfd);
+	}
+
+	return NULL;
+}
+
+/*
+* admin Unix 소켓을 열고 admin thread를 시작하는 함수
+* 게임 포트와 분리된 로컬 소켓이므로 외부에서는 접근할 수 없음
+*/
+int metrics_start(const char* admin_path) {
+	struct sockaddr_un addr;
+
+	if (strlen(admin_path) >= sizeof(addr.sun_path))
+		return -1;
+
+	admin_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (admin_fd < 0)
+		return -1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, admin_path);
+	strcpy(admin_path_buf, admin_path);
+
+	/* 이전 실행이 남긴 소켓 파일 제거 */
+	unlink(admin_path);
+
+	if (bind(admin_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(admin_fd, 16) < 0) {
+		close(admin_fd);
+		admin_fd = -1;
+		return -1;
+	}
+
+	/* 종료 시그널이 admin thread로 전달되지 않도록 막은 상태로 생성 */
+	sigset_t set, old;
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &set, &old);
+
+	int rc = pthread_create(&admin_tid, NULL, admin_thread, NULL);
+
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	if (rc != 0) {
+		close(admin_fd);
+		admin_fd = -1;
+		unlink(admin_path);
+		return -1;
+	}
+
+	LOG_INFO("metrics admin socket listening on %s", LOG_STR(admin_path_buf));
+	return 0;
+}
+
+/* admin thread 종료 및 소켓 파일 제거 */
+void metrics_stop(void) {
+	if (admin_fd < 0)
+		return;
+
+	/* accept 중인 admin thread를 깨우기 위해 shutdown */
+	shutdown(admin_fd, SHUT_RDWR);
+	pthread_join(admin_tid, NULL);
+
+	close(admin_fd);
+	admin_fd = -1;
+	unlink(admin_path_buf);
+}
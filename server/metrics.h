@@ -0,0 +1,126 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "common.h"
+
+/*
+* 런타임 지표
+* 카운터와 히스토그램은 스레드마다 캐시 라인 정렬된 블록에 따로 두어 스레드끼리 같은 라인을 두고 경쟁하지 않음
+* 각 스레드는 자기 블록에만 쓰고, admin 소켓으로 요청이 오면 모든 블록을 합산해 텍스트로 내보냄
+*/
+
+/* 패킷 타입별 카운터 칸 수 (0 : 알 수 없는 타입, 1~ : packet_type_t) */
+#define METRIC_PKT_TYPES (PKT_BUNDLE + 1)
+
+/* 연결 종료 원인 */
+typedef enum {
+	DISC_PEER_CLOSED,		// 상대가 정상 종료 (recv == 0)
+	DISC_RECV_ERROR,		// recv 에러
+	DISC_PROTOCOL,			// 프로토콜 위반
+	DISC_SEND_FAILED,		// 송신 에러 또는 송신 큐 한도 초과
+	DISC_SOCKET_ERROR,		// EPOLLERR / EPOLLHUP
+	DISC_SETUP_FAILED,		// 연결 등록 실패
+	DISC_RATE_LIMITED,		// 수신 속도 제한 초과 (RL_DISCONNECT)
+	DISC_IDLE_TIMEOUT,		// IDLE_TIMEOUT_MS 동안 아무것도 받지 못함
+	DISC_JOIN_TIMEOUT,		// JOIN_DEADLINE_MS 안에 방에 들어가지 않음
+	DISC_REASON_COUNT
+} disc_reason_t;
+
+typedef enum {
+	MC_ACCEPTS,
+	MC_BYTES_IN,
+	MC_BYTES_OUT,
+	MC_SEND_OVERFLOWS,				// 송신 큐 한도 초과
+	MC_STALE_HANDLES,				// 이미 끊긴 연결의 handle로 온 작업/조회 (버려짐)
+	MC_SESSIONS_CREATED,
+	MC_SESSIONS_REMOVED,
+	MC_ROOMS_CREATED,
+	MC_ROOMS_CLOSED,
+	MC_ROOM_JOINS,
+	MC_ROOM_LEAVES,
+	MC_IO_BUF_ACQUIRED,				// 연결이 빌려 간 I/O 버퍼 바이트 (io_buf.c)
+	MC_IO_BUF_RELEASED,				// 연결이 돌려준 I/O 버퍼 바이트
+	MC_IO_BUF_ALLOCATED,			// 풀이 malloc으로 새로 만든 I/O 버퍼 바이트
+	MC_READS_PAUSED,				// worker 큐 적체로 연결의 읽기를 멈춘 횟수 (flow.c)
+	MC_READS_RESUMED,				// 멈춘 읽기를 다시 시작한 횟수
+	MC_RECV_BUDGET_EXHAUSTED,		// 수신 예산을 다 써 다음 루프로 미룬 횟수 (net.c)
+	MC_ACCEPTS_SHED,				// 과부하로 accept 직후 닫은 연결
+	MC_DISCONNECTS_DEFERRED,		// worker 큐가 가득 차 나중에 넣은 끊김 이벤트
+	MC_ROOM_JOBS_DEFERRED,			// 방 소유 worker 큐가 가득 차 나중에 넣은 방 작업 (logic.c)
+	MC_HEARTBEATS_SENT,				// 조용한 연결에 보낸 PKT_HEARTBEAT
+	MC_TIMERS_FIRED,				// 만료된 타이머 (reactor와 worker 휠 합계)
+	MC_SEND_CALLS,					// 송신 시스템 콜 (writev / sendmsg 요청), 패킷 수와 비교해 합치기 효과를 봄
+	MC_GAME_ROOMS_STARTED,			// 게임 tick을 시작한 방 (game.c)
+	MC_GAME_ROOMS_STOPPED,
+	MC_GAME_TICKS,					// 실행한 게임 tick
+	MC_GAME_TICKS_SKIPPED,			// 한 주기 이상 늦어 건너뛴 tick
+	MC_GAME_ACTIONS_DROPPED,		// tick 입력 버퍼가 가득 차 버린 PKT_GAME_ACTION
+	MC_PKT_IN,						// + 패킷 타입
+	MC_PKT_OUT = MC_PKT_IN + METRIC_PKT_TYPES,
+	MC_DISCONNECTS = MC_PKT_OUT + METRIC_PKT_TYPES,	// + disc_reason_t
+	MC_RATE_LIMITED = MC_DISCONNECTS + DISC_REASON_COUNT,	// + 제한 대상 x (RL_ACTION_COUNT - 1) + (rl_action_t - 1)
+	MC_COUNT = MC_RATE_LIMITED + RATE_LIMITS * (RL_ACTION_COUNT - 1)
+} metric_counter_t;
+
+/* 지연 시간 히스토그램 종류 */
+typedef enum {
+	MH_RECV_TO_LOGIC,				// reactor가 패킷을 파싱한 시점 -> worker가 꺼낸 시점
+	MH_LOGIC_TO_SEND,				// worker가 프레임을 만든 시점 -> reactor가 송신 큐에 넣은 시점
+	MH_GAME_TICK_JITTER,			// 게임 tick 예정 시각 -> 실제로 실행한 시각
+	MH_GAME_TICK_RUN,				// 게임 tick 하나의 시뮬레이션 + 결과 전송 시간
+	MH_COUNT
+} metric_hist_t;
+
+/*
+* HDR 방식 로그-선형 히스토그램
+* 2의 거듭제곱 구간마다 HIST_SUB개의 칸으로 나눠 값의 크기와 관계없이 상대 오차가 1/HIST_SUB 이내로 유지됨
+* ns 단위로 HIST_MAX_BITS 비트(약 18분)까지 기록하며 그 이상은 마지막 칸에 넣음
+*/
+#define HIST_SUB_BITS 4
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS 40
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 1) * HIST_SUB)
+
+typedef struct {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t buckets[HIST_BUCKETS];
+} metric_histogram_t;
+
+typedef struct metrics_thread {
+	_Alignas(64) uint64_t counters[MC_COUNT];
+	_Alignas(64) metric_histogram_t hist[MH_COUNT];
+} metrics_thread_t;
+
+extern __thread metrics_thread_t* t_metrics;
+
+metrics_thread_t* metrics_register(void);
+
+/* 현재 스레드의 지표 블록 (처음 호출 시 등록) */
+static inline metrics_thread_t* metrics_local(void) {
+	return t_metrics ? t_metrics : metrics_register();
+}
+
+/* 자기 블록에만 쓰므로 원자적 증가가 필요 없고, 합산하는 쪽이 찢어진 값을 읽지 않도록 relaxed store만 사용 */
+static inline void metric_add(int c, uint64_t n) {
+	metrics_thread_t* m = metrics_local();
+	if (m)
+		__atomic_store_n(&m->counters[c], m->counters[c] + n, __ATOMIC_RELAXED);
+}
+
+static inline void metric_inc(int c) {
+	metric_add(c, 1);
+}
+
+/* 패킷 타입을 카운터 칸으로 변환 (범위를 벗어나면 0) */
+static inline int metric_pkt_slot(uint16_t type) {
+	return (type < METRIC_PKT_TYPES) ? type : 0;
+}
+
+void metric_record(metric_hist_t h, uint64_t value_ns);
+
+int metrics_start(const char* admin_path);
+void metrics_stop(void);
+
+#endif
@@ -1,3 +1,6 @@
+/* accept4 선언을 위해 필요 */
+#define _GNU_SOURCE
+
 #include <sys/eventfd.h>
 
 #include "common.h"
@@ -5,57 +8,372 @@
 #include "protocol.h"
 #include "job_queue.h"
 #include "state.h"
-
-static int listen_fd = -1;
-static int epfd = -1;
-static int wake_fd = -1;
-
-static connection_t* connections[MAX_CLIENTS];
-
-extern job_queue_t g_io_q;
-extern job_queue_t g_logic_q;
-
-void net_wakeup(void) {
-	if (wake_fd < 0) return;
+#include "logic.h"
+#include "sbuf.h"
+#include "send_queue.h"
+#include "log.h"
+#include "metrics.h"
+#include "member_set.h"
+#include "conn_table.h"
+#include "flow.h"
+#include "rate_limit.h"
+#include "timer_wheel.h"
+#include "packet_pool.h"
+
+/* NET_IO_URING=1 빌드에서는 net_uring.c의 io_uring reactor를 사용함 */
+#if !NET_IO_URING
+
+/*
+* reactor 구조체
+* reactor마다 epoll 인스턴스, eventfd, SO_REUSEPORT listen 소켓, send 작업 ring을 따로 가짐
+* 커널이 새 연결을 listen 소켓들에 분산하고, 연결은 accept한 reactor가 끝까지 담당함
+* 즉 연결 테이블 중 자신이 등록한 연결(owner == id)만 접근하므로 reactor 사이에 락이 필요 없음
+*/
+typedef struct reactor {
+	int id;
+	int listen_fd;
+	int epfd;
+	int wake_fd;
+	pthread_t tid;
+
+	/*
+	* 깨우기 요청이 이미 걸려 있는지 표시하는 플래그
+	* reactor가 io_q를 비우기 직전에 내리므로, 한 번의 drain 주기 동안 eventfd write는 최대 한 번만 발생함
+	*/
+	atomic_bool wake_pending;
+
+	/* logic -> 이 reactor 방향의 send 작업 ring (생산자: worker들, 소비자: 이 reactor) */
+	mpsc_queue_t io_q;
+
+	/*
+	* 닫힌 연결 객체 풀
+	* 재접속이 몰릴 때 연결마다 malloc/free를 반복하지 않도록 reactor가 직접 보관했다가 재사용함
+	*/
+	connection_t* conn_pool[CONN_POOL_SIZE];
+	int conn_pool_count;
+
+	/* 이 reactor가 담당한 살아 있는 연결 목록 (종료 시 전체 테이블 대신 이 목록만 순회) */
+	connection_t* live_head;
+
+	/* worker 큐 적체로 읽기를 멈춘 연결과 미뤄둔 끊김 이벤트 (flow.h) */
+	flow_t flow;
+
+	/*
+	* 수신 예산을 다 쓰고도 읽을 데이터가 남은 연결 목록 (edge-triggered 모드 전용)
+	* 다음 루프에서 ready를 처리하는 동안 다시 예산을 다 쓴 연결은 ready_spare와 바꾼 새 목록에 쌓임
+	*/
+	handle_list_t ready;
+	handle_list_t ready_spare;
+
+	/* 송신 합치기 중 프레임이 쌓여 루프 끝에 보낼 연결 목록과 보낼 시각 (SEND_COALESCE, edge-triggered 모드 전용) */
+	handle_list_t flush;
+	uint64_t flush_at_ns;
+
+	/* 연결 유휴 / heartbeat 타이머 (epoll_wait timeout으로 다음 만료 시각까지만 기다림) */
+	timer_wheel_t timers;
+	uint64_t now_ms;				// 이번 루프에서 깨어난 시각, 수신 경로는 이 값으로 마지막 수신 시각을 갱신함
+} reactor_t;
+
+static reactor_t reactors[NET_THREAD_NUM];
+
+/*
+* epoll_event.data.u64 구성
+* 클라이언트 소켓은 연결 handle을 넣어, 같은 epoll_wait 결과 안에서 앞선 이벤트로 닫힌 연결의 이벤트가 새 연결로 가지 않게 함
+* handle은 세대가 1 이상이라 항상 2^32 이상이므로 그보다 작은 값을 listen/eventfd 표시로 씀
+*/
+#define EV_LISTEN ((uint64_t)1)
+#define EV_WAKE ((uint64_t)2)
+
+/* 한 번에 io_q에서 꺼내 처리할 send 작업 수 */
+#define IO_DRAIN_BATCH 64
+
+/*
+* 읽기를 멈춘 연결이나 미뤄둔 끊김 이벤트가 있을 때 epoll_wait 최대 대기 시간 (ms)
+* 보통은 worker가 적체가 풀릴 때 깨워 주지만, 깨우기가 겹쳐 누락되어도 이 주기로 다시 확인함
+*/
+#define FLOW_RETRY_MS 10
+
+/*
+* 유휴 검사 주기 (ms)
+* heartbeat를 쓰면 이만큼 조용한 연결에 heartbeat를 보내고, 쓰지 않으면 바로 IDLE_TIMEOUT_MS로 판정함
+*/
+#define IDLE_CHECK_MS ((HEARTBEAT_INTERVAL_MS > 0) ? HEARTBEAT_INTERVAL_MS : IDLE_TIMEOUT_MS)
+
+/* 현재 스레드가 send 작업을 넣었지만 아직 깨우지 않은 reactor 목록 (비트마스크) */
+static __thread uint64_t t_wake_mask;
+
+_Static_assert(NET_THREAD_NUM <= 64, "NET_THREAD_NUM must fit in t_wake_mask");
+
+/* reactor 하나의 eventfd에 write하여 epoll_wait를 깨우는 함수 */
+static void reactor_wakeup(reactor_t* r) {
+	if (r->wake_fd < 0) return;
+
+	/* 이미 깨우기가 예약되어 있으면 reactor가 drain할 때 함께 처리되므로 생략 */
+	if (atomic_exchange_explicit(&r->wake_pending, true, memory_order_acq_rel))
+		return;
 
 	uint64_t one = 1;
 
 	for (;;) {
-		ssize_t rc = write(wake_fd, &one, sizeof(one));
+		ssize_t rc = write(r->wake_fd, &one, sizeof(one));
 		if (rc == (ssize_t)sizeof(one)) {
-			return;                 // 
+			return;                 // 정상
 		}
 		if (rc < 0) {
-			if (errno == EINTR) continue;  // ñ׳η  -> õ
-			if (errno == EAGAIN) return;   //  + ī ȭ ->  ص ġ ƴ
-			return;                         // ʿϸ perror/log
+			if (errno == EINTR) continue;  // 시그널로 끊김 -> 재시도
+			if (errno == EAGAIN) return;   // 논블록 + 카운터 포화 -> 깨우기 실패해도 치명적 아님
+			return;                         // 필요하면 perror/log
 		}
-		return; // (̷л) κ write 
+		return; // (이론상) 부분 write 방어
 	}
 }
 
-static void close_connection(int fd)
+/* 현재 스레드가 send 작업을 넣은 reactor들을 한 번씩 깨우는 함수 */
+void net_wakeup(void) {
+	uint64_t mask = t_wake_mask;
+	t_wake_mask = 0;
+
+	for (int i = 0; mask; ++i, mask >>= 1) {
+		if (mask & 1)
+			reactor_wakeup(&reactors[i]);
+	}
+}
+
+/* 모든 reactor를 깨우는 함수 (worker 큐 적체가 풀렸을 때 멈춘 읽기를 다시 확인하게 함) */
+void net_wakeup_all(void) {
+	t_wake_mask |= (NET_THREAD_NUM == 64) ? ~0ull : ((uint64_t)1 << NET_THREAD_NUM) - 1;
+	net_wakeup();
+}
+
+/*
+* send 작업 하나를 대상 fd를 담당하는 reactor의 io_q에 넣는 함수 (logic thread에서 호출)
+* ring이 가득 차 있으면 reactor를 깨워 비우게 하고 자리가 날 때까지 양보하며 재시도
+* 정상적인 경우 깨우기는 호출자가 여러 작업을 넣은 뒤 net_wakeup()으로 reactor당 한 번만 수행함
+*/
+void net_push_send(job_t* job) {
+	int owner = conn_table_owner(job->handle);
+
+	/* 담당 reactor가 없는 연결은 이미 끊긴 연결이므로 프레임 참조만 반납 */
+	if (owner < 0) {
+		sbuf_release(job->buf);
+		return;
+	}
+
+	reactor_t* r = &reactors[owner];
+	while (!mpsc_queue_try_push(&r->io_q, job)) {
+		reactor_wakeup(r);
+		sched_yield();
+	}
+
+	t_wake_mask |= (uint64_t)1 << owner;
+}
+
+void net_close(conn_handle_t handle, int reason) {
+	job_t job = { 0 };
+	job.type = JOB_CLOSE;
+	job.reason = reason;
+	job.handle = handle;
+	net_push_send(&job);
+}
+
+/*
+* 방 멤버 목록 전체에 프레임을 보내는 작업을 모든 reactor의 io_q에 넣는 함수 (logic thread에서 호출)
+* 각 reactor는 프레임과 목록의 참조를 하나씩 받아 자신이 담당한 fd에만 보내므로, 대상 수와 관계없이 push는 reactor 수만큼만 발생함
+*/
+void net_push_multicast(sbuf_t* frame, member_set_t* members, conn_handle_t exclude) {
+	job_t job = { 0 };
+	job.type = JOB_MULTICAST;
+	job.handle = exclude;
+
+	for (int i = 0; i < NET_THREAD_NUM; ++i) {
+		reactor_t* r = &reactors[i];
+		job.buf = sbuf_ref(frame);
+		job.members = member_set_ref(members);
+
+		while (!mpsc_queue_try_push(&r->io_q, &job)) {
+			reactor_wakeup(r);
+			sched_yield();
+		}
+	}
+
+	t_wake_mask |= (NET_THREAD_NUM == 64) ? ~0ull : ((uint64_t)1 << NET_THREAD_NUM) - 1;
+}
+
+static void conn_idle_expired(void* arg);
+
+/*
+* 연결 객체 확보 함수
+* 풀에 남은 객체가 있으면 재사용하고, 수신 버퍼는 데이터가 들어올 때 빌려 오므로 비워 둠
+*/
+static connection_t* conn_get(reactor_t* r, int fd) {
+	connection_t* conn = (r->conn_pool_count > 0) ? r->conn_pool[--r->conn_pool_count] : malloc(sizeof(connection_t));
+	if (!conn)
+		return NULL;
+
+	conn->fd = fd;
+	conn->handle = HANDLE_NONE;
+	conn->owner = r->id;
+	conn->recv_buf = NULL;
+	conn->recv_head = 0;
+	conn->recv_len = 0;
+	conn->paused = conn->paused_by_queue = false;
+	conn->stalled_head = conn->stalled_tail = NULL;
+	conn->ready = false;
+	conn->heavy = false;
+	rate_limit_init(conn, monotonic_ms());
+	conn->last_active = r->now_ms;
+	timer_init(&conn->idle_timer, conn_idle_expired, conn);
+	send_queue_init(&conn->sendq);
+	conn->want_write = false;
+	conn->flush_pending = false;
+	return conn;
+}
+
+/* 연결 객체 반납 함수, 풀이 가득 차 있으면 해제 */
+static void conn_put(reactor_t* r, connection_t* conn) {
+	if (r->conn_pool_count < CONN_POOL_SIZE)
+		r->conn_pool[r->conn_pool_count++] = conn;
+	else
+		free(conn);
+}
+
+/* reactor의 살아 있는 연결 목록에 넣는 함수 */
+static void conn_link(reactor_t* r, connection_t* conn) {
+	conn->live_prev = NULL;
+	conn->live_next = r->live_head;
+	if (r->live_head)
+		r->live_head->live_prev = conn;
+	r->live_head = conn;
+}
+
+static void conn_unlink(reactor_t* r, connection_t* conn) {
+	if (conn->live_prev)
+		conn->live_prev->live_next = conn->live_next;
+	else
+		r->live_head = conn->live_next;
+	if (conn->live_next)
+		conn->live_next->live_prev = conn->live_prev;
+}
+
+/*
+* 연결의 현재 상태에 맞는 epoll 관심 이벤트
+* edge-triggered 모드에서는 쓰기 관심을 계속 유지하고, 읽기를 멈춘 동안만 EPOLLIN을 뺌
+* level-triggered 모드에서는 보낼 데이터가 남아 있을 때만 EPOLLOUT을 켬
+*/
+static uint32_t conn_events(connection_t* conn) {
+	uint32_t events = conn->paused ? 0 : EPOLLIN;
+#if NET_EDGE_TRIGGERED
+	events |= EPOLLOUT | EPOLLET;
+#else
+	if (conn->sendq.count > 0)
+		events |= EPOLLOUT;
+#endif
+	return events;
+}
+
+static int conn_update_events(reactor_t* r, connection_t* conn) {
+	struct epoll_event ev;
+	ev.events = conn_events(conn);
+	ev.data.u64 = conn->handle;
+	return epoll_ctl(r->epfd, EPOLL_CTL_MOD, conn->fd, &ev);
+}
+
+static void close_connection(reactor_t* r, connection_t* conn)
 {
-	connection_t* conn = connections[fd];
-	if (!conn) return;
+	int fd = conn->fd;
+
+	epoll_ctl(r->epfd, EPOLL_CTL_DEL, fd, NULL);
+	timer_cancel(&r->timers, &conn->idle_timer);
 
-	epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+	/* 테이블에서 먼저 내려야 이후 이 handle로 오는 작업이 닫힌 소켓에 닿지 않음 */
+	conn_table_free(conn->handle);
+	conn_unlink(r, conn);
 	close(fd);
-	free(conn);
-	connections[fd] = NULL;
 
-	printf("[INFO] Connection closed fd=%d\n", fd);
+	/* 아직 보내지 못한 프레임의 참조와 빌린 버퍼 반납 */
+	send_queue_clear(&conn->sendq);
+	protocol_release(conn, true);
+	flow_drop_stalled(conn);
+
+	conn_put(r, conn);
+
+	LOG_INFO("Connection closed fd=%d reactor=%d", fd, r->id);
 }
 
-static void net_disconnect(int fd)
+/* 살아 있는 연결을 닫고 worker에게 끊김을 알리는 함수 (연결 객체는 반납되므로 이후 conn을 쓰면 안 됨) */
+static void net_disconnect(reactor_t* r, connection_t* conn, disc_reason_t reason)
 {
-	if (fd < 0 || fd >= MAX_CLIENTS) return;
+	conn_handle_t handle = conn->handle;
+
+	// 네트워크 리소스 정리
+	metric_inc(MC_DISCONNECTS + reason);
+	close_connection(r, conn);
+
+	// 상태 정리는 워커에게 맡김 (큐가 가득 차 있으면 미뤘다가 다시 넣음)
+	flow_notify_disconnect(&r->flow, handle);
+}
+
+/*
+* listen 소켓에 쌓인 연결을 accept하는 함수
+* accept4로 논블로킹/CLOEXEC 설정까지 한 번에 처리하고, EAGAIN이 나올 때까지 반복하되
+* 한 번에 최대 ACCEPT_BATCH개만 받아 기존 클라이언트의 이벤트 처리가 밀리지 않게 함
+* listen 소켓은 level-triggered로 등록되어 있으므로 남은 연결은 다음 epoll_wait에서 다시 알려줌
+* worker 큐가 HIGH 수위 이상이면 받은 연결을 바로 닫아, 적체가 풀릴 때까지 새 세션이 부하를 더하지 않게 함
+* (받지 않고 두면 listen 소켓이 계속 readable로 깨우므로 받은 뒤 닫음)
+*/
+static void accept_connections(reactor_t* r) {
+	for (int i = 0; i < ACCEPT_BATCH; ++i) {
+		struct sockaddr_in client_addr;
+		socklen_t clilen = sizeof(client_addr);
+
+		int client_fd = accept4(r->listen_fd, (struct sockaddr*)&client_addr, &clilen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		if (client_fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				LOG_ERROR("accept error: %E", errno);
+			return;
+		}
+
+		if (logic_overloaded()) {
+			metric_inc(MC_ACCEPTS_SHED);
+			close(client_fd);
+			continue;
+		}
+
+		connection_t* conn = conn_get(r, client_fd);
+		if (!conn) {
+			close(client_fd);
+			continue;
+		}
+
+		conn->handle = conn_table_alloc(r->id, conn);
+		if (conn->handle == HANDLE_NONE) {
+			LOG_WARN("connection table full (limit=%d), closing fd=%d", conn_table_limit(), client_fd);
+			conn_put(r, conn);
+			close(client_fd);
+			continue;
+		}
+
+		conn_link(r, conn);
+		metric_inc(MC_ACCEPTS);
+
+		if (IDLE_TIMEOUT_MS > 0)
+			timer_arm(&r->timers, &conn->idle_timer, r->now_ms + IDLE_CHECK_MS);
 
-	// Ʈũ ҽ 
-	if (connections[fd]) close_connection(fd);
+		LOG_INFO("Client info : %I:%d (fd=%d reactor=%d)", client_addr.sin_addr.s_addr, ntohs(client_addr.sin_port), client_fd, r->id);
 
-	//   Ŀ ñ
-	job_queue_push_disconnect(&g_logic_q, fd);
+		/* edge-triggered 모드에서는 읽기를 멈출 때 외에는 관심 이벤트를 바꾸지 않음 */
+		struct epoll_event cev;
+		cev.events = conn_events(conn);
+		cev.data.u64 = conn->handle;
+		if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, client_fd, &cev) < 0) {
+			LOG_ERROR("epoll_ctl add client error: %E", errno);
+			metric_inc(MC_DISCONNECTS + DISC_SETUP_FAILED);
+			close_connection(r, conn);
+		}
+	}
 }
 
 static int set_nonblocking(int fd) {
@@ -65,79 +383,237 @@ static int set_nonblocking(int fd) {
 	return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
 }
 
-int packet_send(int fd, packet_t* pkt) {
-	connection_t* conn = connections[fd];
-	if (!conn)
+#if NET_EDGE_TRIGGERED
+/*
+* 송신 합치기 : 연결을 reactor의 flush 목록에 올리는 함수 (이미 올라 있으면 그대로)
+* 목록이 비어 있다가 처음 올라간 시각부터 SEND_COALESCE_WINDOW_MS 뒤에 목록 전체를 보냄, 목록을 늘리지 못하면 -1
+*/
+static int conn_mark_flush(reactor_t* r, connection_t* conn) {
+	if (conn->flush_pending)
+		return 0;
+	if (handle_list_push(&r->flush, conn->handle) < 0)
 		return -1;
 
-	/* pkt->length (type + payload)  */
-	if (pkt->length < 2 || pkt->length > MAX_PACKET_SIZE + 2)
-		return -1;
+	if (r->flush.count == 1)
+		r->flush_at_ns = monotonic_ns() + (uint64_t)SEND_COALESCE_WINDOW_MS * 1000000;
+	conn->flush_pending = true;
+	return 0;
+}
+#endif
+
+/*
+* 직렬화된 프레임 참조를 연결의 송신 큐에 넣는 함수 (연결을 담당하는 reactor에서만 호출)
+* 프레임은 복사하지 않고 참조만 보관하며, 호출자의 참조는 성공/실패와 관계없이 이 함수가 가져감
+* 송신 큐가 한도(send_queue_check_limit)를 넘었거나 소켓 에러가 나면 -1 반환
+*/
+static int packet_send(connection_t* conn, sbuf_t* buf) {
+	if (buf->len >= 4) {
+		uint16_t net_type;
+		memcpy(&net_type, buf->data + 2, 2);
+		metric_inc(MC_PKT_OUT + metric_pkt_slot(ntohs(net_type)));
+	}
 
-	int payload_len = pkt->length - 2;
-	if (payload_len < 0)
+	if (send_queue_push(&conn->sendq, buf) < 0) {
+		sbuf_release(buf);
 		return -1;
+	}
 
-	int total_len = 2 + pkt->length; // length(2) + (type + payload)
-
-	if (conn->send_len + total_len > SEND_BUF_SIZE)
-		return -1;
+#if NET_EDGE_TRIGGERED
+	/*
+	* write-through : 쓰기 대기 중이 아니면 바로 전송 시도
+	* 소켓 버퍼가 가득 차 일부가 남은 경우에만 want_write를 켜고, 이후 EPOLLOUT edge에서 이어서 보냄
+	* 쓰기 대기 중이면 앞선 데이터가 아직 못 나간 상태이므로 큐에만 넣음
+	* 송신 합치기를 켜면 바로 보내지 않고 flush 목록에 올려 루프 끝(flush_coalesced)에서 쌓인 프레임을 한 번에 보냄
+	*/
+	if (!conn->want_write && !(SEND_COALESCE && conn_mark_flush(&reactors[conn->owner], conn) == 0)) {
+		if (send_queue_flush(&conn->sendq, conn->fd) < 0)
+			return -1;
+		conn->want_write = (conn->sendq.count > 0);
+	}
+#else
+	// EPOLLOUT 활성화
+	conn_update_events(&reactors[conn->owner], conn);
+#endif
 
-	/* ===  ȭ  === */
-	uint16_t net_len = htons(pkt->length);
-	uint16_t net_type = htons(pkt->type);
+	/* 보내고 남은 양이 한도를 넘으면 계속 읽지 않는 클라이언트로 보고 실패 처리 */
+	return send_queue_check_limit(&conn->sendq, monotonic_ms());
+}
 
-	/* length */
-	memcpy(conn->send_buf + conn->send_len, &net_len, 2);
+static void handle_send_job(reactor_t* r, job_t* job, uint64_t now_ns)
+{
+	/*
+	* 이미 끊긴 경우 → 조용히 무시 (프레임 참조만 반납)
+	* 작업이 ring에 있는 동안 연결이 닫히고 id가 재사용됐을 수 있으므로 담당 reactor와 handle 세대까지 확인
+	*/
+	connection_t* conn = conn_table_lookup(job->handle, r->id);
+	if (!conn) {
+		metric_inc(MC_STALE_HANDLES);
+		sbuf_release(job->buf);
+		return;
+	}
 
-	/* type */
-	memcpy(conn->send_buf + conn->send_len + 2, &net_type, 2);
+	/* worker가 프레임을 만든 시각이 기록된 경우 송신 큐에 넣기까지 걸린 시간 기록 */
+	if (job->buf->ts_ns)
+		metric_record(MH_LOGIC_TO_SEND, now_ns - job->buf->ts_ns);
 
-	/* payload */
-	if (payload_len > 0) {
-		memcpy(conn->send_buf + conn->send_len + 4,
-			pkt->payload,
-			payload_len);
-	}
+	/* packet_send는 성공/실패와 관계없이 프레임 참조를 가져감 */
+	if (packet_send(conn, job->buf) < 0)
+		net_disconnect(r, conn, DISC_SEND_FAILED);
+}
 
-	conn->send_len += total_len;
+/*
+* 방 멤버 목록에서 이 reactor가 담당한 연결에만 프레임 참조를 붙이는 함수
+* 목록은 worker가 더 이상 바꾸지 않는 스냅샷이므로 락 없이 순회함
+* 퇴장이 반영되기 전에 끊기고 id가 재사용된 멤버는 handle 세대가 달라 건너뜀
+*/
+static void handle_multicast_job(reactor_t* r, job_t* job, uint64_t now_ns)
+{
+	member_set_t* set = job->members;
+
+	if (job->buf->ts_ns)
+		metric_record(MH_LOGIC_TO_SEND, now_ns - job->buf->ts_ns);
+
+	for (int i = 0; i < set->count; ++i) {
+		conn_handle_t h = set->members[i].handle;
+		if (h == job->handle)
+			continue;
+
+		conn_slot_t* slot = slot_map_get(&g_conn_slots, HANDLE_ID(h));
+		if (!slot || atomic_load_explicit(&slot->owner, memory_order_relaxed) != r->id)
+			continue;
+		if (atomic_load_explicit(&slot->gen, memory_order_relaxed) != HANDLE_GEN(h)) {
+			metric_inc(MC_STALE_HANDLES);
+			continue;
+		}
 
-	// EPOLLOUT Ȱȭ
-	struct epoll_event ev;
-	ev.events = EPOLLIN | EPOLLOUT;
-	ev.data.fd = fd;
-	epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+		connection_t* conn = slot->conn;
+		if (packet_send(conn, sbuf_ref(job->buf)) < 0)
+			net_disconnect(r, conn, DISC_SEND_FAILED);
+	}
 
-	return 0;
+	member_set_release(set);
+	sbuf_release(job->buf);
 }
 
-static void handle_send_job(job_t* job)
+/* worker가 요청한 연결 끊기 (이미 끊긴 연결이면 무시) */
+static void handle_close_job(reactor_t* r, job_t* job)
 {
-	int fd = job->fd;
-	connection_t* conn = connections[fd];
+	connection_t* conn = conn_table_lookup(job->handle, r->id);
+	if (conn)
+		net_disconnect(r, conn, (disc_reason_t)job->reason);
+}
 
-	// ̹     
-	if (!conn)
+/*
+* 유휴 검사 타이머 만료
+* 수신 경로는 last_active만 갱신하고 타이머를 다시 걸지 않으므로, 만료 시점에 마지막 수신 시각을 보고 판정함
+* 그 사이 데이터를 받았으면 마지막 수신 시각 기준으로 다시 걸고, IDLE_TIMEOUT_MS 동안 조용했으면 끊으며,
+* 그 전이면 heartbeat를 보내 응답을 유도한 뒤 끊을 시각에 다시 확인함
+* worker 큐 적체로 읽기를 멈춘 연결은 서버가 읽지 않는 것이므로 조용한 것으로 보지 않음
+* (속도 제한 지연은 지연 시각이 지나면 다시 읽으므로 그대로 판정함)
+*/
+static void conn_idle_expired(void* arg) {
+	connection_t* conn = arg;
+	reactor_t* r = &reactors[conn->owner];
+
+	if (conn->paused_by_queue)
+		conn->last_active = r->now_ms;
+
+	uint64_t silent = r->now_ms - conn->last_active;
+	if (silent < IDLE_CHECK_MS) {
+		timer_arm(&r->timers, &conn->idle_timer, conn->last_active + IDLE_CHECK_MS);
 		return;
+	}
 
-	if (packet_send(fd, &job->packet) < 0) {
-		net_disconnect(fd);
+	if (silent >= IDLE_TIMEOUT_MS) {
+		LOG_INFO("idle timeout fd=%d silent=%llums", conn->fd, (unsigned long long)silent);
+		net_disconnect(r, conn, DISC_IDLE_TIMEOUT);
+		return;
 	}
+
+	metric_inc(MC_HEARTBEATS_SENT);
+	sbuf_t* hb = sbuf_frame(PKT_HEARTBEAT, NULL, 0);
+	if (!hb || packet_send(conn, hb) < 0) {
+		net_disconnect(r, conn, DISC_SEND_FAILED);
+		return;
+	}
+	/* 응답이 오면 다음 검사에서 다시 heartbeat을 보내고, 오지 않으면 유휴 한도에서 끊음 */
+	uint64_t next = r->now_ms + IDLE_CHECK_MS;
+	uint64_t deadline = conn->last_active + IDLE_TIMEOUT_MS;
+	timer_arm(&r->timers, &conn->idle_timer, (next < deadline) ? next : deadline);
+}
+
+/* reactor의 io_q 현재 깊이와 최고 수위 조회 (지표 수집용) */
+void net_io_queue_stats(int reactor, size_t* depth, size_t* hwm) {
+	*depth = mpsc_queue_depth(&reactors[reactor].io_q);
+	*hwm = __atomic_load_n(&reactors[reactor].io_q.hwm, __ATOMIC_RELAXED);
 }
 
+/*
+* io_q에 쌓인 send 작업을 한 번에 비우는 함수 (해당 reactor 전용)
+* woken이면 eventfd를 먼저 비우며, eventfd 읽기 -> 깨우기 플래그 내림 -> pop 순서는 여기서만 지킴
+*/
+static void drain_io_queue(reactor_t* r, bool woken) {
+	job_t batch[IO_DRAIN_BATCH];
 
-int net_init() {
+	if (woken) {
+		uint64_t v;
+		while (read(r->wake_fd, &v, sizeof(v)) > 0) {}
+	}
+
+	/*
+	* eventfd를 비운 뒤, drain 전에 깨우기 플래그를 내려야 함
+	* 그래야 drain 도중이나 이후에 push된 작업은 다시 eventfd write로 이어져 누락되지 않음
+	* (플래그를 내린 뒤에 eventfd를 읽으면 그 사이 worker가 쓴 깨우기를 삼켜, 플래그만 올라간 채 다음 깨우기가 모두 생략됨)
+	*/
+	atomic_exchange_explicit(&r->wake_pending, false, memory_order_acq_rel);
+
+	int n;
+	while ((n = mpsc_queue_pop_batch(&r->io_q, batch, IO_DRAIN_BATCH)) > 0) {
+		uint64_t now_ns = monotonic_ns();
+		for (int i = 0; i < n; ++i) {
+			if (batch[i].type == JOB_SEND)
+				handle_send_job(r, &batch[i], now_ns);
+			else if (batch[i].type == JOB_MULTICAST)
+				handle_multicast_job(r, &batch[i], now_ns);
+			else if (batch[i].type == JOB_CLOSE)
+				handle_close_job(r, &batch[i]);
+		}
+	}
+}
+
+/*
+* reactor 하나를 초기화하는 함수
+* 모든 reactor가 같은 포트에 SO_REUSEPORT로 listen 소켓을 열어, 커널이 새 연결을 reactor들에 분산하게 함
+*/
+static int reactor_init(reactor_t* r, int id) {
 	struct sockaddr_in addr;
 	int opt = 1;
 
-	if ((listen_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+	r->id = id;
+	r->listen_fd = r->epfd = r->wake_fd = -1;
+	r->conn_pool_count = 0;
+	r->live_head = NULL;
+	memset(&r->flow, 0, sizeof(r->flow));
+	memset(&r->ready, 0, sizeof(r->ready));
+	memset(&r->ready_spare, 0, sizeof(r->ready_spare));
+	r->now_ms = monotonic_ms();
+	timer_wheel_init(&r->timers, r->now_ms);
+	atomic_init(&r->wake_pending, false);
+	mpsc_queue_init(&r->io_q);
+
+	if ((r->listen_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
 		perror("socket error");
-		return 1;
+		return -1;
 	}
 
-	if ((setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) < 0) {
+	if ((setsockopt(r->listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) < 0) {
 		perror("setsockopt error");
-		return 1;
+		return -1;
+	}
+
+	if ((setsockopt(r->listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt))) < 0) {
+		perror("setsockopt SO_REUSEPORT error");
+		return -1;
 	}
 
 	memset(&addr, 0x00, sizeof(addr));
@@ -145,26 +621,26 @@ int net_init() {
 	addr.sin_addr.s_addr = htonl(INADDR_ANY);
 	addr.sin_port = htons(PORTNUM);
 
-	if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+	if (bind(r->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
 		perror("bind error");
-		return 1;
+		return -1;
 	}
 
-	if (listen(listen_fd, 256) < 0) {
+	if (listen(r->listen_fd, LISTEN_BACKLOG) < 0) {
 		perror("listen error");
-		return 1;
+		return -1;
 	}
 
-	set_nonblocking(listen_fd);
+	set_nonblocking(r->listen_fd);
 
-	epfd = epoll_create1(0);
-	if (epfd < 0) {
+	r->epfd = epoll_create1(0);
+	if (r->epfd < 0) {
 		perror("epoll error");
 		return -1;
 	}
 
-	wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
-	if (wake_fd < 0) {
+	r->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (r->wake_fd < 0) {
 		perror("eventfd error");
 		return -1;
 	}
@@ -172,225 +648,427 @@ int net_init() {
 	struct epoll_event wev;
 	memset(&wev, 0, sizeof(wev));
 	wev.events = EPOLLIN;
-	wev.data.fd = wake_fd;
+	wev.data.u64 = EV_WAKE;
 
-	if (epoll_ctl(epfd, EPOLL_CTL_ADD, wake_fd, &wev) < 0) {
+	if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->wake_fd, &wev) < 0) {
 		perror("epoll_ctl add wake_fd error");
-		close(wake_fd);
-		wake_fd = -1;
+		close(r->wake_fd);
+		r->wake_fd = -1;
 		return -1;
 	}
 
 	struct epoll_event ev;
 	ev.events = EPOLLIN;
-	ev.data.fd = listen_fd;
+	ev.data.u64 = EV_LISTEN;
 
-	epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &ev);
+	epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->listen_fd, &ev);
 
-	printf("Server is operating on port %d\n", PORTNUM);
 	return 0;
 }
 
-void net_run() {
+int net_init() {
+	for (int i = 0; i < NET_THREAD_NUM; ++i) {
+		if (reactor_init(&reactors[i], i) < 0)
+			return -1;
+	}
+
+	LOG_INFO("Server is operating on port %d (reactors=%d)", PORTNUM, NET_THREAD_NUM);
+	return 0;
+}
+
+/* conn_read 결과 */
+typedef enum {
+	CONN_READ_CLOSED = -1,		// 연결을 닫음 (연결 객체는 반납되어 더 이상 쓰면 안 됨)
+	CONN_READ_DONE,				// EAGAIN까지 읽었거나 worker 큐 적체로 읽기를 멈춤
+	CONN_READ_BUDGET			// 수신 예산을 다 써 ready 목록에 올림
+} conn_read_t;
+
+/*
+* 수신 예산을 다 쓴 연결을 ready 목록에 올리는 함수
+* EAGAIN까지 읽을 때까지 heavy로 표시해, worker 큐가 HIGH 이상일 때 이 연결부터 읽기를 멈추게 함
+* level-triggered 모드에서는 남은 데이터를 epoll이 다음 epoll_wait에서 다시 알려주므로 목록이 필요 없음
+* 목록을 늘리지 못하면 -1을 반환하며, 호출자는 예산과 관계없이 EAGAIN까지 읽음 (edge를 놓치지 않기 위함)
+*/
+static int conn_mark_ready(reactor_t* r, connection_t* conn) {
+	conn->heavy = true;
+#if NET_EDGE_TRIGGERED
+	if (handle_list_push(&r->ready, conn->handle) < 0)
+		return -1;
+	conn->ready = true;
+#else
+	(void)r;
+	(void)conn;
+#endif
+	metric_inc(MC_RECV_BUDGET_EXHAUSTED);
+	return 0;
+}
+
+/*
+* 연결 하나에서 수신 예산(RECV_BUDGET_BYTES)만큼 읽고 파싱하는 함수
+* 수신 버퍼가 없으면 풀에서 빌려 오고, 뒤쪽에 최대 크기 프레임이 들어갈 공간이 없을 때만 남은 조각을 앞으로 옮김
+* 예산을 다 쓴 경우에는 버퍼에 이미 들어온 패킷까지만 넘기고, 소켓에 남은 데이터는 다음 차례에 읽음
+*/
+static conn_read_t conn_read(reactor_t* r, connection_t* conn) {
+	int fd = conn->fd;
+	size_t budget = RECV_BUDGET_BYTES;
+
+	while (1) {
+		if (protocol_compact(conn) < 0) {
+			LOG_ERROR("recv buffer alloc failed fd=%d", fd);
+			net_disconnect(r, conn, DISC_RECV_ERROR);
+			return CONN_READ_CLOSED;
+		}
+
+		ssize_t n = recv(fd, conn->recv_buf + conn->recv_len, RECV_BUF_SIZE - conn->recv_len, 0);
+
+		if (n == 0) {
+			// 정상 종료
+			net_disconnect(r, conn, DISC_PEER_CLOSED);
+			return CONN_READ_CLOSED;
+		}
+
+		if (n < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				/* 다 읽었으므로 덜 들어온 프레임 조각이 없으면 수신 버퍼를 풀에 돌려줌 */
+				protocol_release(conn, false);
+				conn->heavy = false;
+				return CONN_READ_DONE;
+			}
+			net_disconnect(r, conn, DISC_RECV_ERROR);
+			return CONN_READ_CLOSED;
+		}
+
+		conn->recv_len += n;
+		conn->last_active = r->now_ms;
+		metric_add(MC_BYTES_IN, (uint64_t)n);
+
+		/* 이번 recv로 읽은 패킷들은 같은 수신 시각을 공유함 */
+		uint64_t recv_ns = monotonic_ns();
+		packet_t* pkt;
+		int rc;
+
+		while ((rc = protocol_parse(conn, &pkt)) > 0) {
+			/* push 이후에는 버퍼 소유권이 worker로 넘어가므로 로그를 먼저 남김 */
+			LOG_DEBUG("[PACKET] fd=%d type=%d len=%d", fd, pkt->type, pkt->length);
+
+			metric_inc(MC_PKT_IN + metric_pkt_slot(pkt->type));
+			pkt->recv_ns = recv_ns;
+
+			/* heartbeat 응답은 마지막 수신 시각을 갱신한 것으로 끝나므로 worker로 넘기지 않음 */
+			if (pkt->type == PKT_HEARTBEAT) {
+				packet_free(pkt);
+				continue;
+			}
+
+			/*
+			* 속도 제한을 넘었거나 worker 큐가 적체되면, 이미 읽은 패킷은 마저 파싱해 보류 목록에 두고 이 연결의 읽기를 멈춤
+			* (이 패킷으로 HIGH에 닿았을 때는 heavy 연결만)
+			*/
+			flow_rc_t frc = flow_deliver(conn, pkt, conn->heavy);
+			if (frc == FLOW_DISCONNECT) {
+				LOG_WARN("rate limit exceeded fd=%d", fd);
+				net_disconnect(r, conn, DISC_RATE_LIMITED);
+				return CONN_READ_CLOSED;
+			}
+			if (frc == FLOW_PAUSE && flow_pause(&r->flow, conn) < 0) {
+				LOG_ERROR("flow control list alloc failed fd=%d", fd);
+				net_disconnect(r, conn, DISC_RECV_ERROR);
+				return CONN_READ_CLOSED;
+			}
+		}
+
+		if (rc == PROTO_ERR_ALLOC) {
+			LOG_ERROR("packet alloc failed fd=%d", fd);
+			net_disconnect(r, conn, DISC_RECV_ERROR);
+			return CONN_READ_CLOSED;
+		}
+		if (rc < 0) {
+			/* protocol error */
+			LOG_WARN("protocol violation fd=%d", fd);
+			net_disconnect(r, conn, DISC_PROTOCOL);
+			return CONN_READ_CLOSED;
+		}
+
+		if (conn->paused) {
+			protocol_release(conn, false);
+			conn_update_events(r, conn);
+			return CONN_READ_DONE;
+		}
+
+		/* 예산을 다 썼으면 남은 데이터는 다른 연결을 처리한 뒤 다음 루프에서 읽음 */
+		budget = ((size_t)n < budget) ? budget - (size_t)n : 0;
+		if (budget == 0 && conn_mark_ready(r, conn) == 0)
+			return CONN_READ_BUDGET;
+	}
+}
+
+/*
+* 지난 루프에서 수신 예산을 다 쓴 연결들을 이어서 읽는 함수
+* 이번에 다시 예산을 다 쓴 연결은 새 목록에 쌓여 다음 루프로 넘어가므로, 한 루프에서 연결당 예산은 한 번만 쓰임
+*/
+static void serve_ready(reactor_t* r) {
+	handle_list_t list = r->ready;
+	r->ready = r->ready_spare;
+	r->ready.count = 0;
+
+	for (int i = 0; i < list.count; ++i) {
+		connection_t* conn = conn_table_lookup(list.items[i], r->id);
+		if (!conn || !conn->ready)
+			continue;
+
+		conn->ready = false;
+		if (!conn->paused)
+			conn_read(r, conn);
+	}
+
+	list.count = 0;
+	r->ready_spare = list;
+}
+
+/*
+* 미뤄둔 끊김 이벤트를 다시 넣고, 읽기를 멈춘 연결 중 보류 패킷을 모두 넘긴 연결(flow_try_resume)의 읽기를 다시 켜는 함수
+* 이미 닫힌 연결의 handle은 세대가 맞지 않아 목록에서 빠짐
+*/
+static void resume_reads(reactor_t* r) {
+	flow_retry(&r->flow);
+
+	/* 큐 적체와 속도 제한 지연 중 어느 것으로 멈췄는지에 따라 조건이 다르므로 판단은 연결마다 flow_try_resume이 함 */
+	handle_list_t* paused = &r->flow.paused;
+	if (paused->count == 0)
+		return;
+
+	int kept = 0;
+	for (int i = 0; i < paused->count; ++i) {
+		conn_handle_t h = paused->items[i];
+		connection_t* conn = conn_table_lookup(h, r->id);
+		if (!conn || !conn->paused)
+			continue;
+
+		int rc = flow_try_resume(conn);
+		if (rc < 0) {
+			net_disconnect(r, conn, DISC_RATE_LIMITED);
+			continue;
+		}
+		if (rc == 0) {
+			paused->items[kept++] = h;
+			continue;
+		}
+
+		/* edge-triggered 모드에서도 MOD 시점에 읽을 데이터가 있으면 이벤트가 다시 발생함 */
+		conn_update_events(r, conn);
+	}
+	paused->count = kept;
+}
+
+/*
+* 송신 합치기 : flush 목록의 연결마다 쌓인 프레임을 한 번에 보내는 함수 (루프 끝에서 호출)
+* 창(SEND_COALESCE_WINDOW_MS)이 아직 지나지 않았으면 그대로 두고, epoll_wait가 창 끝까지만 기다림
+* 목록에 오른 뒤 끊긴 연결은 handle 세대가 맞지 않아 건너뜀
+*/
+static void flush_coalesced(reactor_t* r) {
+	if (r->flush.count == 0 || (SEND_COALESCE_WINDOW_MS > 0 && monotonic_ns() < r->flush_at_ns))
+		return;
+
+	for (int i = 0; i < r->flush.count; ++i) {
+		connection_t* conn = conn_table_lookup(r->flush.items[i], r->id);
+		if (!conn || !conn->flush_pending)
+			continue;
+
+		conn->flush_pending = false;
+		if (conn->want_write)
+			continue;
+
+		if (send_queue_flush(&conn->sendq, conn->fd) < 0) {
+			net_disconnect(r, conn, DISC_SEND_FAILED);
+			continue;
+		}
+		conn->want_write = (conn->sendq.count > 0);
+	}
+	r->flush.count = 0;
+}
+
+/*
+* epoll_wait 최대 대기 시간
+* ready 목록이 있으면 기다리지 않고, 그 외에는 다음 타이머 처리 시각과 흐름 제어 재확인 주기(FLOW_RETRY_MS),
+* 송신 합치기 창이 끝나는 시각 중 이른 쪽까지 기다림
+*/
+static int reactor_timeout(reactor_t* r) {
+	if (r->ready.count > 0)
+		return 0;
+
+	int timeout = timer_wheel_timeout(&r->timers, monotonic_ms());
+	if (flow_pending(&r->flow) && (timeout < 0 || timeout > FLOW_RETRY_MS))
+		timeout = FLOW_RETRY_MS;
+
+	if (r->flush.count > 0) {
+		uint64_t now = monotonic_ns();
+		int wait = (r->flush_at_ns > now) ? (int)((r->flush_at_ns - now + 999999) / 1000000) : 0;
+		if (timeout < 0 || timeout > wait)
+			timeout = wait;
+	}
+	return timeout;
+}
+
+/* reactor 하나의 이벤트 루프 */
+static void reactor_run(reactor_t* r) {
 	struct epoll_event events[MAX_EVENTS];
 
 	while (!g_terminate) {
-		int n = epoll_wait(epfd, events, MAX_EVENTS, -1);
+		int n = epoll_wait(r->epfd, events, MAX_EVENTS, reactor_timeout(r));
 		if (n < 0) {
 			if (errno == EINTR)
 				continue;
-			perror("epoll wait error");
+			LOG_ERROR("epoll wait error: %E", errno);
 			break;
 		}
 
+		/* 만료된 타이머 처리 (닫힌 연결의 이벤트는 아래에서 handle 세대로 걸러짐) */
+		r->now_ms = monotonic_ms();
+		if (r->timers.count > 0)
+			metric_add(MC_TIMERS_FIRED, (uint64_t)timer_wheel_advance(&r->timers, r->now_ms));
+
+		bool woken = false;
 		for (int i = 0; i < n; ++i) {
-			if (events[i].data.fd == wake_fd && (events[i].events & EPOLLIN)) {
-				uint64_t v;
-				while (read(wake_fd, &v, sizeof(v)) > 0) {}
+			if (events[i].data.u64 == EV_WAKE && (events[i].events & EPOLLIN)) {
+				woken = true;
 				break;
 			}
 		}
 
-		job_t job;
-		while (job_queue_pop(&g_io_q, &job, JOBQ_NONBLOCK)) {
-			if (job.type == JOB_SEND) {
-				handle_send_job(&job);
-			}
-		}
+		drain_io_queue(r, woken);
+
+		if (flow_pending(&r->flow))
+			resume_reads(r);
+
+		if (r->ready.count > 0)
+			serve_ready(r);
 
 		for (int i = 0; i < n; ++i) {
-			int fd = events[i].data.fd;
+			uint64_t tag = events[i].data.u64;
 			uint32_t ev = events[i].events;
 
-			if (fd == wake_fd) {
-				//  ̹ 巹 ߴ, Ȥ     
-				if (ev & EPOLLIN) {
-					uint64_t v;
-					while (read(wake_fd, &v, sizeof(v)) > 0) {}
-				}
+			/* eventfd는 위의 drain_io_queue에서 이미 비움 (여기서 다시 읽으면 그 뒤에 온 깨우기를 잃음) */
+			if (tag == EV_WAKE)
+				continue;
+
+			// listen fd 처리
+			if (tag == EV_LISTEN) {
+				accept_connections(r);
 				continue;
 			}
 
-			//   ó
+			/* 같은 결과 안의 앞선 이벤트나 io 큐 처리로 이미 닫힌 연결이면 handle 세대가 맞지 않아 건너뜀 */
+			connection_t* conn = conn_table_lookup((conn_handle_t)tag, r->id);
+			if (!conn)
+				continue;
+			int fd = conn->fd;
+
+			// 에러와 끊김 처리
 			if (ev & (EPOLLERR | EPOLLHUP)) {
-				net_disconnect(fd);
+				net_disconnect(r, conn, DISC_SOCKET_ERROR);
 				continue;
 			}
 
-			// listen fd ó
-			if (fd == listen_fd) {
-				struct sockaddr_in client_addr;
-				socklen_t clilen = sizeof(client_addr);
-
-				int client_fd = accept(listen_fd, (struct sockaddr*)&client_addr, &clilen);
+			/*
+			* EPOLLIN 처리
+			* 같은 결과 안에서 이미 읽기를 멈춘 연결과, ready 목록에서 차례를 기다리는 연결은 여기서 읽지 않음
+			*/
+			if ((ev & EPOLLIN) && !conn->paused && !conn->ready) {
+				if (conn_read(r, conn) == CONN_READ_CLOSED)
+					continue;
+			}
 
-				if (client_fd < 0) {
-					if (errno == EAGAIN || errno == EWOULDBLOCK)
-						continue;
-					perror("accept error");
-					break;
-				}
+			// EPOLLOUT 처리
+			if (ev & EPOLLOUT) {
+#if NET_EDGE_TRIGGERED
+				/* 부분 전송으로 쓰기를 기다리던 경우에만 이어서 전송 */
+				if (!conn->want_write)
+					continue;
+#endif
 
-				if (client_fd >= MAX_CLIENTS) {
-					printf("warning: fd=%d exceeds MAX_CLIENTS\n", client_fd);
-					close(client_fd);
+				if (send_queue_flush(&conn->sendq, fd) < 0) {
+					net_disconnect(r, conn, DISC_SEND_FAILED);
 					continue;
 				}
 
-				set_nonblocking(client_fd);
-
-				connection_t* conn = malloc(sizeof(connection_t));
-				if (!conn) {
-					close(client_fd);
+				/* soft 한도 초과 상태였다면 줄어든 양으로 다시 판정 */
+				if (send_queue_check_limit(&conn->sendq, monotonic_ms()) < 0) {
+					net_disconnect(r, conn, DISC_SEND_FAILED);
 					continue;
 				}
 
-				conn->fd = client_fd;
-				conn->recv_len = 0;
-				conn->send_len = 0;
-				conn->send_offset = 0;
-				memset(conn->recv_buf, 0, RECV_BUF_SIZE);
-
-				connections[client_fd] = conn;
-
-				printf("Client info : %s:%d (fd=%d)\n", inet_ntoa(client_addr.sin_addr),
-					ntohs(client_addr.sin_port), client_fd);
-
-				struct epoll_event cev;
-				cev.events = EPOLLIN;
-				cev.data.fd = client_fd;
-				epoll_ctl(epfd, EPOLL_CTL_ADD, client_fd, &cev);
+				/* 다 보냈으면 */
+				if (conn->sendq.count == 0) {
+#if NET_EDGE_TRIGGERED
+					conn->want_write = false;
+#else
+					/* EPOLLOUT 제거 */
+					conn_update_events(r, conn);
+#endif
+				}
 			}
 
-			// EPOLLIN ó
-			if (events[i].events & EPOLLIN) {
-				int cfd = events[i].data.fd;
-				connection_t* conn = connections[cfd];
-				if (!conn)
-					continue;
+		}
 
-				bool connection_closed = false;
-
-				while (1) {
-					ssize_t n = recv(cfd, conn->recv_buf + conn->recv_len, RECV_BUF_SIZE - conn->recv_len, 0);
-
-					if (n > 0) {
-						conn->recv_len += n;
-						packet_t pkt;
-
-						while (1) {
-							int r = protocol_parse(conn, &pkt);
-
-							if (r == 0)
-								break;
-							if (r < 0) {
-								/* protocol error */
-								printf("[ERROR] protocol violation fd=%d\n", cfd);
-								net_disconnect(cfd);
-								connection_closed = true;
-								break;
-							}
-							if (connection_closed)
-								break;
-
-							job.fd = cfd;
-							job.packet = pkt;
-							job_queue_push_packet(&g_logic_q, cfd, &pkt);
-
-							printf("[PACKET] fd=%d type=%d len=%d\n", cfd, pkt.type, pkt.length);
-						}
-					}
-					else if (n == 0) {
-						//  
-						net_disconnect(cfd);
-						break;
-					}
-					else {
-						if (errno == EAGAIN || errno == EWOULDBLOCK) {
-							break;
-						}
-						else {
-							net_disconnect(cfd);
-							break;
-						}
-					}
-				}
+		flush_coalesced(r);
+	}
 
-			}
+	if (r->listen_fd >= 0) {
+		close(r->listen_fd);
+		r->listen_fd = -1;
+	}
 
-			// EPOLLOUT ó
-			if (events[i].events & EPOLLOUT) {
-				connection_t* conn = connections[fd];
-				if (!conn) continue;
-
-				while (conn->send_offset < conn->send_len) {
-					ssize_t n = send(
-						fd,
-						conn->send_buf + conn->send_offset,
-						conn->send_len - conn->send_offset,
-						0
-					);
-
-					if (n > 0) {
-						conn->send_offset += n;
-					}
-					else if (n < 0) {
-						if (errno == EAGAIN || errno == EWOULDBLOCK)
-							break;
-						net_disconnect(fd);
-						break;
-					}
-				}
+	while (r->live_head)
+		close_connection(r, r->live_head);
+	flow_destroy(&r->flow);
+	free(r->ready.items);
+	free(r->ready_spare.items);
+	free(r->flush.items);
 
-				/*   */
-				if (conn->send_offset == conn->send_len) {
-					conn->send_offset = 0;
-					conn->send_len = 0;
+	if (r->epfd >= 0) {
+		close(r->epfd);
+		r->epfd = -1;
+	}
 
-					/* EPOLLOUT  */
-					struct epoll_event ev;
-					ev.events = EPOLLIN;
-					ev.data.fd = fd;
-					epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
-				}
-			}
+	while (r->conn_pool_count > 0)
+		free(r->conn_pool[--r->conn_pool_count]);
+}
+
+static void* reactor_thread(void* arg) {
+	reactor_run((reactor_t*)arg);
+	return NULL;
+}
 
+/*
+* 네트워크 이벤트 루프 실행
+* reactor 0은 호출한 스레드(main)에서, 나머지는 별도 스레드에서 실행
+* 종료 시그널은 main 스레드로만 전달되도록 reactor 스레드에서는 막아두고,
+* main의 루프가 끝나면 나머지 reactor를 직접 깨워 g_terminate를 확인하게 함
+*/
+void net_run() {
+	sigset_t set, old;
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &set, &old);
+
+	for (int i = 1; i < NET_THREAD_NUM; ++i) {
+		if (pthread_create(&reactors[i].tid, NULL, reactor_thread, &reactors[i]) != 0) {
+			perror("pthread_create");
+			exit(1);
 		}
 	}
 
-	if (listen_fd >= 0) {
-		close(listen_fd);
-		listen_fd = -1;
-	}
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
 
-	for (int fd = 0; fd < MAX_CLIENTS; fd++) {
-		if (connections[fd]) {
-			close_connection(fd);
-		}
-	}
+	reactor_run(&reactors[0]);
 
-	if (epfd >= 0) {
-		close(epfd);
-		epfd = -1;
+	g_terminate = 1;
+	for (int i = 1; i < NET_THREAD_NUM; ++i) {
+		uint64_t one = 1;
+		if (write(reactors[i].wake_fd, &one, sizeof(one)) < 0) {}
+		pthread_join(reactors[i].tid, NULL);
 	}
-}
\ No newline at end of file
+}
+
+#endif
\ No newline at end of file
@@ -2,9 +2,16 @@
 #define NET_H
 
 #include "common.h"
+#include "job_queue.h"
 
 void net_wakeup(void);
-int packet_send(int fd, packet_t* pkt);
+void net_wakeup_all(void);
+void net_push_send(job_t* job);
+void net_push_multicast(struct sbuf* frame, struct member_set* members, conn_handle_t exclude);
+
+/* 연결을 담당 reactor에서 끊도록 요청 (worker에서 호출, reason은 disc_reason_t, 깨우기는 net_wakeup으로) */
+void net_close(conn_handle_t handle, int reason);
+void net_io_queue_stats(int reactor, size_t* depth, size_t* hwm);
 
 int net_init();
 void net_run();
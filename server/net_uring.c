@@ -0,0 +1,1135 @@
+#include "common.h"
+
+#if NET_IO_URING
+
+#include "net.h"
+#include "protocol.h"
+#include "job_queue.h"
+#include "state.h"
+#include "logic.h"
+#include "sbuf.h"
+#include "send_queue.h"
+#include "uring.h"
+#include "log.h"
+#include "metrics.h"
+#include "member_set.h"
+#include "conn_table.h"
+#include "io_buf.h"
+#include "flow.h"
+#include "rate_limit.h"
+#include "timer_wheel.h"
+#include "packet_pool.h"
+
+#include <stddef.h>
+
+/*
+* io_uring reactor (NET_IO_URING=1 빌드에서 net.c 대신 사용)
+* net.h의 계약(net_init/net_run/net_wakeup/net_push_send/net_push_multicast/net_close)은 epoll reactor와 같음
+*
+* - accept : listen 소켓마다 multishot accept 하나를 걸어두고, 새 연결마다 완료 이벤트만 받음
+* - recv   : 연결마다 multishot recv 하나를 걸어두고, 커널이 provided buffer ring에서 고른 버퍼에 데이터를 채워 줌
+* - send   : 연결마다 sendmsg 하나만 진행하며, 송신 큐 앞쪽 프레임들을 iovec으로 묶어 보냄
+* - wakeup : logic thread가 IORING_OP_MSG_RING으로 reactor ring에 완료 이벤트를 직접 넣음
+*
+* 즉 epoll의 "readiness 통지 -> recv/accept/writev 시스템 콜" 과정이 없고,
+* 한 번의 io_uring_enter로 모아 둔 요청 제출과 완료 대기를 함께 처리함
+*/
+
+/* reactor ring의 SQ/CQ 크기, CQ는 multishot 완료가 몰려도 넘치지 않도록 넉넉하게 잡음 */
+#define URING_SQ_ENTRIES 1024
+#define URING_CQ_ENTRIES 8192
+
+/* provided buffer ring 크기 (2의 거듭제곱), 버퍼 하나의 크기는 수신 버퍼와 같음 */
+#define URING_BUF_COUNT 256
+#define URING_BUF_SIZE RECV_BUF_SIZE
+#define URING_BGID 0
+
+/* 한 번에 io_q에서 꺼내 처리할 send 작업 수 */
+#define IO_DRAIN_BATCH 64
+
+/*
+* CQE user_data 구성
+* 연결 요청은 연결 객체 주소에 요청 종류를 하위 비트로 붙여 넣음
+* 연결이 닫힌 뒤 도착하는 완료 이벤트도 fd 번호가 아닌 객체로 찾아가므로, 재사용된 fd와 섞이지 않음
+*/
+#define UD_RECV 0
+#define UD_SEND 1
+#define UD_ACCEPT 2
+#define UD_WAKE 3
+#define UD_CANCEL 4
+#define UD_FLOW_TIMER 5
+#define UD_WHEEL_TIMER 6
+#define UD_TAG_MASK 7ULL
+
+/* 읽기를 멈춘 연결이나 미뤄둔 끊김 이벤트가 있을 때 다시 확인하는 주기 (ms, net.c와 같은 값) */
+#define FLOW_RETRY_MS 10
+
+/* 유휴 검사 주기 (ms, net.c와 같은 값) */
+#define IDLE_CHECK_MS ((HEARTBEAT_INTERVAL_MS > 0) ? HEARTBEAT_INTERVAL_MS : IDLE_TIMEOUT_MS)
+
+/* sendmsg 하나에 묶는 최대 프레임 수 (송신 인자 전체가 io_buf 송신 블록 하나에 들어가도록 정함) */
+#define URING_SEND_IOV ((int)((IO_BUF_SEND_SIZE - sizeof(struct msghdr)) / sizeof(struct iovec)))
+
+/* 진행 중인 sendmsg 인자, 커널이 완료 전까지 읽으므로 전송하는 동안 io_buf 풀에서 빌려 유지함 */
+typedef struct uring_send {
+	struct msghdr msg;
+	struct iovec iov[URING_SEND_IOV];
+} uring_send_t;
+
+_Static_assert(sizeof(uring_send_t) <= IO_BUF_SEND_SIZE, "sendmsg arguments must fit in an io_buf send block");
+
+/*
+* io_uring 연결 객체
+* 커널에 걸린 요청(recv, send)이 남아 있는 동안에는 연결을 닫아도 객체를 해제하지 않고,
+* 마지막 완료 이벤트를 받은 뒤 해제함
+*/
+typedef struct uring_conn {
+	connection_t base;
+	struct uring_conn* flush_next;	// 이번 루프에서 전송을 시작할 연결 목록
+	uring_send_t* send;				// 송신 큐를 다 비울 때까지 빌린 sendmsg 인자, 보낼 것이 없으면 NULL
+	int inflight;					// 완료되지 않은 요청 수
+	bool flush_pending;				// flush 목록에 들어 있음
+	bool recv_armed;				// multishot recv가 걸려 있음 (읽기를 멈추면 취소하고, 마지막 완료 이벤트에서 내림)
+	bool closing;					// 연결을 닫았고 남은 완료 이벤트만 기다리는 중
+} uring_conn_t;
+
+_Static_assert(_Alignof(max_align_t) > UD_TAG_MASK, "connection objects must leave room for the user_data tag");
+
+/*
+* reactor 구조체
+* epoll reactor와 마찬가지로 reactor마다 ring, SO_REUSEPORT listen 소켓, send 작업 ring을 따로 가짐
+*/
+typedef struct reactor {
+	int id;
+	int listen_fd;
+	pthread_t tid;
+
+	uring_t ring;
+	uring_buf_ring_t bufs;
+
+	/* 깨우기 요청이 이미 걸려 있는지 표시하는 플래그 (net.c와 같은 방식) */
+	atomic_bool wake_pending;
+
+	/* logic -> 이 reactor 방향의 send 작업 ring (생산자: worker들, 소비자: 이 reactor) */
+	mpsc_queue_t io_q;
+
+	/* 송신 큐에 프레임이 들어왔지만 아직 sendmsg를 걸지 않은 연결 목록과, 목록을 보낼 시각 (SEND_COALESCE_WINDOW_MS) */
+	uring_conn_t* flush_list;
+	uint64_t flush_at_ns;
+
+	/* 닫힌 연결 객체 풀 (net.c와 같은 방식) */
+	uring_conn_t* conn_pool[CONN_POOL_SIZE];
+	int conn_pool_count;
+
+	/* 이 reactor가 담당한 살아 있는 연결 목록 (uring_conn_t의 base를 잇는 목록) */
+	connection_t* live_head;
+
+	/* worker 큐 적체로 읽기를 멈춘 연결과 미뤄둔 끊김 이벤트 (flow.h) */
+	flow_t flow;
+
+	/* 흐름 제어 재확인용 timeout 요청 인자와 진행 여부 (커널이 완료 전까지 읽음) */
+	struct __kernel_timespec flow_ts;
+	bool flow_timer_armed;
+
+	/*
+	* 연결 유휴 / heartbeat 타이머
+	* 다음 처리 시각에 맞춰 timeout 요청 하나를 걸어 두고, 더 이른 시각이 필요해지면 IORING_TIMEOUT_UPDATE로 당김
+	*/
+	timer_wheel_t timers;
+	uint64_t now_ms;				// 이번 루프에서 깨어난 시각, 수신 경로는 이 값으로 마지막 수신 시각을 갱신함
+	struct __kernel_timespec wheel_ts;
+	uint64_t wheel_deadline;		// 걸어 둔 timeout 요청의 만료 시각(ms)
+	bool wheel_timer_armed;
+} reactor_t;
+
+static reactor_t reactors[NET_THREAD_NUM];
+
+/* 현재 스레드가 send 작업을 넣었지만 아직 깨우지 않은 reactor 목록 (비트마스크) */
+static __thread uint64_t t_wake_mask;
+
+/*
+* reactor를 깨우는 쪽 스레드의 ring
+* MSG_RING은 보내는 쪽도 ring이 필요하므로, 처음 깨울 때 스레드마다 작은 ring을 하나 만들어 둠
+*/
+static __thread uring_t t_msg_ring;
+static __thread bool t_msg_ring_ready;
+
+_Static_assert(NET_THREAD_NUM <= 64, "NET_THREAD_NUM must fit in t_wake_mask");
+
+static inline uint64_t ud_make(uring_conn_t* uc, uint64_t tag) {
+	return (uint64_t)(uintptr_t)uc | tag;
+}
+
+/* reactor ring에 깨우기 완료 이벤트를 넣는 함수 */
+static void ring_msg_wake(reactor_t* r) {
+	if (!t_msg_ring_ready) {
+		if (uring_init(&t_msg_ring, 4, 0, 0) < 0) {
+			LOG_ERROR("io_uring_setup (msg ring) error: %E", errno);
+			return;
+		}
+		t_msg_ring_ready = true;
+	}
+
+	for (;;) {
+		struct io_uring_sqe* sqe = uring_get_sqe(&t_msg_ring);
+		if (!sqe)
+			return;
+
+		sqe->opcode = IORING_OP_MSG_RING;
+		sqe->fd = r->ring.fd;
+		sqe->addr = IORING_MSG_DATA;
+		sqe->off = UD_WAKE;					// 대상 ring CQE의 user_data
+
+		/* 전달 결과를 확인해야 하므로 보낸 쪽 완료를 기다림 */
+		int rc;
+		do {
+			rc = uring_submit(&t_msg_ring, 1);
+		} while (rc < 0 && errno == EINTR);
+
+		struct io_uring_cqe* cqe = uring_peek_cqe(&t_msg_ring);
+		if (!cqe)
+			return;
+
+		int res = cqe->res;
+		uring_cqe_seen(&t_msg_ring);
+
+		/* 대상 CQ가 잠시 가득 찬 경우에는 재시도, 그 외 실패는 ring이 이미 닫힌 경우 */
+		if (res >= 0 || (res != -EOVERFLOW && res != -EAGAIN && res != -EBUSY))
+			return;
+		sched_yield();
+	}
+}
+
+static void reactor_wakeup(reactor_t* r) {
+	/* 이미 깨우기가 예약되어 있으면 reactor가 drain할 때 함께 처리되므로 생략 */
+	if (atomic_exchange_explicit(&r->wake_pending, true, memory_order_acq_rel))
+		return;
+
+	ring_msg_wake(r);
+}
+
+/* 현재 스레드가 send 작업을 넣은 reactor들을 한 번씩 깨우는 함수 */
+void net_wakeup(void) {
+	uint64_t mask = t_wake_mask;
+	t_wake_mask = 0;
+
+	for (int i = 0; mask; ++i, mask >>= 1) {
+		if (mask & 1)
+			reactor_wakeup(&reactors[i]);
+	}
+}
+
+/* send 작업 하나를 대상 fd를 담당하는 reactor의 io_q에 넣는 함수 (logic thread에서 호출) */
+void net_push_send(job_t* job) {
+	int owner = conn_table_owner(job->handle);
+
+	/* 담당 reactor가 없는 연결은 이미 끊긴 연결이므로 프레임 참조만 반납 */
+	if (owner < 0) {
+		sbuf_release(job->buf);
+		return;
+	}
+
+	reactor_t* r = &reactors[owner];
+	while (!mpsc_queue_try_push(&r->io_q, job)) {
+		reactor_wakeup(r);
+		sched_yield();
+	}
+
+	t_wake_mask |= (uint64_t)1 << owner;
+}
+
+void net_close(conn_handle_t handle, int reason) {
+	job_t job = { 0 };
+	job.type = JOB_CLOSE;
+	job.reason = reason;
+	job.handle = handle;
+	net_push_send(&job);
+}
+
+/* 모든 reactor를 깨우는 함수 (worker 큐 적체가 풀렸을 때 멈춘 읽기를 다시 확인하게 함) */
+void net_wakeup_all(void) {
+	t_wake_mask |= (NET_THREAD_NUM == 64) ? ~0ull : ((uint64_t)1 << NET_THREAD_NUM) - 1;
+	net_wakeup();
+}
+
+/*
+* 방 멤버 목록 전체에 프레임을 보내는 작업을 모든 reactor의 io_q에 넣는 함수 (logic thread에서 호출)
+* 각 reactor는 프레임과 목록의 참조를 하나씩 받아 자신이 담당한 fd에만 보내므로, 대상 수와 관계없이 push는 reactor 수만큼만 발생함
+*/
+void net_push_multicast(sbuf_t* frame, member_set_t* members, conn_handle_t exclude) {
+	job_t job = { 0 };
+	job.type = JOB_MULTICAST;
+	job.handle = exclude;
+
+	for (int i = 0; i < NET_THREAD_NUM; ++i) {
+		reactor_t* r = &reactors[i];
+		job.buf = sbuf_ref(frame);
+		job.members = member_set_ref(members);
+
+		while (!mpsc_queue_try_push(&r->io_q, &job)) {
+			reactor_wakeup(r);
+			sched_yield();
+		}
+	}
+
+	t_wake_mask |= (NET_THREAD_NUM == 64) ? ~0ull : ((uint64_t)1 << NET_THREAD_NUM) - 1;
+}
+
+static void conn_idle_expired(void* arg);
+
+/* 연결 객체 확보 함수, 풀에 남은 객체가 있으면 재사용 */
+static uring_conn_t* conn_alloc(reactor_t* r, int fd) {
+	uring_conn_t* uc = (r->conn_pool_count > 0) ? r->conn_pool[--r->conn_pool_count] : malloc(sizeof(uring_conn_t));
+	if (!uc)
+		return NULL;
+
+	connection_t* conn = &uc->base;
+	conn->fd = fd;
+	conn->handle = HANDLE_NONE;
+	conn->owner = r->id;
+	conn->recv_buf = NULL;
+	conn->recv_head = 0;
+	conn->recv_len = 0;
+	conn->paused = conn->paused_by_queue = false;
+	conn->stalled_head = conn->stalled_tail = NULL;
+	conn->ready = conn->heavy = false;
+	rate_limit_init(conn, monotonic_ms());
+	conn->last_active = r->now_ms;
+	timer_init(&conn->idle_timer, conn_idle_expired, uc);
+	send_queue_init(&conn->sendq);
+	conn->want_write = false;
+
+	uc->flush_next = NULL;
+	uc->send = NULL;
+	uc->inflight = 0;
+	uc->flush_pending = false;
+	uc->recv_armed = false;
+	uc->closing = false;
+	return uc;
+}
+
+/* 연결 객체 반납 (남은 요청이 없을 때만 호출), 풀이 가득 차 있으면 해제 */
+static void conn_free(uring_conn_t* uc) {
+	reactor_t* r = &reactors[uc->base.owner];
+
+	/* 빌려 둔 버퍼는 커널이 더 이상 읽지 않는 이 시점에 풀로 돌려줌 */
+	send_queue_clear(&uc->base.sendq);
+	protocol_release(&uc->base, true);
+	io_buf_put(IO_BUF_SEND, uc->send);
+	uc->send = NULL;
+
+	if (r->conn_pool_count < CONN_POOL_SIZE)
+		r->conn_pool[r->conn_pool_count++] = uc;
+	else
+		free(uc);
+}
+
+/* 닫힌 연결 객체를 더 이상 참조하는 곳(커널 요청, flush 목록)이 없으면 해제 */
+static void conn_release_if_idle(uring_conn_t* uc) {
+	if (uc->closing && uc->inflight == 0 && !uc->flush_pending)
+		conn_free(uc);
+}
+
+/* 완료 이벤트 하나를 받은 연결의 남은 요청 수를 줄이고, 닫힌 연결이면 마지막 이벤트에서 해제 */
+static void conn_put(uring_conn_t* uc) {
+	uc->inflight--;
+	conn_release_if_idle(uc);
+}
+
+/* reactor의 살아 있는 연결 목록에 넣는 함수 */
+static void conn_link(reactor_t* r, uring_conn_t* uc) {
+	connection_t* conn = &uc->base;
+	conn->live_prev = NULL;
+	conn->live_next = r->live_head;
+	if (r->live_head)
+		r->live_head->live_prev = conn;
+	r->live_head = conn;
+}
+
+static void conn_unlink(reactor_t* r, uring_conn_t* uc) {
+	connection_t* conn = &uc->base;
+	if (conn->live_prev)
+		conn->live_prev->live_next = conn->live_next;
+	else
+		r->live_head = conn->live_next;
+	if (conn->live_next)
+		conn->live_next->live_prev = conn->live_prev;
+}
+
+/* 연결을 닫고 남은 완료 이벤트를 기다리는 상태로 바꾸는 함수 (이미 닫힌 연결이면 무시) */
+static void close_connection(reactor_t* r, uring_conn_t* uc)
+{
+	if (uc->closing) return;
+
+	int fd = uc->base.fd;
+
+	/*
+	* 아직 제출하지 않은 이 fd 대상 요청이 있을 수 있으므로 먼저 제출함
+	* close 이후 다른 reactor가 같은 fd 번호를 받으면 늦게 제출된 요청이 엉뚱한 소켓에 걸리기 때문
+	*/
+	uring_submit(&r->ring, 0);
+
+	conn_table_free(uc->base.handle);
+	conn_unlink(r, uc);
+	timer_cancel(&r->timers, &uc->base.idle_timer);
+
+	/* 걸려 있는 recv/send는 shutdown으로 바로 완료시키고, 완료 이벤트가 모두 오면 객체를 해제함 */
+	shutdown(fd, SHUT_RDWR);
+	close(fd);
+
+	/* worker에 넘기지 못한 보류 패킷은 끊김 이후 의미가 없으므로 바로 버림 */
+	flow_drop_stalled(&uc->base);
+
+	uc->closing = true;
+	conn_release_if_idle(uc);
+
+	LOG_INFO("Connection closed fd=%d reactor=%d", fd, r->id);
+}
+
+static void net_disconnect(reactor_t* r, uring_conn_t* uc, disc_reason_t reason)
+{
+	/* 이미 정리된 연결이면 끊김도 이미 알렸으므로 무시 */
+	if (uc->closing) return;
+
+	conn_handle_t handle = uc->base.handle;
+
+	// 네트워크 리소스 정리
+	metric_inc(MC_DISCONNECTS + reason);
+	close_connection(r, uc);
+
+	// 상태 정리는 워커에게 맡김 (큐가 가득 차 있으면 미뤘다가 다시 넣음)
+	flow_notify_disconnect(&r->flow, handle);
+}
+
+static void arm_accept(reactor_t* r) {
+	struct io_uring_sqe* sqe = uring_get_sqe(&r->ring);
+	if (!sqe) return;
+
+	sqe->opcode = IORING_OP_ACCEPT;
+	sqe->fd = r->listen_fd;
+	sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+	sqe->accept_flags = SOCK_CLOEXEC;
+	sqe->user_data = ud_make(NULL, UD_ACCEPT);
+}
+
+static int arm_recv(reactor_t* r, uring_conn_t* uc) {
+	struct io_uring_sqe* sqe = uring_get_sqe(&r->ring);
+	if (!sqe) return -1;
+
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = uc->base.fd;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = r->bufs.bgid;
+	sqe->user_data = ud_make(uc, UD_RECV);
+
+	uc->inflight++;
+	uc->recv_armed = true;
+	return 0;
+}
+
+/*
+* 연결의 읽기를 멈추는 함수
+* 걸려 있는 multishot recv를 취소하고, 취소가 처리되기 전에 도착한 데이터는 consume_recv가 보류 목록에 파싱해 둠
+* 취소 요청의 완료 이벤트는 결과와 관계없이 무시함 (recv가 이미 끝났으면 ENOENT)
+*/
+static int pause_recv(reactor_t* r, uring_conn_t* uc) {
+	if (flow_pause(&r->flow, &uc->base) < 0)
+		return -1;
+
+	struct io_uring_sqe* sqe = uring_get_sqe(&r->ring);
+	if (!sqe) return -1;
+
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = ud_make(uc, UD_RECV);
+	sqe->user_data = ud_make(NULL, UD_CANCEL);
+	return 0;
+}
+
+/*
+* 송신 큐 앞쪽 프레임들로 sendmsg 하나를 거는 함수
+* MSG_WAITALL이면 커널이 부분 전송을 스스로 이어서 보내므로, 완료는 대부분 요청한 길이 전체로 옴
+*/
+static int start_send(reactor_t* r, uring_conn_t* uc) {
+	connection_t* conn = &uc->base;
+	size_t want;
+
+	if (conn->sendq.count == 0)
+		return 0;
+
+	if (!uc->send && !(uc->send = io_buf_get(IO_BUF_SEND)))
+		return -1;
+
+	int iovcnt = send_queue_fill_iov(&conn->sendq, uc->send->iov, URING_SEND_IOV, &want);
+
+	struct io_uring_sqe* sqe = uring_get_sqe(&r->ring);
+	if (!sqe) return -1;
+
+	memset(&uc->send->msg, 0, sizeof(uc->send->msg));
+	uc->send->msg.msg_iov = uc->send->iov;
+	uc->send->msg.msg_iovlen = iovcnt;
+
+	sqe->opcode = IORING_OP_SENDMSG;
+	sqe->fd = conn->fd;
+	sqe->addr = (uint64_t)(uintptr_t)&uc->send->msg;
+	sqe->len = 1;
+	sqe->msg_flags = MSG_WAITALL | MSG_NOSIGNAL | (send_queue_more(&conn->sendq, want) ? MSG_MORE : 0);
+	sqe->user_data = ud_make(uc, UD_SEND);
+	metric_inc(MC_SEND_CALLS);
+
+	/* 완료 전까지는 want_write로 전송 중임을 표시하고, 새 프레임은 큐에만 쌓음 */
+	conn->want_write = true;
+	uc->inflight++;
+	return 0;
+}
+
+/*
+* 직렬화된 프레임 참조를 연결의 송신 큐에 넣는 함수 (연결을 담당하는 reactor에서만 호출)
+* 전송은 바로 걸지 않고 flush 목록에 올려, drain 한 번 동안 쌓인 프레임을 sendmsg 하나로 묶음
+* 호출자의 참조는 성공/실패와 관계없이 이 함수가 가져감
+*/
+static int packet_send(uring_conn_t* uc, sbuf_t* buf) {
+	if (buf->len >= 4) {
+		uint16_t net_type;
+		memcpy(&net_type, buf->data + 2, 2);
+		metric_inc(MC_PKT_OUT + metric_pkt_slot(ntohs(net_type)));
+	}
+
+	if (send_queue_push(&uc->base.sendq, buf) < 0) {
+		sbuf_release(buf);
+		return -1;
+	}
+
+	if (!uc->base.want_write && !uc->flush_pending) {
+		reactor_t* r = &reactors[uc->base.owner];
+		if (SEND_COALESCE && !r->flush_list)
+			r->flush_at_ns = monotonic_ns() + (uint64_t)SEND_COALESCE_WINDOW_MS * 1000000;
+		uc->flush_pending = true;
+		uc->flush_next = r->flush_list;
+		r->flush_list = uc;
+	}
+
+	/* 보내고 남은 양이 한도를 넘으면 계속 읽지 않는 클라이언트로 보고 실패 처리 */
+	return send_queue_check_limit(&uc->base.sendq, monotonic_ms());
+}
+
+static void handle_send_job(reactor_t* r, job_t* job, uint64_t now_ns)
+{
+	/* 이미 끊긴 경우 → 조용히 무시 (프레임 참조만 반납), id가 재사용된 경우는 handle 세대로 걸러냄 */
+	uring_conn_t* uc = conn_table_lookup(job->handle, r->id);
+	if (!uc) {
+		metric_inc(MC_STALE_HANDLES);
+		sbuf_release(job->buf);
+		return;
+	}
+
+	/* worker가 프레임을 만든 시각이 기록된 경우 송신 큐에 넣기까지 걸린 시간 기록 */
+	if (job->buf->ts_ns)
+		metric_record(MH_LOGIC_TO_SEND, now_ns - job->buf->ts_ns);
+
+	if (packet_send(uc, job->buf) < 0)
+		net_disconnect(r, uc, DISC_SEND_FAILED);
+}
+
+/*
+* 방 멤버 목록에서 이 reactor가 담당한 연결에만 프레임 참조를 붙이는 함수
+* 목록은 worker가 더 이상 바꾸지 않는 스냅샷이므로 락 없이 순회함
+* 퇴장이 반영되기 전에 끊기고 id가 재사용된 멤버는 handle 세대가 달라 건너뜀
+*/
+static void handle_multicast_job(reactor_t* r, job_t* job, uint64_t now_ns)
+{
+	member_set_t* set = job->members;
+
+	if (job->buf->ts_ns)
+		metric_record(MH_LOGIC_TO_SEND, now_ns - job->buf->ts_ns);
+
+	for (int i = 0; i < set->count; ++i) {
+		conn_handle_t h = set->members[i].handle;
+		if (h == job->handle)
+			continue;
+
+		conn_slot_t* slot = slot_map_get(&g_conn_slots, HANDLE_ID(h));
+		if (!slot || atomic_load_explicit(&slot->owner, memory_order_relaxed) != r->id)
+			continue;
+		if (atomic_load_explicit(&slot->gen, memory_order_relaxed) != HANDLE_GEN(h)) {
+			metric_inc(MC_STALE_HANDLES);
+			continue;
+		}
+
+		uring_conn_t* uc = slot->conn;
+		if (packet_send(uc, sbuf_ref(job->buf)) < 0)
+			net_disconnect(r, uc, DISC_SEND_FAILED);
+	}
+
+	member_set_release(set);
+	sbuf_release(job->buf);
+}
+
+/* worker가 요청한 연결 끊기 (이미 끊긴 연결이면 무시) */
+static void handle_close_job(reactor_t* r, job_t* job)
+{
+	uring_conn_t* uc = conn_table_lookup(job->handle, r->id);
+	if (uc)
+		net_disconnect(r, uc, (disc_reason_t)job->reason);
+}
+
+/* 유휴 검사 타이머 만료 (판정 방식은 net.c와 같음) */
+static void conn_idle_expired(void* arg) {
+	uring_conn_t* uc = arg;
+	connection_t* conn = &uc->base;
+	reactor_t* r = &reactors[conn->owner];
+
+	if (conn->paused_by_queue)
+		conn->last_active = r->now_ms;
+
+	uint64_t silent = r->now_ms - conn->last_active;
+	if (silent < IDLE_CHECK_MS) {
+		timer_arm(&r->timers, &conn->idle_timer, conn->last_active + IDLE_CHECK_MS);
+		return;
+	}
+
+	if (silent >= IDLE_TIMEOUT_MS) {
+		LOG_INFO("idle timeout fd=%d silent=%llums", conn->fd, (unsigned long long)silent);
+		net_disconnect(r, uc, DISC_IDLE_TIMEOUT);
+		return;
+	}
+
+	metric_inc(MC_HEARTBEATS_SENT);
+	sbuf_t* hb = sbuf_frame(PKT_HEARTBEAT, NULL, 0);
+	if (!hb || packet_send(uc, hb) < 0) {
+		net_disconnect(r, uc, DISC_SEND_FAILED);
+		return;
+	}
+	/* 응답이 오면 다음 검사에서 다시 heartbeat을 보내고, 오지 않으면 유휴 한도에서 끊음 */
+	uint64_t next = r->now_ms + IDLE_CHECK_MS;
+	uint64_t deadline = conn->last_active + IDLE_TIMEOUT_MS;
+	timer_arm(&r->timers, &conn->idle_timer, (next < deadline) ? next : deadline);
+}
+
+/* reactor의 io_q 현재 깊이와 최고 수위 조회 (지표 수집용) */
+void net_io_queue_stats(int reactor, size_t* depth, size_t* hwm) {
+	*depth = mpsc_queue_depth(&reactors[reactor].io_q);
+	*hwm = __atomic_load_n(&reactors[reactor].io_q.hwm, __ATOMIC_RELAXED);
+}
+
+/* io_q에 쌓인 send 작업을 비우고, 프레임이 쌓인 연결들의 전송을 시작하는 함수 */
+static void drain_io_queue(reactor_t* r) {
+	job_t batch[IO_DRAIN_BATCH];
+
+	/* drain 전에 깨우기 플래그를 먼저 내려야 이후 push된 작업이 다시 깨우기로 이어짐 */
+	atomic_exchange_explicit(&r->wake_pending, false, memory_order_acq_rel);
+
+	int n;
+	while ((n = mpsc_queue_pop_batch(&r->io_q, batch, IO_DRAIN_BATCH)) > 0) {
+		uint64_t now_ns = monotonic_ns();
+		for (int i = 0; i < n; ++i) {
+			if (batch[i].type == JOB_SEND)
+				handle_send_job(r, &batch[i], now_ns);
+			else if (batch[i].type == JOB_MULTICAST)
+				handle_multicast_job(r, &batch[i], now_ns);
+			else if (batch[i].type == JOB_CLOSE)
+				handle_close_job(r, &batch[i]);
+		}
+	}
+
+	/* 송신 합치기 창이 아직 지나지 않았으면 목록을 그대로 두고, 창 끝에 맞춰 건 timeout 요청(arm_wheel_timer)으로 깨어나 보냄 */
+	if (SEND_COALESCE && SEND_COALESCE_WINDOW_MS > 0 && r->flush_list && monotonic_ns() < r->flush_at_ns)
+		return;
+
+	uring_conn_t* uc = r->flush_list;
+	r->flush_list = NULL;
+
+	while (uc) {
+		uring_conn_t* next = uc->flush_next;
+		uc->flush_pending = false;
+
+		/* flush 목록에 오른 뒤 끊긴 연결은 전송하지 않고, 남은 요청이 없으면 여기서 해제 */
+		if (uc->closing)
+			conn_release_if_idle(uc);
+		else if (!uc->base.want_write && start_send(r, uc) < 0)
+			net_disconnect(r, uc, DISC_SEND_FAILED);
+
+		uc = next;
+	}
+}
+
+static void handle_accept(reactor_t* r, struct io_uring_cqe* cqe) {
+	/* multishot이 끝났으면(에러 또는 커널 사정) 다시 걸어둠 */
+	if (!(cqe->flags & IORING_CQE_F_MORE) && !g_terminate)
+		arm_accept(r);
+
+	int client_fd = cqe->res;
+	if (client_fd < 0) {
+		if (client_fd != -EAGAIN && client_fd != -ECANCELED)
+			LOG_ERROR("accept error: %E", -client_fd);
+		return;
+	}
+
+	/* worker 큐가 HIGH 수위 이상이면 받은 연결을 바로 닫아 적체가 풀릴 때까지 새 세션을 받지 않음 (net.c와 같은 방식) */
+	if (logic_overloaded()) {
+		metric_inc(MC_ACCEPTS_SHED);
+		close(client_fd);
+		return;
+	}
+
+	uring_conn_t* uc = conn_alloc(r, client_fd);
+	if (!uc) {
+		close(client_fd);
+		return;
+	}
+
+	uc->base.handle = conn_table_alloc(r->id, uc);
+	if (uc->base.handle == HANDLE_NONE) {
+		LOG_WARN("connection table full (limit=%d), closing fd=%d", conn_table_limit(), client_fd);
+		conn_free(uc);
+		close(client_fd);
+		return;
+	}
+
+	conn_link(r, uc);
+	metric_inc(MC_ACCEPTS);
+
+	if (IDLE_TIMEOUT_MS > 0)
+		timer_arm(&r->timers, &uc->base.idle_timer, r->now_ms + IDLE_CHECK_MS);
+
+	/* multishot accept는 주소를 돌려주지 않으므로, 로그가 켜져 있을 때만 getpeername으로 조회 */
+	struct sockaddr_in client_addr;
+	socklen_t clilen = sizeof(client_addr);
+	if (LOG_LEVEL_INFO >= g_log_level && getpeername(client_fd, (struct sockaddr*)&client_addr, &clilen) == 0)
+		LOG_INFO("Client info : %I:%d (fd=%d reactor=%d)", client_addr.sin_addr.s_addr, ntohs(client_addr.sin_port), client_fd, r->id);
+
+	if (arm_recv(r, uc) < 0)
+		net_disconnect(r, uc, DISC_SETUP_FAILED);
+}
+
+/*
+* 수신 데이터를 연결의 수신 버퍼로 옮기며 파싱하는 함수
+* provided buffer는 곧바로 ring에 돌려줘야 하므로, 패킷 경계에 걸친 조각만 풀에서 빌린 연결의 수신 버퍼에 남김
+* 남은 조각이 없으면 수신 버퍼는 바로 풀에 돌려줌
+* worker 큐가 적체되면 이 완료의 나머지 데이터까지 보류 목록에 파싱해 두고 recv를 취소함
+* 완료 하나가 provided buffer 하나(URING_BUF_SIZE) 이하라 연결별 수신 예산이 따로 없으므로, HIGH 이상이면 어느 연결이든 멈춤
+* 끊어야 하면 끊김 원인, 아니면 -1 반환
+*/
+static int consume_recv(reactor_t* r, uring_conn_t* uc, const char* data, size_t len) {
+	connection_t* conn = &uc->base;
+
+	conn->last_active = r->now_ms;
+	metric_add(MC_BYTES_IN, len);
+
+	/* 이번 완료로 읽은 패킷들은 같은 수신 시각을 공유함 */
+	uint64_t recv_ns = monotonic_ns();
+
+	while (len > 0) {
+		if (protocol_compact(conn) < 0) {
+			LOG_ERROR("recv buffer alloc failed fd=%d", conn->fd);
+			return DISC_RECV_ERROR;
+		}
+
+		size_t space = RECV_BUF_SIZE - conn->recv_len;
+		size_t n = (len < space) ? len : space;
+
+		memcpy(conn->recv_buf + conn->recv_len, data, n);
+		conn->recv_len += (int)n;
+		data += n;
+		len -= n;
+
+		packet_t* pkt;
+		int rc;
+		while ((rc = protocol_parse(conn, &pkt)) > 0) {
+			/* push 이후에는 버퍼 소유권이 worker로 넘어가므로 로그를 먼저 남김 */
+			LOG_DEBUG("[PACKET] fd=%d type=%d len=%d", conn->fd, pkt->type, pkt->length);
+
+			metric_inc(MC_PKT_IN + metric_pkt_slot(pkt->type));
+			pkt->recv_ns = recv_ns;
+
+			/* heartbeat 응답은 마지막 수신 시각을 갱신한 것으로 끝나므로 worker로 넘기지 않음 */
+			if (pkt->type == PKT_HEARTBEAT) {
+				packet_free(pkt);
+				continue;
+			}
+
+			flow_rc_t frc = flow_deliver(conn, pkt, true);
+			if (frc == FLOW_DISCONNECT) {
+				LOG_WARN("rate limit exceeded fd=%d", conn->fd);
+				return DISC_RATE_LIMITED;
+			}
+			if (frc == FLOW_PAUSE && pause_recv(r, uc) < 0) {
+				LOG_ERROR("flow control pause failed fd=%d", conn->fd);
+				return DISC_RECV_ERROR;
+			}
+		}
+
+		if (rc == PROTO_ERR_ALLOC) {
+			LOG_ERROR("packet alloc failed fd=%d", conn->fd);
+			return DISC_RECV_ERROR;
+		}
+		if (rc < 0) {
+			LOG_WARN("protocol violation fd=%d", conn->fd);
+			return DISC_PROTOCOL;
+		}
+	}
+
+	protocol_release(conn, false);
+	return -1;
+}
+
+static void handle_recv(reactor_t* r, uring_conn_t* uc, struct io_uring_cqe* cqe) {
+	bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+	int res = cqe->res;
+
+	if (cqe->flags & IORING_CQE_F_BUFFER) {
+		uint16_t bid = (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+
+		if (res > 0 && !uc->closing) {
+			int reason = consume_recv(r, uc, uring_buf_addr(&r->bufs, bid), (size_t)res);
+			if (reason >= 0)
+				net_disconnect(r, uc, (disc_reason_t)reason);
+		}
+
+		uring_buf_recycle(&r->bufs, bid);
+	}
+
+	if (more)
+		return;
+
+	/*
+	* multishot recv가 끝남 : 닫힌 연결이면 객체 정리, 버퍼 부족이나 취소면 다시 걸고, 그 외는 끊김
+	* 읽기를 멈춘 연결은 다시 걸지 않고 resume_reads가 다시 걸 때까지 둠
+	*/
+	uc->recv_armed = false;
+
+	if (uc->closing) {
+		conn_put(uc);
+		return;
+	}
+
+	uc->inflight--;
+
+	if (res == -ENOBUFS || res == -ECANCELED || res > 0) {
+		if (uc->base.paused || arm_recv(r, uc) == 0)
+			return;
+	}
+
+	net_disconnect(r, uc, (res == 0) ? DISC_PEER_CLOSED : DISC_RECV_ERROR);
+}
+
+static void handle_send(reactor_t* r, uring_conn_t* uc, struct io_uring_cqe* cqe) {
+	connection_t* conn = &uc->base;
+	int res = cqe->res;
+
+	conn->want_write = false;
+
+	if (uc->closing) {
+		conn_put(uc);
+		return;
+	}
+
+	uc->inflight--;
+
+	if (res < 0) {
+		if (res != -EAGAIN && res != -EINTR) {
+			net_disconnect(r, uc, DISC_SEND_FAILED);
+			return;
+		}
+		res = 0;
+	}
+
+	send_queue_consume(&conn->sendq, (size_t)res);
+
+	/* soft 한도 초과 상태였다면 줄어든 양으로 다시 판정 */
+	if (send_queue_check_limit(&conn->sendq, monotonic_ms()) < 0) {
+		net_disconnect(r, uc, DISC_SEND_FAILED);
+		return;
+	}
+
+	/* 기다리는 동안 쌓인 프레임이 있으면 이어서 전송하고, 다 보냈으면 sendmsg 인자를 풀에 돌려줌 */
+	if (conn->sendq.count > 0) {
+		if (start_send(r, uc) < 0)
+			net_disconnect(r, uc, DISC_SEND_FAILED);
+	}
+	else {
+		io_buf_put(IO_BUF_SEND, uc->send);
+		uc->send = NULL;
+	}
+}
+
+static void handle_cqe(reactor_t* r, struct io_uring_cqe* cqe) {
+	uint64_t tag = cqe->user_data & UD_TAG_MASK;
+	uring_conn_t* uc = (uring_conn_t*)(uintptr_t)(cqe->user_data & ~UD_TAG_MASK);
+
+	switch (tag) {
+	case UD_ACCEPT:
+		handle_accept(r, cqe);
+		break;
+	case UD_RECV:
+		handle_recv(r, uc, cqe);
+		break;
+	case UD_SEND:
+		handle_send(r, uc, cqe);
+		break;
+	case UD_WAKE:
+		/* io_q는 루프마다 비우므로 깨우기 이벤트 자체는 처리할 내용이 없음 */
+		break;
+	case UD_CANCEL:
+		break;
+	case UD_FLOW_TIMER:
+		r->flow_timer_armed = false;
+		break;
+	case UD_WHEEL_TIMER:
+		r->wheel_timer_armed = false;
+		break;
+	}
+}
+
+/* reactor 하나를 초기화하는 함수 (listen 소켓은 epoll reactor와 같은 방식으로 SO_REUSEPORT) */
+static int reactor_init(reactor_t* r, int id) {
+	struct sockaddr_in addr;
+	int opt = 1;
+
+	r->id = id;
+	r->listen_fd = -1;
+	r->ring.fd = -1;
+	r->flush_list = NULL;
+	r->conn_pool_count = 0;
+	r->live_head = NULL;
+	memset(&r->flow, 0, sizeof(r->flow));
+	r->flow_ts.tv_sec = 0;
+	r->flow_ts.tv_nsec = FLOW_RETRY_MS * 1000000LL;
+	r->flow_timer_armed = false;
+	r->now_ms = monotonic_ms();
+	timer_wheel_init(&r->timers, r->now_ms);
+	r->wheel_timer_armed = false;
+	atomic_init(&r->wake_pending, false);
+	mpsc_queue_init(&r->io_q);
+
+	if ((r->listen_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+		perror("socket error");
+		return -1;
+	}
+
+	if ((setsockopt(r->listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) < 0) {
+		perror("setsockopt error");
+		return -1;
+	}
+
+	if ((setsockopt(r->listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt))) < 0) {
+		perror("setsockopt SO_REUSEPORT error");
+		return -1;
+	}
+
+	memset(&addr, 0x00, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(PORTNUM);
+
+	if (bind(r->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+		perror("bind error");
+		return -1;
+	}
+
+	if (listen(r->listen_fd, LISTEN_BACKLOG) < 0) {
+		perror("listen error");
+		return -1;
+	}
+
+	if (uring_init(&r->ring, URING_SQ_ENTRIES, URING_CQ_ENTRIES, IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN) < 0) {
+		perror("io_uring_setup error");
+		return -1;
+	}
+
+	if (uring_buf_ring_init(&r->ring, &r->bufs, URING_BGID, URING_BUF_COUNT, URING_BUF_SIZE) < 0) {
+		perror("io_uring provided buffer ring error");
+		return -1;
+	}
+
+	arm_accept(r);
+	return 0;
+}
+
+int net_init() {
+	for (int i = 0; i < NET_THREAD_NUM; ++i) {
+		if (reactor_init(&reactors[i], i) < 0)
+			return -1;
+	}
+
+	LOG_INFO("Server is operating on port %d (reactors=%d, io_uring)", PORTNUM, NET_THREAD_NUM);
+	return 0;
+}
+
+/*
+* 미뤄둔 끊김 이벤트를 다시 넣고, 읽기를 멈춘 연결 중 보류 패킷을 모두 넘긴 연결(flow_try_resume)의 recv를 다시 거는 함수
+* 취소한 recv의 완료 이벤트가 아직 오지 않았으면 그 완료 이벤트에서 다시 걸림
+*/
+static void resume_reads(reactor_t* r) {
+	flow_retry(&r->flow);
+
+	handle_list_t* paused = &r->flow.paused;
+	if (paused->count > 0) {
+		int kept = 0;
+		for (int i = 0; i < paused->count; ++i) {
+			conn_handle_t h = paused->items[i];
+			uring_conn_t* uc = conn_table_lookup(h, r->id);
+			if (!uc || !uc->base.paused)
+				continue;
+
+			int rc = flow_try_resume(&uc->base);
+			if (rc < 0) {
+				net_disconnect(r, uc, DISC_RATE_LIMITED);
+				continue;
+			}
+			if (rc == 0) {
+				paused->items[kept++] = h;
+				continue;
+			}
+
+			if (!uc->recv_armed && arm_recv(r, uc) < 0)
+				net_disconnect(r, uc, DISC_RECV_ERROR);
+		}
+		paused->count = kept;
+	}
+
+	/* 아직 남은 일이 있으면 깨우기가 없어도 주기적으로 다시 확인하도록 timeout을 걸어 둠 */
+	if (flow_pending(&r->flow) && !r->flow_timer_armed) {
+		struct io_uring_sqe* sqe = uring_get_sqe(&r->ring);
+		if (!sqe) return;
+
+		sqe->opcode = IORING_OP_TIMEOUT;
+		sqe->fd = -1;
+		sqe->addr = (uint64_t)(uintptr_t)&r->flow_ts;
+		sqe->len = 1;
+		sqe->user_data = ud_make(NULL, UD_FLOW_TIMER);
+		r->flow_timer_armed = true;
+	}
+}
+
+/*
+* 타이머 휠의 다음 처리 시각(송신 합치기 창이 남았으면 그 끝과 비교해 이른 쪽)에 맞춰 timeout 요청을 거는 함수
+* 걸린 요청이 없으면 새로 걸고, 걸린 요청보다 이른 시각이 필요할 때만 IORING_TIMEOUT_UPDATE로 만료 시각을 당김
+* (당긴 뒤 원래 요청은 새 시각에 완료 이벤트 하나로 끝나며, 갱신 요청 자체의 완료 이벤트는 무시함)
+*/
+static void arm_wheel_timer(reactor_t* r) {
+	uint64_t next = timer_wheel_next(&r->timers);
+	if (SEND_COALESCE && SEND_COALESCE_WINDOW_MS > 0 && r->flush_list) {
+		uint64_t flush_ms = (r->flush_at_ns + 999999) / 1000000;
+		if (flush_ms < next)
+			next = flush_ms;
+	}
+	if (next == UINT64_MAX || (r->wheel_timer_armed && next >= r->wheel_deadline))
+		return;
+
+	struct io_uring_sqe* sqe = uring_get_sqe(&r->ring);
+	if (!sqe) return;
+
+	/* 단조 시계의 절대 시각 대신 지금부터의 상대 시간을 씀 (monotonic_ms는 coarse 시계라 조금 늦을 수 있음) */
+	uint64_t now = monotonic_ms();
+	uint64_t delay = (next > now) ? next - now : 0;
+	r->wheel_ts.tv_sec = (long long)(delay / 1000);
+	r->wheel_ts.tv_nsec = (long long)(delay % 1000) * 1000000LL;
+
+	sqe->fd = -1;
+	if (!r->wheel_timer_armed) {
+		sqe->opcode = IORING_OP_TIMEOUT;
+		sqe->addr = (uint64_t)(uintptr_t)&r->wheel_ts;
+		sqe->len = 1;
+		sqe->user_data = ud_make(NULL, UD_WHEEL_TIMER);
+	}
+	else {
+		sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+		sqe->addr = ud_make(NULL, UD_WHEEL_TIMER);
+		sqe->off = (uint64_t)(uintptr_t)&r->wheel_ts;
+		sqe->timeout_flags = IORING_TIMEOUT_UPDATE;
+		sqe->user_data = ud_make(NULL, UD_CANCEL);
+	}
+
+	r->wheel_deadline = next;
+	r->wheel_timer_armed = true;
+}
+
+/*
+* reactor 하나의 이벤트 루프
+* 이전 루프에서 쌓인 요청 제출과 완료 대기를 io_uring_enter 한 번으로 처리한 뒤, 쌓인 CQE를 모두 처리함
+*/
+static void reactor_run(reactor_t* r) {
+	while (!g_terminate) {
+		if (uring_submit(&r->ring, 1) < 0) {
+			if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+				continue;
+			LOG_ERROR("io_uring_enter error: %E", errno);
+			break;
+		}
+
+		r->now_ms = monotonic_ms();
+
+		struct io_uring_cqe* cqe;
+		while ((cqe = uring_peek_cqe(&r->ring)) != NULL) {
+			handle_cqe(r, cqe);
+			uring_cqe_seen(&r->ring);
+		}
+
+		/* 만료 콜백이 보낸 heartbeat도 이번 루프의 flush에 실리도록 drain보다 먼저 처리함 */
+		if (r->timers.count > 0)
+			metric_add(MC_TIMERS_FIRED, (uint64_t)timer_wheel_advance(&r->timers, r->now_ms));
+
+		drain_io_queue(r);
+
+		if (flow_pending(&r->flow))
+			resume_reads(r);
+
+		if (r->timers.count > 0 || r->flush_list)
+			arm_wheel_timer(r);
+	}
+
+	if (r->listen_fd >= 0) {
+		close(r->listen_fd);
+		r->listen_fd = -1;
+	}
+
+	while (r->live_head)
+		close_connection(r, (uring_conn_t*)r->live_head);
+	flow_destroy(&r->flow);
+
+	/* ring을 닫으면 커널이 남은 요청을 정리하며, 완료 이벤트를 기다리던 연결 객체는 프로세스 종료 시 함께 회수됨 */
+	uring_exit(&r->ring);
+	uring_buf_ring_free(&r->bufs);
+
+	while (r->conn_pool_count > 0)
+		free(r->conn_pool[--r->conn_pool_count]);
+}
+
+static void* reactor_thread(void* arg) {
+	reactor_run((reactor_t*)arg);
+	return NULL;
+}
+
+/*
+* 네트워크 이벤트 루프 실행
+* reactor 0은 호출한 스레드(main)에서, 나머지는 별도 스레드에서 실행
+* main이 시그널을 받으면 io_uring_enter가 EINTR로 돌아와 g_terminate를 확인함
+*/
+void net_run() {
+	sigset_t set, old;
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &set, &old);
+
+	for (int i = 1; i < NET_THREAD_NUM; ++i) {
+		if (pthread_create(&reactors[i].tid, NULL, reactor_thread, &reactors[i]) != 0) {
+			perror("pthread_create");
+			exit(1);
+		}
+	}
+
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	reactor_run(&reactors[0]);
+
+	g_terminate = 1;
+	for (int i = 1; i < NET_THREAD_NUM; ++i) {
+		ring_msg_wake(&reactors[i]);
+		pthread_join(reactors[i].tid, NULL);
+	}
+}
+
+#endif
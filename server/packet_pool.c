@@ -0,0 +1,124 @@
+#include "packet_pool.h"
+
+/* size class별 payload 용량 */
+static const size_t class_size[PACKET_POOL_CLASSES] = { 64, 256, MAX_PACKET_SIZE };
+
+/* 스레드 로컬 캐시 한도와, 전역 저장소와 한 번에 주고받는 묶음 크기 */
+#define POOL_CACHE_MAX 128
+#define POOL_BATCH 32
+
+/*
+* 전역 저장소
+* 할당은 reactor(protocol_parse)만 하고, 해제는 주로 worker가 함
+* - worker : 처리를 마친 JOB_PACKET, 다른 worker로 넘겨 처리한 방 작업, 자기 방이라 바로 처리한 방 작업(post_room_job), 종료 시 넘기지 못한 방 작업
+* - reactor : heartbeat 응답과 속도 제한으로 버린 패킷, 닫히는 연결의 보류 패킷(flow_drop_stalled)
+* 그래서 버퍼는 대부분 reactor -> worker 방향으로 흐르며, reactor가 해제한 버퍼는 자기 캐시에 남아 다음 할당에 바로 쓰임
+* 캐시가 넘치면(주로 worker) 묶음으로 반납하고, 캐시가 비면(주로 reactor) 묶음으로 가져감
+*/
+typedef struct {
+	packet_t* head;
+	int count;
+	pthread_mutex_t lock;
+} pool_depot_t;
+
+static pool_depot_t depot[PACKET_POOL_CLASSES] = {
+	{ NULL, 0, PTHREAD_MUTEX_INITIALIZER },
+	{ NULL, 0, PTHREAD_MUTEX_INITIALIZER },
+	{ NULL, 0, PTHREAD_MUTEX_INITIALIZER },
+};
+
+/* 스레드 로컬 캐시 (락 없이 접근) */
+typedef struct {
+	packet_t* head;
+	int count;
+} pool_cache_t;
+
+static __thread pool_cache_t cache[PACKET_POOL_CLASSES];
+
+/* payload 길이에 맞는 size class 탐색, 범위를 넘으면 -1 */
+static int size_class_of(size_t payload_len) {
+	for (int c = 0; c < PACKET_POOL_CLASSES; ++c) {
+		if (payload_len <= class_size[c])
+			return c;
+	}
+	return -1;
+}
+
+/* 전역 저장소에서 최대 POOL_BATCH개를 로컬 캐시로 가져오는 함수 */
+static void cache_refill(int c) {
+	pool_depot_t* d = &depot[c];
+
+	pthread_mutex_lock(&d->lock);
+	for (int i = 0; i < POOL_BATCH && d->head; ++i) {
+		packet_t* p = d->head;
+		d->head = p->next;
+		d->count--;
+
+		p->next = cache[c].head;
+		cache[c].head = p;
+		cache[c].count++;
+	}
+	pthread_mutex_unlock(&d->lock);
+}
+
+/* 로컬 캐시에서 POOL_BATCH개를 전역 저장소로 반납하는 함수 */
+static void cache_flush(int c) {
+	pool_depot_t* d = &depot[c];
+
+	pthread_mutex_lock(&d->lock);
+	for (int i = 0; i < POOL_BATCH && cache[c].head; ++i) {
+		packet_t* p = cache[c].head;
+		cache[c].head = p->next;
+		cache[c].count--;
+
+		p->next = d->head;
+		d->head = p;
+		d->count++;
+	}
+	pthread_mutex_unlock(&d->lock);
+}
+
+/*
+* payload_len 바이트를 담을 수 있는 패킷 버퍼를 할당하는 함수
+* 로컬 캐시 -> 전역 저장소 -> malloc 순서로 확보
+*/
+packet_t* packet_alloc(size_t payload_len) {
+	int c = size_class_of(payload_len);
+	if (c < 0)
+		return NULL;
+
+	if (!cache[c].head)
+		cache_refill(c);
+
+	packet_t* p = cache[c].head;
+	if (p) {
+		cache[c].head = p->next;
+		cache[c].count--;
+	}
+	else {
+		p = malloc(sizeof(packet_t) + class_size[c]);
+		if (!p)
+			return NULL;
+	}
+
+	p->next = NULL;
+	p->size_class = (uint8_t)c;
+	p->charged = 0;
+	p->type = 0;
+	p->length = 0;
+	return p;
+}
+
+/* 패킷 버퍼를 현재 스레드의 캐시로 반납하는 함수, 캐시가 넘치면 일부를 전역 저장소로 보냄 */
+void packet_free(packet_t* pkt) {
+	if (!pkt)
+		return;
+
+	int c = pkt->size_class;
+	pkt->next = cache[c].head;
+	cache[c].head = pkt;
+	cache[c].count++;
+
+	if (cache[c].count > POOL_CACHE_MAX)
+		cache_flush(c);
+}
@@ -0,0 +1,16 @@
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include "common.h"
+
+/*
+* 수신 패킷용 slab 풀
+* payload 용량 기준 size class(64 / 256 / 1024)별로 스레드 로컬 캐시를 두고,
+* 캐시가 넘치거나 비면 전역 저장소와 묶음 단위로 주고받음
+*/
+#define PACKET_POOL_CLASSES 3
+
+packet_t* packet_alloc(size_t payload_len);
+void packet_free(packet_t* pkt);
+
+#endif
@@ -1,70 +1,130 @@
-#include "protocol.h"
-
-int protocol_parse(connection_t* conn, packet_t* out)
-{
-    /*
-    * ּ  ũ ˻
-    * legnth type   uint16_t
-    * length(2) + type(2) = ּ 4Ʈ ʿ
-    */
-    if (conn->recv_len < 4)
-        return 0;
-
-    /*
-    * Ŷ  ʵ  : recv_buf[0~1]
-    * pkt_len = (type + payload) 
-    *  ȣƮ  ȯ
-    */
-    uint16_t pkt_len;
-    memcpy(&pkt_len, conn->recv_buf, sizeof(uint16_t));
-    pkt_len = ntohs(pkt_len);
-
-    /*
-    *  Ŷ  Ȯ
-    * ü Ŷ ̰ 2 ۰ų ִ (payload + length) ũ⸦ ʰϸ  Ŷ Ǵ
-    */
-    if (pkt_len < 2 || pkt_len >(MAX_PACKET_SIZE + 2)) 
-        return -1;
-
-    /* 
-    * ü Ŷ    
-    * ,  ŵ Ʈ  < (type + payload) + length(2) 
-    */
-    if ((size_t)conn->recv_len < pkt_len + sizeof(uint16_t))
-        return 0;
-    
-    /*
-    * Ŷ Ÿ ʵ  : recv_buf[2~3]
-    *  ȣƮ  ȯ
-    */
-    uint16_t pkt_type;
-    memcpy(&pkt_type, conn->recv_buf + 2, sizeof(uint16_t));
-    pkt_type = ntohs(pkt_type);
-
-    /* Ľ  out Ŷ  */
-    out->length = pkt_len;
-    out->type = pkt_type;
-
-    /*
-    * ü Ŷ ŵǾ Ȯ
-    * payload_len = pkt_len(type + payload ) - type ʵ (2)
-    *   recv Ŷ ü ðŶ   
-    */
-    int payload_len = pkt_len - sizeof(uint16_t);
-    if (payload_len > 0) {
-        memcpy(out->payload, conn->recv_buf + 4, payload_len);
-    }
-
-    /*
-    * recv  
-    *  Ʈ  =  ŵ ü Ʈ  - (pkt_len + length ʵ (2))
-    *  Ŷ  κ( Ŷ  ġ) = conn->recv_buf + pkt_len + 2
-    *  Ŷ ϰ, ڿ  ( Ŷ Ǵ Ϻ Ŷ)   
-    */
-    int remain = conn->recv_len - (pkt_len + 2);
-    memmove(conn->recv_buf, conn->recv_buf + pkt_len + 2, remain);
-    conn->recv_len = remain;
-
-    /* Ľ  */
-    return 1;
-}
+#include "protocol.h"
+#include "packet_pool.h"
+#include "io_buf.h"
+
+/* 프레임 하나의 최대 크기 : length(2) + type(2) + payload */
+#define MAX_FRAME_SIZE (MAX_PACKET_SIZE + 4)
+
+/*
+* recv 전에 수신 버퍼의 빈 공간을 확보하는 함수
+* 수신 버퍼가 없으면 io_buf 풀에서 빌려 오며, 빌리지 못하면 -1 반환
+* 파싱은 recv_head 커서만 앞으로 옮기므로 패킷마다 데이터를 당기지 않음
+* 모두 소비했으면 커서만 처음으로 되돌리고, 남은 공간에 최대 크기 프레임이 들어가지 않을 때만
+* 아직 덜 들어온 마지막 프레임 조각을 버퍼 앞으로 한 번 옮김
+*/
+int protocol_compact(connection_t* conn)
+{
+    if (!conn->recv_buf) {
+        conn->recv_buf = io_buf_get(IO_BUF_RECV);
+        conn->recv_head = conn->recv_len = 0;
+        return conn->recv_buf ? 0 : -1;
+    }
+
+    if (conn->recv_head == conn->recv_len) {
+        conn->recv_head = conn->recv_len = 0;
+        return 0;
+    }
+
+    if (RECV_BUF_SIZE - conn->recv_len >= MAX_FRAME_SIZE)
+        return 0;
+
+    int remain = conn->recv_len - conn->recv_head;
+    memmove(conn->recv_buf, conn->recv_buf + conn->recv_head, remain);
+    conn->recv_head = 0;
+    conn->recv_len = remain;
+    return 0;
+}
+
+/*
+* 수신 버퍼를 풀에 돌려주는 함수
+* 읽을 데이터를 모두 처리한 뒤 호출하며, 덜 들어온 프레임 조각이 남아 있으면 다음 recv까지 버퍼를 유지함
+* force이면 남은 조각과 관계없이 돌려줌 (연결을 닫을 때)
+*/
+void protocol_release(connection_t* conn, bool force)
+{
+    if (!conn->recv_buf || (!force && conn->recv_head != conn->recv_len))
+        return;
+
+    io_buf_put(IO_BUF_RECV, conn->recv_buf);
+    conn->recv_buf = NULL;
+    conn->recv_head = conn->recv_len = 0;
+}
+
+int protocol_parse(connection_t* conn, packet_t** out)
+{
+    /* 아직 파싱하지 않은 데이터의 시작 위치와 길이 */
+    const char* p = conn->recv_buf + conn->recv_head;
+    int avail = conn->recv_len - conn->recv_head;
+
+    /*
+    * 최소 헤더 크기 검사
+    * legnth와 type 모두 각각 uint16_t
+    * length(2) + type(2) = 최소 4바이트 필요
+    */
+    if (avail < 4)
+        return 0;
+
+    /*
+    * 패킷 길이 필드 추출 : p[0~1]
+    * pkt_len = (type + payload)의 길이
+    * 이후 호스트 순서로 변환
+    */
+    uint16_t pkt_len;
+    memcpy(&pkt_len, p, sizeof(uint16_t));
+    pkt_len = ntohs(pkt_len);
+
+    /*
+    * 정상 패킷 여부 확인
+    * 전체 패킷 길이가 2보다 작거나 최대 (payload + length) 크기를 초과하면 비정상 패킷으로 판단
+    */
+    if (pkt_len < 2 || pkt_len >(MAX_PACKET_SIZE + 2)) 
+        return PROTO_ERR_FRAME;
+
+    /* 
+    * 전체 패킷이 아직 안 들어옴 
+    * 즉, 현재 수신된 바이트 수 < (type + payload) + length(2)인 경우
+    */
+    if ((size_t)avail < pkt_len + sizeof(uint16_t))
+        return 0;
+    
+    /*
+    * 패킷 타입 필드 추출 : p[2~3]
+    * 이후 호스트 순서로 변환
+    */
+    uint16_t pkt_type;
+    memcpy(&pkt_type, p + 2, sizeof(uint16_t));
+    pkt_type = ntohs(pkt_type);
+
+    /*
+    * payload 크기에 맞는 풀 버퍼를 할당해 파싱 결과를 바로 기록
+    * 버퍼는 job에 담겨 worker로 넘어가고, 로직 처리 후 풀로 반납됨
+    * 할당 실패는 클라이언트의 프로토콜 위반이 아니므로 따로 알림 (커서는 그대로 둠)
+    */
+    int payload_len = pkt_len - sizeof(uint16_t);
+    packet_t* pkt = packet_alloc(payload_len);
+    if (!pkt)
+        return PROTO_ERR_ALLOC;
+
+    pkt->length = pkt_len;
+    pkt->type = pkt_type;
+
+    /*
+    * 전체 패킷이 수신되었는지 확인
+    * payload_len = pkt_len(type + payload의 길이) - type 필드의 길이(2)
+    * 한 번의 recv로 패킷 전체가 들어올거라는 보장이 없기 때문
+    */
+    if (payload_len > 0) {
+        memcpy(pkt->payload, p + 4, payload_len);
+    }
+
+    /*
+    * 커서 이동
+    * 현재 패킷의 끝 부분(다음 패킷의 시작 위치) = recv_head + pkt_len + length 필드의 길이(2)
+    * 데이터는 그대로 두고 커서만 옮기며, 버퍼 정리는 다음 recv 전에 protocol_compact에서 한 번에 수행
+    */
+    conn->recv_head += pkt_len + 2;
+
+    /* 파싱 성공 */
+    *out = pkt;
+    return 1;
+}
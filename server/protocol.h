@@ -3,6 +3,15 @@
 
 #include "common.h"
 
-int protocol_parse(connection_t* conn, packet_t* out);
+int protocol_compact(connection_t* conn);
+void protocol_release(connection_t* conn, bool force);
+/*
+* protocol_parse 결과 : 1이면 패킷 하나를 파싱해 *out에 담음, 0이면 프레임이 아직 덜 들어옴
+* 음수는 연결을 끊어야 하는 경우이며, 클라이언트 잘못인 프레이밍 오류와 서버 쪽 할당 실패를 구분함
+*/
+#define PROTO_ERR_FRAME -1		// 길이 필드가 범위를 벗어남 (DISC_PROTOCOL)
+#define PROTO_ERR_ALLOC -2		// 패킷 버퍼를 할당하지 못함 (DISC_RECV_ERROR)
+
+int protocol_parse(connection_t* conn, packet_t** out);
 
 #endif
@@ -0,0 +1,69 @@
+#include "rate_limit.h"
+#include "metrics.h"
+
+typedef struct {
+	uint32_t per_sec;				// 초당 허용 패킷 수 (0이면 제한 없음)
+	uint32_t burst;					// 최대 토큰 수
+	rl_action_t action;				// 한도를 넘었을 때 동작
+} rate_rule_t;
+
+/* 0번은 연결 전체 한도, 나머지는 패킷 종류 번호 (설정이 없는 종류는 연결 한도만 적용) */
+static const rate_rule_t rules[RATE_LIMITS] = {
+	[0]					= { RATE_CONN_PER_SEC, RATE_CONN_BURST, RATE_CONN_ACTION },
+	[PKT_CHAT]			= { RATE_CHAT_PER_SEC, RATE_CHAT_BURST, RATE_CHAT_ACTION },
+	[PKT_JOIN_ROOM]		= { RATE_ROOM_PER_SEC, RATE_ROOM_BURST, RATE_ROOM_ACTION },
+	[PKT_LEAVE_ROOM]	= { RATE_ROOM_PER_SEC, RATE_ROOM_BURST, RATE_ROOM_ACTION },
+	[PKT_GAME_ACTION]	= { RATE_GAME_ACTION_PER_SEC, RATE_GAME_ACTION_BURST, RATE_GAME_ACTION_ACTION },
+};
+
+/* 토큰 하나의 크기 (버킷은 1/1000 단위로 보관) */
+#define TOKEN 1000u
+
+void rate_limit_init(connection_t* conn, uint64_t now_ms) {
+	for (int i = 0; i < RATE_LIMITS; ++i) {
+		conn->rate[i].tokens = rules[i].burst * TOKEN;
+		conn->rate[i].last_ms = (uint32_t)now_ms;
+	}
+	conn->throttled_until = 0;
+}
+
+/* 마지막으로 채운 뒤 지난 시간만큼 토큰을 채우고, 토큰 하나가 남아 있는지 반환 */
+static bool bucket_ready(rate_bucket_t* b, const rate_rule_t* rule, uint32_t now) {
+	uint32_t elapsed = now - b->last_ms;
+	if (elapsed > 0) {
+		uint64_t tokens = (uint64_t)b->tokens + (uint64_t)elapsed * rule->per_sec;
+		uint64_t cap = (uint64_t)rule->burst * TOKEN;
+		b->tokens = (uint32_t)(tokens < cap ? tokens : cap);
+		b->last_ms = now;
+	}
+	return b->tokens >= TOKEN;
+}
+
+/* 한도를 넘은 결과 기록, RL_DELAY이면 토큰 하나가 찰 때까지 기다릴 시각을 정함 */
+static rl_action_t limited(connection_t* conn, int limit, uint64_t now_ms) {
+	const rate_rule_t* rule = &rules[limit];
+	metric_inc(MC_RATE_LIMITED + limit * (RL_ACTION_COUNT - 1) + (rule->action - 1));
+
+	if (rule->action == RL_DELAY) {
+		uint32_t missing = TOKEN - conn->rate[limit].tokens;
+		conn->throttled_until = now_ms + (missing + rule->per_sec - 1) / rule->per_sec;
+	}
+	return rule->action;
+}
+
+rl_action_t rate_limit_check(connection_t* conn, uint16_t type, uint64_t now_ms) {
+	uint32_t now = (uint32_t)now_ms;
+	int t = (type > 0 && type < RATE_LIMITS && rules[type].per_sec > 0) ? type : -1;
+
+	if (t > 0 && !bucket_ready(&conn->rate[t], &rules[t], now))
+		return limited(conn, t, now_ms);
+	if (rules[0].per_sec > 0 && !bucket_ready(&conn->rate[0], &rules[0], now))
+		return limited(conn, 0, now_ms);
+
+	/* 두 한도를 모두 통과한 경우에만 토큰을 씀 */
+	if (t > 0)
+		conn->rate[t].tokens -= TOKEN;
+	if (rules[0].per_sec > 0)
+		conn->rate[0].tokens -= TOKEN;
+	return RL_PASS;
+}
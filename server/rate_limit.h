@@ -0,0 +1,22 @@
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include "common.h"
+
+/*
+* 연결별 수신 속도 제한 (token bucket)
+* 한도는 common.h의 RATE_* 설정으로 정하며, 연결 전체 한도 하나와 패킷 종류별 한도를 둠
+* reactor가 패킷을 worker 큐에 넘기기 직전에(flow.c) 검사하고, 버킷 상태는 담당 reactor만 접근하므로 락이 없음
+*/
+
+/* 새 연결의 버킷을 가득 채운 상태로 초기화 */
+void rate_limit_init(connection_t* conn, uint64_t now_ms);
+
+/*
+* 패킷 하나를 넘겨도 되는지 검사하는 함수
+* 통과하면 해당 버킷들에서 토큰을 하나씩 쓰고 RL_PASS, 넘으면 그 한도에 설정된 동작을 반환하며 토큰은 쓰지 않음
+* RL_DELAY이면 토큰이 찰 시각을 conn->throttled_until에 기록함
+*/
+rl_action_t rate_limit_check(connection_t* conn, uint16_t type, uint64_t now_ms);
+
+#endif
@@ -0,0 +1,51 @@
+#include "sbuf.h"
+
+/* 프레임 헤더 크기 : length(2) + type(2) */
+#define FRAME_HDR_SIZE 4
+
+/* len 바이트 크기의 버퍼를 참조 카운트 1로 할당하는 함수 */
+sbuf_t* sbuf_alloc(uint32_t len) {
+	sbuf_t* b = malloc(sizeof(sbuf_t) + len);
+	if (!b)
+		return NULL;
+
+	atomic_init(&b->refcnt, 1);
+	b->len = len;
+	b->ts_ns = 0;
+	return b;
+}
+
+/*
+* 패킷 하나를 송신 프레임으로 직렬화하는 함수
+* length 필드는 (type + payload) 길이이며, 헤더는 network order로 기록
+*/
+sbuf_t* sbuf_frame(uint16_t type, const void* payload, uint16_t payload_len) {
+	sbuf_t* b = sbuf_alloc(FRAME_HDR_SIZE + payload_len);
+	if (!b)
+		return NULL;
+
+	uint16_t net_len = htons((uint16_t)(2 + payload_len));
+	uint16_t net_type = htons(type);
+	memcpy(b->data, &net_len, 2);
+	memcpy(b->data + 2, &net_type, 2);
+
+	if (payload_len > 0)
+		memcpy(b->data + FRAME_HDR_SIZE, payload, payload_len);
+
+	return b;
+}
+
+/* 참조를 하나 추가하는 함수, 이미 참조를 가진 쪽에서만 호출하므로 relaxed로 충분 */
+sbuf_t* sbuf_ref(sbuf_t* b) {
+	atomic_fetch_add_explicit(&b->refcnt, 1, memory_order_relaxed);
+	return b;
+}
+
+/* 참조를 하나 반납하는 함수, 마지막 참조였다면 버퍼 해제 */
+void sbuf_release(sbuf_t* b) {
+	if (!b)
+		return;
+
+	if (atomic_fetch_sub_explicit(&b->refcnt, 1, memory_order_acq_rel) == 1)
+		free(b);
+}
@@ -0,0 +1,24 @@
+#ifndef SBUF_H
+#define SBUF_H
+
+#include "common.h"
+
+/*
+* 참조 카운트 기반 공유 송신 버퍼
+* 브로드캐스트 프레임을 한 번만 직렬화(length/type 헤더는 network order)해 두고
+* 각 수신자의 send 작업과 송신 큐는 버퍼를 복사하지 않고 참조만 보관함
+*/
+typedef struct sbuf {
+	atomic_int refcnt;
+	uint32_t len;		// data에 담긴 프레임 전체 길이 (헤더 포함)
+	uint64_t ts_ns;		// logic이 프레임을 만든 시각 (monotonic_ns), 0이면 측정하지 않음
+	char data[];
+} sbuf_t;
+
+sbuf_t* sbuf_alloc(uint32_t len);
+sbuf_t* sbuf_frame(uint16_t type, const void* payload, uint16_t payload_len);
+
+sbuf_t* sbuf_ref(sbuf_t* b);
+void sbuf_release(sbuf_t* b);
+
+#endif
@@ -0,0 +1,241 @@
+#include "send_queue.h"
+#include "sbuf.h"
+#include "metrics.h"
+#include "io_buf.h"
+
+/* chunk 하나에 담는 프레임 참조 수 (chunk 전체가 io_buf 송신 블록 하나에 들어가도록 정함) */
+#define SEND_CHUNK_LEN ((int)((IO_BUF_SEND_SIZE - 2 * sizeof(void*)) / sizeof(struct sbuf*)))
+
+/*
+* 송신 큐 chunk
+* [head, tail) 구간에 아직 보내지 못한 프레임 참조가 들어 있음
+*/
+typedef struct send_chunk {
+	struct send_chunk* next;
+	int head;
+	int tail;
+	struct sbuf* bufs[SEND_CHUNK_LEN];
+} send_chunk_t;
+
+_Static_assert(sizeof(send_chunk_t) <= IO_BUF_SEND_SIZE, "send chunk must fit in an io_buf send block");
+
+/* 송신 큐 초기화 함수 */
+void send_queue_init(send_queue_t* q) {
+	memset(q, 0, sizeof(*q));
+}
+
+/* io_buf 풀에서 빈 chunk를 빌리는 함수 */
+static send_chunk_t* chunk_get(void) {
+	send_chunk_t* c = io_buf_get(IO_BUF_SEND);
+	if (!c)
+		return NULL;
+
+	c->next = NULL;
+	c->head = c->tail = 0;
+	return c;
+}
+
+/* 큐에 남은 모든 프레임 참조와 chunk를 정리하는 함수 */
+void send_queue_clear(send_queue_t* q) {
+	send_chunk_t* c = q->head;
+	while (c) {
+		send_chunk_t* next = c->next;
+		for (int i = c->head; i < c->tail; ++i)
+			sbuf_release(c->bufs[i]);
+		io_buf_put(IO_BUF_SEND, c);
+		c = next;
+	}
+
+	memset(q, 0, sizeof(*q));
+}
+
+/*
+* 프레임 참조 하나를 큐 뒤에 붙이는 함수
+* 마지막 chunk가 가득 차면 새 chunk를 이어 붙이며, chunk 할당 실패 시 -1 반환(참조는 호출자에게 남음)
+*/
+int send_queue_push(send_queue_t* q, struct sbuf* buf) {
+	if (!q->tail || q->tail->tail == SEND_CHUNK_LEN) {
+		send_chunk_t* c = chunk_get();
+		if (!c)
+			return -1;
+
+		if (q->tail)
+			q->tail->next = c;
+		else
+			q->head = c;
+		q->tail = c;
+	}
+
+	q->tail->bufs[q->tail->tail++] = buf;
+	q->count++;
+	q->bytes += buf->len;
+	return 0;
+}
+
+#if SEND_BUNDLE
+/*
+* 큐 맨 앞부터 최대 max개 프레임을 PKT_BUNDLE 하나로 묶는 함수
+* 묶음 머리만 따로 만들고 본문은 큐의 프레임을 그대로 보내므로 복사가 없으며, 다 보낼 때까지 다른 데이터가 끼어들지 않음
+* 프레임 경계에서 시작할 때(offset == 0) 두 개 이상 묶이는 경우에만 묶고, 본문은 SEND_BUNDLE_MAX 바이트를 넘지 않음
+*/
+static void bundle_begin(send_queue_t* q, int max) {
+	if (q->count < 2 || q->offset != 0)
+		return;
+
+	uint32_t body = 0;
+	int n = 0;
+	for (send_chunk_t* c = q->head; c && n < max; c = c->next) {
+		for (int i = c->head; i < c->tail && n < max; ++i) {
+			if (body + c->bufs[i]->len > SEND_BUNDLE_MAX)
+				goto done;
+			body += c->bufs[i]->len;
+			n++;
+		}
+	}
+
+done:
+	if (n < 2)
+		return;
+
+	uint16_t net_len = htons((uint16_t)(2 + body));
+	uint16_t net_type = htons(PKT_BUNDLE);
+	memcpy(q->bundle_hdr, &net_len, 2);
+	memcpy(q->bundle_hdr + 2, &net_type, 2);
+	q->bundle_hdr_left = 4;
+	q->bundle_left = body;
+	metric_inc(MC_PKT_OUT + PKT_BUNDLE);
+}
+#endif
+
+/*
+* 큐 앞쪽 프레임들로 iovec을 구성하는 함수
+* 여러 chunk에 걸쳐 최대 max개 프레임을 담고, 맨 앞 프레임은 부분 전송된 만큼 건너뜀
+* 묶음(SEND_BUNDLE)을 시작했으면 아직 보내지 못한 묶음 머리를 맨 앞에 둠
+* 담은 iovec 수를 반환하고 전체 길이는 want에 기록
+*/
+int send_queue_fill_iov(send_queue_t* q, struct iovec* iov, int max, size_t* want) {
+	int iovcnt = 0;
+	*want = 0;
+
+#if SEND_BUNDLE
+	if (q->bundle_hdr_left == 0 && q->bundle_left == 0)
+		bundle_begin(q, max - 1);
+	if (q->bundle_hdr_left > 0) {
+		iov[0].iov_base = q->bundle_hdr + (4 - q->bundle_hdr_left);
+		iov[0].iov_len = q->bundle_hdr_left;
+		*want = q->bundle_hdr_left;
+		iovcnt = 1;
+	}
+#endif
+
+	bool first = true;
+	for (send_chunk_t* c = q->head; c && iovcnt < max; c = c->next) {
+		for (int i = c->head; i < c->tail && iovcnt < max; ++i) {
+			int skip = first ? q->offset : 0;
+			first = false;
+			iov[iovcnt].iov_base = c->bufs[i]->data + skip;
+			iov[iovcnt].iov_len = c->bufs[i]->len - skip;
+			*want += iov[iovcnt].iov_len;
+			iovcnt++;
+		}
+	}
+
+	return iovcnt;
+}
+
+/* 전송된 n바이트만큼 앞쪽 프레임부터 참조 반납, 남은 프레임은 offset으로 기록 (묶음 머리가 있으면 머리부터 뺌) */
+void send_queue_consume(send_queue_t* q, size_t n) {
+	metric_add(MC_BYTES_OUT, n);
+
+#if SEND_BUNDLE
+	size_t hdr = (n < q->bundle_hdr_left) ? n : q->bundle_hdr_left;
+	q->bundle_hdr_left -= (uint8_t)hdr;
+	n -= hdr;
+	q->bundle_left -= (n < q->bundle_left) ? (uint32_t)n : q->bundle_left;
+#endif
+
+	q->bytes -= n;
+	while (n > 0) {
+		send_chunk_t* c = q->head;
+		struct sbuf* b = c->bufs[c->head];
+		size_t remain = b->len - q->offset;
+
+		if (n < remain) {
+			q->offset += (int)n;
+			break;
+		}
+
+		n -= remain;
+		sbuf_release(b);
+		q->offset = 0;
+		q->count--;
+
+		/* chunk를 다 비웠으면 다음 chunk로 넘어감 */
+		if (++c->head == c->tail) {
+			q->head = c->next;
+			if (!q->head)
+				q->tail = NULL;
+			io_buf_put(IO_BUF_SEND, c);
+		}
+	}
+}
+
+/*
+* 큐의 프레임들을 sendmsg로 전송하는 함수
+* 여러 chunk에 걸쳐 최대 SEND_IOV_MAX개 프레임을 한 번의 시스템 콜로 보냄
+* 커널이 공유 버퍼에서 직접 읽어가므로 연결별 복사가 발생하지 않음
+* 모두 보냈거나 EAGAIN이면 0, 소켓 에러면 -1 반환
+*/
+int send_queue_flush(send_queue_t* q, int fd) {
+	while (q->count > 0) {
+		struct iovec iov[SEND_IOV_MAX];
+		size_t want;
+		int iovcnt = send_queue_fill_iov(q, iov, SEND_IOV_MAX, &want);
+
+		struct msghdr msg = { .msg_iov = iov, .msg_iovlen = (size_t)iovcnt };
+		metric_inc(MC_SEND_CALLS);
+		ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL | (send_queue_more(q, want) ? MSG_MORE : 0));
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return 0;
+			return -1;
+		}
+
+		send_queue_consume(q, (size_t)n);
+
+		/* 요청보다 적게 나갔다면 소켓 버퍼가 가득 찬 것이므로 다음 쓰기 가능 이벤트를 기다림 */
+		if ((size_t)n < want)
+			return 0;
+	}
+
+	return 0;
+}
+
+/*
+* 송신 큐 한도 검사 함수
+* hard 한도를 넘었거나, soft 한도를 넘은 상태가 SEND_SOFT_LIMIT_MS 이상 지속되면 -1 반환
+*/
+int send_queue_check_limit(send_queue_t* q, uint64_t now_ms) {
+	if (q->bytes > SEND_HARD_LIMIT) {
+		metric_inc(MC_SEND_OVERFLOWS);
+		return -1;
+	}
+
+	if (q->bytes <= SEND_SOFT_LIMIT) {
+		q->soft_since = 0;
+		return 0;
+	}
+
+	if (q->soft_since == 0) {
+		q->soft_since = now_ms;
+		return 0;
+	}
+
+	if (now_ms - q->soft_since >= SEND_SOFT_LIMIT_MS) {
+		metric_inc(MC_SEND_OVERFLOWS);
+		return -1;
+	}
+	return 0;
+}
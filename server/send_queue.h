@@ -0,0 +1,23 @@
+#ifndef SEND_QUEUE_H
+#define SEND_QUEUE_H
+
+#include "common.h"
+
+void send_queue_init(send_queue_t* q);
+void send_queue_clear(send_queue_t* q);
+
+int send_queue_push(send_queue_t* q, struct sbuf* buf);
+int send_queue_fill_iov(send_queue_t* q, struct iovec* iov, int max, size_t* want);
+void send_queue_consume(send_queue_t* q, size_t n);
+int send_queue_flush(send_queue_t* q, int fd);
+int send_queue_check_limit(send_queue_t* q, uint64_t now_ms);
+
+/*
+* want 바이트를 보낸 뒤에도 큐에 남는 것이 있어 MSG_MORE를 붙일지 (SEND_COALESCE 전용)
+* 남은 프레임을 바로 이어 보내므로 커널이 덜 찬 segment를 먼저 내보내지 않게 함
+*/
+static inline bool send_queue_more(const send_queue_t* q, size_t want) {
+	return SEND_COALESCE && want < q->bytes + q->bundle_hdr_left;
+}
+
+#endif
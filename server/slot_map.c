@@ -0,0 +1,34 @@
+#include "slot_map.h"
+
+int slot_map_init(slot_map_t* m, size_t elem_size, int limit) {
+	m->elem_size = elem_size;
+	m->limit = limit;
+	m->nchunks = (limit + SLOT_MAP_CHUNK - 1) >> SLOT_MAP_CHUNK_BITS;
+	atomic_init(&m->allocated, 0);
+	pthread_mutex_init(&m->lock, NULL);
+
+	m->chunks = calloc((size_t)m->nchunks, sizeof(char*));
+	return m->chunks ? 0 : -1;
+}
+
+void* slot_map_ensure(slot_map_t* m, int id) {
+	void* elem = slot_map_get(m, id);
+	if (elem || id < 0 || id >= m->limit)
+		return elem;
+
+	int c = id >> SLOT_MAP_CHUNK_BITS;
+
+	/* 같은 chunk를 두 스레드가 동시에 만들지 않도록 할당만 락으로 묶고, 다 채운 뒤 release로 올림 */
+	pthread_mutex_lock(&m->lock);
+	char* chunk = m->chunks[c];
+	if (!chunk) {
+		chunk = calloc(SLOT_MAP_CHUNK, m->elem_size);
+		if (chunk) {
+			__atomic_store_n(&m->chunks[c], chunk, __ATOMIC_RELEASE);
+			atomic_fetch_add_explicit(&m->allocated, 1, memory_order_relaxed);
+		}
+	}
+	pthread_mutex_unlock(&m->lock);
+
+	return chunk ? chunk + (size_t)(id & (SLOT_MAP_CHUNK - 1)) * m->elem_size : NULL;
+}
@@ -0,0 +1,43 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include "common.h"
+
+/*
+* id -> 고정 크기 원소 배열 (chunk 단위로 늘어남)
+* chunk 디렉터리는 시작 시 id 한도에 맞춰 한 번만 할당하고, chunk는 그 범위의 id가 처음 쓰일 때 할당함
+* 한 번 올린 chunk는 옮기거나 해제하지 않으므로 원소 주소가 바뀌지 않고, 읽는 쪽은 락 없이 접근할 수 있음
+* 즉 연결 수가 늘어도 기존 원소를 복사하는 realloc이 없고, 쓰지 않은 범위는 메모리를 차지하지 않음
+*/
+#define SLOT_MAP_CHUNK_BITS 12
+#define SLOT_MAP_CHUNK (1 << SLOT_MAP_CHUNK_BITS)
+
+typedef struct slot_map {
+	size_t elem_size;
+	int limit;							// id 상한 (이 값 미만만 사용)
+	int nchunks;						// 디렉터리 칸 수
+	char** chunks;						// chunk 디렉터리, 칸은 한 번 채워지면 바뀌지 않음 (__atomic으로 읽고 씀)
+	atomic_int allocated;				// 할당된 chunk 수 (지표용)
+	pthread_mutex_t lock;				// chunk 할당 직렬화
+} slot_map_t;
+
+int slot_map_init(slot_map_t* m, size_t elem_size, int limit);
+
+/* id의 원소를 반환하며, chunk가 없으면 0으로 채운 chunk를 할당함 (한도 밖이거나 할당 실패면 NULL) */
+void* slot_map_ensure(slot_map_t* m, int id);
+
+/* id의 원소 조회 (아직 chunk가 없거나 한도 밖이면 NULL) */
+static inline void* slot_map_get(slot_map_t* m, int id) {
+	if (id < 0 || id >= m->limit)
+		return NULL;
+
+	char* chunk = __atomic_load_n(&m->chunks[id >> SLOT_MAP_CHUNK_BITS], __ATOMIC_ACQUIRE);
+	return chunk ? chunk + (size_t)(id & (SLOT_MAP_CHUNK - 1)) * m->elem_size : NULL;
+}
+
+/* 지금까지 chunk가 할당된 id 수 */
+static inline int slot_map_capacity(slot_map_t* m) {
+	return atomic_load_explicit(&m->allocated, memory_order_relaxed) * SLOT_MAP_CHUNK;
+}
+
+#endif
@@ -1,329 +1,636 @@
-﻿#include "state.h"
-#include "job_queue.h"
-
-#include <stdlib.h>
-#include <string.h>
-#include <stdio.h>
-
-/* 세션 관련 데이터 */
-static session_t* sessions[MAX_CLIENTS];
-static int next_session_id = 1;
-
-/* 방 관련 데이터 */
-static room_t rooms[MAX_ROOMS];
-static int room_count = 0;
-
-/* 세션, 방 정보에 대한 mutex */
-static pthread_mutex_t g_sessions_lock = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t g_rooms_lock = PTHREAD_MUTEX_INITIALIZER;
-
-extern job_queue_t g_io_q;
-extern void net_wakeup(void);
-
-/* 세션을 생성하는 함수 */
-session_t* session_create(int fd)
-{
-    /* fd가 범위를 벗어나는 경우 NULL 반환 */
-    if (fd < 0 || fd >= MAX_CLIENTS)
-        return NULL;
-
-    /* 세션 테이블은 공유 자원이므로 접근이 mutex로 보호되어 동기화됨 */
-    pthread_mutex_lock(&g_sessions_lock);
-
-    /*
-    * 해당 fd에 대해 이미 세션이 존재하는지 확인(중복 세션 생성 방지)
-    * 만약 존재한다면 그대로 반환
-    */
-    session_t* s = sessions[fd];
-    if (s) {
-        pthread_mutex_unlock(&g_sessions_lock);
-        return s;
-    }
-
-    /*
-    * 아직 세션이 없으므로 새 세션 메모리 할당(락을 잡은 상태에서 수행하여 경쟁 생성 방지)
-    * 메모리 할당 실패 시 락 해제 후 실패 반환
-    */
-    s = malloc(sizeof(session_t));
-    if (!s) {
-        pthread_mutex_unlock(&g_sessions_lock);
-        return NULL;
-    }
-
-    /*
-    * 세션 정보 할당
-    * 메모리 초기화 후 session id, fd, room id, 유효성 할당
-    * 이후 세션 테이블에 생성된 세션 정보 저장
-    */
-    memset(s, 0, sizeof(*s));
-    s->session_id = next_session_id++;
-    s->fd = fd;
-    s->room_id = -1;
-    s->alive = true;
-    sessions[fd] = s;
-
-    pthread_mutex_unlock(&g_sessions_lock);
-
-    printf("[SESSION] created session id=%d fd=%d\n", s->session_id, fd);
-    return s;
-}
-
-/* 세션 정보를 가져오는 함수 */
-session_t* session_get(int fd)
-{
-    /* fd가 범위를 벗어나는 경우 NULL 반환 */
-    if (fd < 0 || fd >= MAX_CLIENTS)
-        return NULL;
-
-    /*
-    * 세션 테이블 접근은 mutex로 보호되어 동기화됨
-    * 세션 포인터의 일관성을 보장하기 위함
-    */
-    pthread_mutex_lock(&g_sessions_lock);
-    session_t* s = sessions[fd];
-    pthread_mutex_unlock(&g_sessions_lock);
-
-    return s;
-}
-
-/* 세션을 제거하는 함수 */
-void session_remove(int fd)
-{
-    /* fd가 범위를 벗어나는 경우 NULL 반환 */
-    if (fd < 0 || fd >= MAX_CLIENTS)
-        return;
-
-    /* 
-    * 세션 테이블은 공유 자원이므로 접근이 mutex로 보호되어 동기화됨
-    * 세션 획득에 실패하면 그대로 return
-    */
-    pthread_mutex_lock(&g_sessions_lock);
-    session_t* s = sessions[fd];
-    if (!s) {
-        pthread_mutex_unlock(&g_sessions_lock);
-        return;
-    }
-
-    /* 
-    * 테이블에서 먼저 제거 후 유효 플래그를 false로 설정
-    * 세션의 발견 가능성을 먼저 끊어야 하기 때문
-    * 즉, 먼저 더 이상 찾을 수 없게 만든 뒤 그 다음 내부 상태를 정리함
-    */
-    sessions[fd] = NULL;   
-    s->alive = false;
-    pthread_mutex_unlock(&g_sessions_lock);
-
-    printf("[SESSION] removed sid=%d fd=%d\n", s->session_id, fd);
-    free(s);
-}
-
-/* ============================ Room ============================ */
-
-/* 방을 생성하는 함수 */
-room_t* room_create(void)
-{
-    /* room 테이블은 공유 자원이므로 접근이 mutex로 보호되어 동기화됨 */
-    pthread_mutex_lock(&g_rooms_lock);
-
-    /* 최대 방 수보다 많은 방이 생성될 경우 방 생성 불가 */
-    if (room_count >= MAX_ROOMS) {
-        pthread_mutex_unlock(&g_rooms_lock);
-        return NULL;
-    }
-
-    /* 
-    * 새로운 방은 rooms 배열의 다음 인덱스에 생성
-    * 이후 방 구조체 정보 초기화
-    */
-    room_t* r = &rooms[room_count];
-    memset(r, 0, sizeof(*r));
-    r->room_id = room_count;
-    r->user_count = 0;
-    pthread_mutex_init(&r->lock, NULL);
-
-    /* 방 생성이 완료되었으므로 전역 방 갯수 증가 */
-    room_count++;
-
-    pthread_mutex_unlock(&g_rooms_lock);
-
-    printf("[ROOM] created room_id=%d\n", r->room_id);
-    return r;
-}
-
-/* 방 정보를 가져오는 함수 */
-room_t* room_get(int room_id)
-{
-    /* room_count는 여러 스레드에서 동시에 변경될 수 있으므로 mutex로 보호 */
-    pthread_mutex_lock(&g_rooms_lock);
-    int max = room_count;
-    pthread_mutex_unlock(&g_rooms_lock);
-
-    /* 유효하지 않은 room_id의 경우 NULL 반환 */
-    if (room_id < 0 || room_id >= max)
-        return NULL;
-
-    return &rooms[room_id];
-}
-
-/* 방을 조회하는 함수 */
-room_t* room_find(void)
-{
-    /* 
-    * 최대 방 수만큼 반복을 진행
-    * 반복문 내에서 존재하는 방을 찾으면 해당 방의 정보를 반환
-    */
-    pthread_mutex_lock(&g_rooms_lock);
-    for (int i = 0; i < room_count; i++) {
-        if (rooms[i].user_count < MAX_ROOM_USER) {
-            room_t* r = &rooms[i];
-            pthread_mutex_unlock(&g_rooms_lock);
-            return r;
-        }
-    }
-    pthread_mutex_unlock(&g_rooms_lock);
-    return NULL;
-}
-
-/* 방에 입장하는 함수 */
-void room_join(room_t* room, session_t* s)
-{
-    if (!room || !s) return;
-
-    pthread_mutex_lock(&room->lock);
-
-    /* 이미 세션에 방에 존재하면 무시(중복 추가 방지) */ 
-    for (int i = 0; i < room->user_count; i++) {
-        if (room->users[i] == s) {
-            pthread_mutex_unlock(&room->lock);
-            return;
-        }
-    }
-
-    /* 방의 유저 수가 방의 최대 인원보다 많은 경우에도 무시 */
-    if (room->user_count >= MAX_ROOM_USER) {
-        pthread_mutex_unlock(&room->lock);
-        return;
-    }
-
-    /* 
-    * 현재 방에 현재 세션(인원)을 추가 후 인원 수 증가
-    * 현재 세션의 room_id를 현재 방의 room_id로 저장
-    */
-    room->users[room->user_count++] = s;
-    s->room_id = room->room_id;
-
-    printf("[ROOM] sid=%d joined room=%d\n", s->session_id, room->room_id);
-
-    pthread_mutex_unlock(&room->lock);
-}
-
-/* 방에서 떠나는 함수 */
-void room_leave(session_t* s)
-{
-    if (!s) return;
-    if (s->room_id < 0) return;
-
-    /* 세션이 속한 방 조회 */ 
-    room_t* room = room_get(s->room_id);
-    if (!room) {
-
-        /* 방이 존재하지 않더라도 세션의 방 소속 정보는 초기화 */
-        s->room_id = -1;
-        return;
-    }
-
-    pthread_mutex_lock(&room->lock);
-
-    /* 반복문을 돌며 현재 세션이 존재하는 방을 탐색
-    * 제거할 자리를 마지막 사용자로 덮어써 배열 유지
-    * 마지막 칸은 더 이상 사용하지 않으므로 NULL로 변경
-    * 이후 방의 인원수 감소
-    */
-    for (int i = 0; i < room->user_count; i++) {
-        if (room->users[i] == s) {
-            room->users[i] = room->users[room->user_count - 1];
-            room->users[room->user_count - 1] = NULL;
-            room->user_count--;
-            break;
-        }
-    }
-
-    /* 현재 세션의 방 소속 정보 초기화 */
-    printf("[ROOM] sid=%d left room=%d\n", s->session_id, s->room_id);
-    s->room_id = -1;
-
-    pthread_mutex_unlock(&room->lock);
-}
-
-/* 방에 채팅을 전파하는 함수 */
-void room_broadcast(room_t* room, session_t* sender, packet_t* pkt)
-{
-    if (!room || !pkt) return;
-
-    /*
-    * 전송 대상 fd 목록을 임시로 저장
-    * room->lock을 잡은 상태에서 직접 send하지 않기 위해 사용
-    * count 변수에 브로드캐스팅으로 전송할 세션 수 저장
-    */
-    int fds[MAX_ROOM_USER];
-    int count = 0;
-
-    /* 송신자를 제외하기 위한 fd (없으면 -1) */
-    int except_fd = sender ? sender->fd : -1;
-
-    /* 방 내부 사용자 목록 접근은 다른 스레드와의 경쟁을 막기 위해 방 단위 mutex로 보호
-    * 세션이 없거나, 종료된 세션이거나, 송신자인 경우에는 무시
-    * 전송 대상 fd만 별도 배열에 수집 
-    */
-    pthread_mutex_lock(&room->lock);
-    for (int i = 0; i < room->user_count; ++i) {
-        session_t* s = room->users[i];
-        if (!s) continue;
-        if (!s->alive) continue;
-        if (s->fd == except_fd) continue;
-        fds[count++] = s->fd;
-    }
-    pthread_mutex_unlock(&room->lock);
-
-    /* 
-    * pkt->length는 (type + payload)의 길이
-    * payload의 길이가 최대 패킷길이보다 긴 경우 최대 패킷길이로 고정
-    */
-    int payload_len = (int)pkt->length - 2;
-    if (payload_len <= 0) return;
-    if (payload_len > MAX_PACKET_SIZE) payload_len = MAX_PACKET_SIZE;
-
-    /* 브로드캐스트용 출력 패킷 생성 */
-    packet_t out;
-    memset(&out, 0, sizeof(out));
-
-    /*
-    * payload를 안전하게 복사하며 개행 추가
-    * snprintf를 사용해 버퍼 오버플로 방지
-    */
-    int n = snprintf(out.payload, MAX_PACKET_SIZE, "%.*s\n", payload_len, pkt->payload);
-    if (n <= 0 || n >= MAX_PACKET_SIZE)
-        return;
-
-    /*
-    * 채팅 패킷 타입 설정
-    * 전체 패킷 길이 = type(2바이트) + payload 길이 
-    */
-    out.type = PKT_CHAT;
-    out.length = 2 + (uint16_t)n;
-
-    /*
-    * 수집된 fd 목록을 기반으로 각 대상에게 SEND 작업을 IO 큐에 등록
-    * 이후 전송 작업을 IO 큐에 추가
-    */
-    for (int i = 0; i < count; ++i) {
-        job_t job = { 0 };
-        job.type = JOB_SEND;
-        job.fd = fds[i];
-        job.packet = out;
-        job_queue_push(&g_io_q, &job);
-    }
-
-    /* IO 스레드를 깨워 큐에 쌓인 작업 처리 유도 */
-    net_wakeup();
+#include "state.h"
+#include "job_queue.h"
+#include "net.h"
+#include "sbuf.h"
+#include "log.h"
+#include "metrics.h"
+#include "member_set.h"
+#include "ebr.h"
+#include "slot_map.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/*
+* 세션 관련 데이터
+* 연결 id -> 세션 포인터 테이블이며, 연결 테이블과 같은 한도로 필요한 범위만 chunk 단위로 늘어남
+* 연결 id의 칸을 바꾸는 것은 그 id의 home worker(id % WORKER_THREAD_NUM)뿐이므로 쓰기 쪽에 락이 필요 없음
+* 다른 worker는 handle로 락 없이 조회하며, 제거된 세션은 EBR로 읽기 구간이 모두 끝난 뒤 해제되므로 조회 중에 사라지지 않음
+* session id만 여러 worker가 동시에 발급하므로 atomic으로 증가시킴
+*/
+static slot_map_t sessions;
+static atomic_int next_session_id = 1;
+
+/* home worker별 살아 있는 세션 목록 (종료 시 테이블 전체 대신 이 목록만 순회, 해당 worker만 접근) */
+static session_t* live_head[WORKER_THREAD_NUM];
+
+/* 멤버 배열을 처음 만들 때의 크기, 이후 정원까지 두 배씩 늘림 */
+#define ROOM_MEMBERS_INIT 8
+
+/*
+* 방 관련 데이터
+* 방 내부 멤버 목록은 방 소유 worker(slot % WORKER_THREAD_NUM)만 접근하므로 락이 필요 없음
+* 방 생성과 좌석 예약(reserved)만 여러 worker가 경쟁하므로 g_rooms_lock으로 보호
+*/
+static room_t rooms[MAX_ROOMS];
+static atomic_int room_high = 0;		// 한 번이라도 사용된 슬롯 수
+static pthread_mutex_t g_rooms_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+* 빈 좌석 수별 방 목록의 맨 앞 슬롯 (-1이면 비어 있음, g_rooms_lock으로 보호)
+* open_head[k]는 빈 좌석이 k개 남은 열린 방들이고, open_head[MAX_ROOM_USER]는 닫힌 방들의 free list
+*/
+static int open_head[MAX_ROOM_USER + 1] = { [0 ... MAX_ROOM_USER] = -1 };
+
+/* 채널 번호 -> 열린 채널 방 슬롯 (-1이면 닫혀 있음, g_rooms_lock으로 보호) */
+static int channel_slot[MAX_CHANNELS] = { [0 ... MAX_CHANNELS - 1] = -1 };
+
+/* 세션 테이블 초기화 함수 (worker 시작 전에 연결 테이블 한도로 한 번 호출) */
+int session_table_init(int limit)
+{
+    return slot_map_init(&sessions, sizeof(session_t*), limit);
+}
+
+/* 세션을 생성하는 함수 */
+session_t* session_create(conn_handle_t handle)
+{
+    int id = HANDLE_ID(handle);
+
+    /* id가 범위를 벗어나는 경우 NULL 반환 */
+    session_t** slot = (handle == HANDLE_NONE) ? NULL : slot_map_ensure(&sessions, id);
+    if (!slot)
+        return NULL;
+
+    /*
+    * 해당 연결에 대해 이미 세션이 존재하는지 확인(중복 세션 생성 방지)
+    * 만약 존재한다면 그대로 반환하고, 이전 연결의 세션이 남아 있으면 생성하지 않음 (호출자가 먼저 정리해야 함)
+    */
+    session_t* s = *slot;
+    if (s)
+        return (s->handle == handle) ? s : NULL;
+
+    /* 아직 세션이 없으므로 새 세션 메모리 할당, 실패 시 NULL 반환 */
+    s = malloc(sizeof(session_t));
+    if (!s)
+        return NULL;
+
+    /*
+    * 세션 정보 할당
+    * 메모리 초기화 후 session id, handle, room id, 유효성 할당
+    * 모든 필드를 채운 뒤 release로 테이블에 올려야 다른 worker가 채워지지 않은 세션을 보지 않음
+    */
+    memset(s, 0, sizeof(*s));
+    s->session_id = atomic_fetch_add(&next_session_id, 1);
+    s->handle = handle;
+    s->room_id = -1;
+    s->alive = true;
+
+    session_t** head = &live_head[id % WORKER_THREAD_NUM];
+    s->live_next = *head;
+    if (*head)
+        (*head)->live_prev = s;
+    *head = s;
+
+    __atomic_store_n(slot, s, __ATOMIC_RELEASE);
+
+    metric_inc(MC_SESSIONS_CREATED);
+    LOG_INFO("[SESSION] created session id=%d conn=%d", s->session_id, id);
+    return s;
+}
+
+/*
+* 세션 정보를 가져오는 함수
+* handle의 세대가 현재 세션과 다르면(끊긴 뒤 연결 id가 재사용된 경우) NULL을 반환하므로 다른 연결의 세션을 잘못 집지 않음
+* home worker가 아닌 스레드는 ebr_enter() ~ ebr_exit() 안에서만 호출하고 반환값을 사용해야 함
+*/
+session_t* session_get(conn_handle_t handle)
+{
+    /* id가 범위를 벗어나거나 아직 chunk가 없는 경우 NULL 반환 */
+    session_t** slot = slot_map_get(&sessions, HANDLE_ID(handle));
+    if (!slot)
+        return NULL;
+
+    session_t* s = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    return (s && s->handle == handle) ? s : NULL;
+}
+
+/* 연결 id 자리에 남아 있는 세션을 세대와 관계없이 가져오는 함수 (home worker 전용) */
+session_t* session_at(int id)
+{
+    session_t** slot = slot_map_get(&sessions, id);
+    return slot ? *slot : NULL;
+}
+
+/* 읽기 구간이 모두 끝난 세션을 해제하는 함수 */
+static void session_free(ebr_node_t* node)
+{
+    free((session_t*)((char*)node - offsetof(session_t, ebr)));
+}
+
+/* 세션을 제거하는 함수 */
+void session_remove(conn_handle_t handle)
+{
+    session_t* s = session_get(handle);
+    if (!s)
+        return;
+
+    /* 
+    * 테이블에서 먼저 제거 후 유효 플래그를 false로 설정
+    * 세션의 발견 가능성을 먼저 끊어야 하기 때문
+    * 즉, 먼저 더 이상 찾을 수 없게 만든 뒤 그 다음 내부 상태를 정리함
+    * 이미 세션을 집어 간 다른 worker가 있을 수 있으므로 메모리는 EBR로 넘겨 나중에 해제함
+    */
+    int id = HANDLE_ID(handle);
+    __atomic_store_n((session_t**)slot_map_get(&sessions, id), NULL, __ATOMIC_RELEASE);
+    s->alive = false;
+
+    if (s->live_prev)
+        s->live_prev->live_next = s->live_next;
+    else
+        live_head[id % WORKER_THREAD_NUM] = s->live_next;
+    if (s->live_next)
+        s->live_next->live_prev = s->live_prev;
+
+    metric_inc(MC_SESSIONS_REMOVED);
+    LOG_INFO("[SESSION] removed sid=%d conn=%d", s->session_id, id);
+    ebr_retire(&s->ebr, session_free);
+}
+
+/* worker가 home worker인 세션을 모두 제거하는 함수 (종료 시 정리용) */
+void session_remove_all(int worker)
+{
+    while (live_head[worker])
+        session_remove(live_head[worker]->handle);
+}
+
+/* ============================ Room ============================ */
+
+/* 세션이 잡고 있는 room_id가 슬롯 번호 범위를 넘지 않아야 함 */
+_Static_assert(MAX_ROOMS <= (1 << ROOM_SLOT_BITS), "MAX_ROOMS exceeds room slot bits");
+
+/*
+* 방을 빈 좌석 수 목록에서 빼는 함수, g_rooms_lock을 잡은 상태에서 호출해야 함
+*/
+static void room_unlink_locked(room_t* r)
+{
+    if (r->open_seats < 0)
+        return;
+
+    if (r->open_prev >= 0)
+        rooms[r->open_prev].open_next = r->open_next;
+    else
+        open_head[r->open_seats] = r->open_next;
+
+    if (r->open_next >= 0)
+        rooms[r->open_next].open_prev = r->open_prev;
+
+    r->open_seats = -1;
+}
+
+/* 방을 빈 좌석 수 seats인 목록 맨 앞에 넣는 함수, g_rooms_lock을 잡은 상태에서 호출해야 함 */
+static void room_link_locked(room_t* r, int seats)
+{
+    r->open_seats = seats;
+    r->open_prev = -1;
+    r->open_next = open_head[seats];
+    if (r->open_next >= 0)
+        rooms[r->open_next].open_prev = r->slot;
+    open_head[seats] = r->slot;
+}
+
+/*
+* 예약 좌석 수가 바뀐 방을 알맞은 목록으로 옮기는 함수, g_rooms_lock을 잡은 상태에서 호출해야 함
+* 빈 좌석 수별 목록에는 자동 배정 방만 두며, 꽉 찬 방은 어느 목록에도 두지 않음
+* 예약이 모두 반환된 방은 닫아서 free list로 돌려보냄 (채널 방은 채널 번호 연결도 끊음)
+* 닫힌 방의 room_id는 -1이 되므로 이전 room_id로 들어온 작업은 room_get에서 걸러짐
+*/
+static void room_update_locked(room_t* r)
+{
+    room_unlink_locked(r);
+
+    if (r->reserved == 0) {
+        LOG_INFO("[ROOM] closed room_id=%d", ROOM_MAKE_ID(r->gen, r->slot));
+        __atomic_store_n(&r->room_id, -1, __ATOMIC_RELEASE);
+        if (r->kind != ROOM_KIND_MATCH)
+            channel_slot[r->channel] = -1;
+        room_link_locked(r, MAX_ROOM_USER);
+        metric_inc(MC_ROOMS_CLOSED);
+        return;
+    }
+
+    int seats = r->capacity - r->reserved;
+    if (r->kind == ROOM_KIND_MATCH && seats > 0)
+        room_link_locked(r, seats);
+}
+
+/*
+* 방을 여는 함수, g_rooms_lock을 잡은 상태에서 호출해야 함
+* free list에 닫힌 방이 있으면 그 슬롯을 재사용하고, 없으면 아직 쓰지 않은 슬롯을 하나 꺼냄
+* 슬롯을 재사용할 때마다 세대를 올려 새 room_id를 발급함
+*/
+static room_t* room_open_locked(room_kind_t kind, int capacity, int channel)
+{
+    room_t* r;
+    int slot = open_head[MAX_ROOM_USER];
+
+    if (slot >= 0) {
+        r = &rooms[slot];
+        room_unlink_locked(r);
+    }
+    else {
+        /* 최대 방 수만큼 모두 열려 있는 경우 방 생성 불가 */
+        slot = atomic_load(&room_high);
+        if (slot >= MAX_ROOMS)
+            return NULL;
+
+        r = &rooms[slot];
+        memset(r, 0, sizeof(*r));
+        r->open_seats = -1;
+        r->slot = slot;
+        r->room_id = -1;
+
+        /* 슬롯 초기화가 끝난 뒤 늘려야 room_get에서 반쯤 만들어진 방이 보이지 않음 */
+        atomic_store(&room_high, slot + 1);
+    }
+
+    /*
+    * 닫힌 방은 멤버가 없으므로 멤버 배열은 그대로 두고 세대만 올림
+    * 멤버 배열은 방 소유 worker가 첫 입장 때 정원에 맞게 늘림
+    */
+    r->gen = (r->gen + 1) & ROOM_GEN_MASK;
+    r->kind = kind;
+    r->capacity = capacity;
+    r->channel = channel;
+    r->reserved = 0;
+    __atomic_store_n(&r->room_id, ROOM_MAKE_ID(r->gen, slot), __ATOMIC_RELEASE);
+
+    metric_inc(MC_ROOMS_CREATED);
+    LOG_INFO("[ROOM] created room_id=%d", r->room_id);
+    return r;
+}
+
+/*
+* 방 정보를 가져오는 함수
+* 슬롯의 현재 room_id와 다르면(닫혔거나 다른 세대로 재사용됨) NULL 반환
+*/
+room_t* room_get(int room_id)
+{
+    if (room_id < 0)
+        return NULL;
+
+    int slot = ROOM_SLOT(room_id);
+    if (slot >= atomic_load(&room_high))
+        return NULL;
+
+    room_t* r = &rooms[slot];
+    if (__atomic_load_n(&r->room_id, __ATOMIC_ACQUIRE) != room_id)
+        return NULL;
+
+    return r;
+}
+
+/* 슬롯 번호로 열려 있는 방을 가져오는 함수 (닫혀 있거나 쓰지 않은 슬롯이면 NULL) */
+room_t* room_at(int slot)
+{
+    if (slot < 0 || slot >= atomic_load(&room_high))
+        return NULL;
+
+    room_t* r = &rooms[slot];
+    return (__atomic_load_n(&r->room_id, __ATOMIC_ACQUIRE) >= 0) ? r : NULL;
+}
+
+/*
+* 빈 좌석이 있는 방을 찾아 좌석 하나를 예약하는 함수
+* 실제 입장은 방 소유 worker에서 비동기로 처리되므로, 그 사이 다른 세션이 같은 좌석을 잡지 않도록
+* 예약 좌석 수(reserved)를 기준으로 방을 고름
+* 빈 좌석 수별 목록에서 빈 좌석이 가장 적은 방부터 채우므로 방 수와 관계없이 O(MAX_ROOM_USER)
+* 참가 가능한 방이 없으면 새 방을 엶
+*/
+room_t* room_reserve(void)
+{
+    pthread_mutex_lock(&g_rooms_lock);
+
+    room_t* r = NULL;
+    for (int seats = 1; seats < MAX_ROOM_USER; seats++) {
+        if (open_head[seats] >= 0) {
+            r = &rooms[open_head[seats]];
+            break;
+        }
+    }
+
+    if (!r)
+        r = room_open_locked(ROOM_KIND_MATCH, MAX_ROOM_USER, -1);
+    if (r) {
+        r->reserved++;
+        room_update_locked(r);
+    }
+
+    pthread_mutex_unlock(&g_rooms_lock);
+    return r;
+}
+
+/*
+* 채널 방의 좌석 하나를 예약하는 함수
+* 채널마다 열린 방은 하나뿐이며, 아직 열려 있지 않으면 새로 엶
+* 정원이 찼거나 채널 번호가 범위를 벗어나면 NULL 반환
+*/
+room_t* room_reserve_channel(int channel)
+{
+    if (channel < 0 || channel >= MAX_CHANNELS)
+        return NULL;
+
+    pthread_mutex_lock(&g_rooms_lock);
+
+    room_t* r = (channel_slot[channel] >= 0) ? &rooms[channel_slot[channel]] : NULL;
+    if (!r) {
+        r = (channel == 0) ? room_open_locked(ROOM_KIND_LOBBY, LOBBY_CAPACITY, 0)
+                           : room_open_locked(ROOM_KIND_CHANNEL, CHANNEL_CAPACITY, channel);
+        if (r)
+            channel_slot[channel] = r->slot;
+    }
+
+    if (r && r->reserved < r->capacity) {
+        r->reserved++;
+        room_update_locked(r);
+    }
+    else {
+        r = NULL;
+    }
+
+    pthread_mutex_unlock(&g_rooms_lock);
+    return r;
+}
+
+/* 예약했던 좌석을 반환하는 함수, 마지막 좌석이었다면 방을 닫음 */
+void room_release(room_t* room)
+{
+    if (!room) return;
+
+    pthread_mutex_lock(&g_rooms_lock);
+    if (room->reserved > 0) {
+        room->reserved--;
+        room_update_locked(room);
+    }
+    pthread_mutex_unlock(&g_rooms_lock);
+}
+
+/* ============================ Room members ============================ */
+
+/* handle이 들어갈 색인 칸의 시작 위치 (연결 id 부분에 곱셈 해시) */
+static int room_index_home(const room_t* room, conn_handle_t handle)
+{
+    return (int)(((uint32_t)HANDLE_ID(handle) * 2654435761u) & (uint32_t)(room->index_cap - 1));
+}
+
+/* handle의 members 배열 위치를 찾는 함수, 없으면 -1 */
+static int room_index_find(const room_t* room, conn_handle_t handle)
+{
+    if (!room->index)
+        return -1;
+
+    for (int i = room_index_home(room, handle); ; i = (i + 1) & (room->index_cap - 1)) {
+        if (room->index[i].handle == handle)
+            return room->index[i].pos;
+        if (room->index[i].handle == HANDLE_NONE)
+            return -1;
+    }
+}
+
+/* handle의 위치를 기록하는 함수 (이미 있으면 위치만 갱신) */
+static void room_index_put(room_t* room, conn_handle_t handle, int pos)
+{
+    int i = room_index_home(room, handle);
+    while (room->index[i].handle != HANDLE_NONE && room->index[i].handle != handle)
+        i = (i + 1) & (room->index_cap - 1);
+
+    room->index[i].handle = handle;
+    room->index[i].pos = pos;
+}
+
+/*
+* handle을 색인에서 지우는 함수
+* tombstone을 남기지 않도록 뒤따르는 칸들을 빈 자리로 당겨 탐색 경로를 유지함 (backward shift)
+*/
+static void room_index_erase(room_t* room, conn_handle_t handle)
+{
+    int mask = room->index_cap - 1;
+    int i = room_index_home(room, handle);
+    while (room->index[i].handle != handle) {
+        if (room->index[i].handle == HANDLE_NONE)
+            return;
+        i = (i + 1) & mask;
+    }
+
+    for (int j = (i + 1) & mask; room->index[j].handle != HANDLE_NONE; j = (j + 1) & mask) {
+        int home = room_index_home(room, room->index[j].handle);
+
+        /* j의 원래 자리가 (i, j] 구간 밖이면 i로 당겨도 탐색에서 찾을 수 있음 */
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            room->index[i] = room->index[j];
+            i = j;
+        }
+    }
+    room->index[i].handle = HANDLE_NONE;
+}
+
+/* 멤버 배열 크기에 맞춰 색인을 다시 만드는 함수 (색인 칸 수는 배열 크기의 두 배 이상) */
+static int room_index_rebuild(room_t* room, int member_cap)
+{
+    int cap = 16;
+    while (cap < member_cap * 2)
+        cap <<= 1;
+
+    if (cap != room->index_cap) {
+        room_index_entry_t* index = malloc(sizeof(room_index_entry_t) * (size_t)cap);
+        if (!index)
+            return -1;
+        free(room->index);
+        room->index = index;
+        room->index_cap = cap;
+    }
+
+    for (int i = 0; i < cap; i++)
+        room->index[i].handle = HANDLE_NONE;
+
+    member_set_t* set = room->members;
+    for (int i = 0; set && i < set->count; i++)
+        room_index_put(room, set->members[i].handle, i);
+    return 0;
+}
+
+/*
+* 멤버 배열을 수정할 수 있게 확보하는 함수
+* need명을 담을 공간이 없으면 정원까지 두 배씩 늘리고,
+* 브로드캐스트 중인 reactor가 아직 참조를 들고 있으면 새 배열로 복사해서 바꿈(copy-on-write)
+* 참조가 하나뿐이면(acquire로 확인) reactor들의 읽기가 모두 끝난 것이므로 그대로 수정함
+*/
+static member_set_t* room_members_writable(room_t* room, int need)
+{
+    member_set_t* set = room->members;
+    if (set && need <= set->cap && atomic_load_explicit(&set->refcnt, memory_order_acquire) == 1)
+        return set;
+
+    int cap = set ? set->cap : 0;
+    if (need > cap) {
+        cap = cap ? cap * 2 : ROOM_MEMBERS_INIT;
+        if (cap < need)
+            cap = need;
+        if (cap > room->capacity)
+            cap = room->capacity;
+    }
+
+    /* 색인은 위치만 담으므로 배열을 바꾸기 전에 지금 멤버로 미리 키워 둠 */
+    if (room->index_cap < cap * 2 && room_index_rebuild(room, cap) < 0)
+        return NULL;
+
+    member_set_t* next = set ? member_set_copy(set, cap) : member_set_alloc(cap);
+    if (!next)
+        return NULL;
+
+    room->members = next;
+    member_set_release(set);
+    return next;
+}
+
+/* 멤버 배열과 색인을 해제하는 함수 (방이 비었을 때 대형 방이 잡고 있던 메모리 반환) */
+static void room_members_free(room_t* room)
+{
+    member_set_release(room->members);
+    room->members = NULL;
+    free(room->index);
+    room->index = NULL;
+    room->index_cap = 0;
+}
+
+/* 방에 입장하는 함수 (색인으로 중복을 확인하므로 인원 수와 관계없이 O(1)) */
+void room_join(room_t* room, conn_handle_t handle, int session_id)
+{
+    if (!room) return;
+
+    /* 이미 방에 존재하면 무시(중복 추가 방지) */
+    if (room_index_find(room, handle) >= 0)
+        return;
+
+    /* 방의 유저 수가 방의 정원에 도달한 경우에도 무시 */
+    int count = room->members ? room->members->count : 0;
+    if (count >= room->capacity)
+        return;
+
+    member_set_t* set = room_members_writable(room, count + 1);
+    if (!set) {
+        LOG_ERROR("[ROOM] member array alloc failed room=%d", room->room_id);
+        return;
+    }
+
+    /* 배열 끝에 추가하고 색인에 위치 기록 */
+    set->members[count].handle = handle;
+    set->members[count].session_id = session_id;
+    set->count = count + 1;
+    room_index_put(room, handle, count);
+
+    metric_inc(MC_ROOM_JOINS);
+    LOG_INFO("[ROOM] sid=%d joined room=%d", session_id, room->room_id);
+}
+
+/* 방에서 떠나는 함수 (색인으로 위치를 찾고 마지막 멤버로 덮어쓰므로 O(1)) */
+void room_leave(room_t* room, conn_handle_t handle)
+{
+    if (!room) return;
+
+    int pos = room_index_find(room, handle);
+    member_set_t* set = (pos >= 0) ? room_members_writable(room, room->members->count) : NULL;
+
+    if (set) {
+        metric_inc(MC_ROOM_LEAVES);
+        LOG_INFO("[ROOM] sid=%d left room=%d", set->members[pos].session_id, room->room_id);
+
+        /* 제거할 자리를 마지막 멤버로 덮어써 배열을 빈틈없이 유지 */
+        int last = set->count - 1;
+        if (pos != last) {
+            set->members[pos] = set->members[last];
+            room_index_put(room, set->members[pos].handle, pos);
+        }
+        room_index_erase(room, handle);
+        set->count = last;
+
+        /* 대형 방이 비면 늘려 두었던 배열을 반환 */
+        if (set->count == 0 && set->cap > ROOM_MEMBERS_INIT)
+            room_members_free(room);
+    }
+
+    /* 입장 전에 예약했던 좌석 반환 */
+    room_release(room);
+}
+
+/* 방의 모든 멤버를 정리하고 방을 닫는 함수 (서버 종료 시 사용) */
+void room_clear(room_t* room)
+{
+    if (!room) return;
+
+    room_members_free(room);
+
+    pthread_mutex_lock(&g_rooms_lock);
+    room->reserved = 0;
+    room_update_locked(room);
+    pthread_mutex_unlock(&g_rooms_lock);
+}
+
+/* 방에 채팅을 전파하는 함수 */
+void room_broadcast(room_t* room, conn_handle_t sender, packet_t* pkt)
+{
+    if (!room || !pkt) return;
+
+    /* 
+    * pkt->length는 (type + payload)의 길이
+    * payload의 길이가 최대 패킷길이보다 긴 경우 최대 패킷길이로 고정
+    */
+    int payload_len = (int)pkt->length - 2;
+    if (payload_len <= 0) return;
+    if (payload_len > MAX_PACKET_SIZE) payload_len = MAX_PACKET_SIZE;
+
+    /*
+    * 브로드캐스트 프레임을 한 번만 직렬화
+    * length/type 헤더(4바이트)는 network order로 미리 기록하고, payload 영역에 바로 채팅 내용을 씀
+    * 각 수신자는 이 버퍼의 참조만 나눠 가지므로 수신자 수만큼의 패킷 복사가 발생하지 않음
+    */
+    sbuf_t* frame = sbuf_alloc(4 + MAX_PACKET_SIZE);
+    if (!frame)
+        return;
+
+    /*
+    * payload를 안전하게 복사하며 개행 추가
+    * snprintf를 사용해 버퍼 오버플로 방지
+    */
+    int n = snprintf(frame->data + 4, MAX_PACKET_SIZE, "%.*s\n", payload_len, pkt->payload);
+    if (n <= 0 || n >= MAX_PACKET_SIZE) {
+        sbuf_release(frame);
+        return;
+    }
+
+    /*
+    * 채팅 패킷 타입 설정
+    * 전체 패킷 길이 = type(2바이트) + payload 길이 
+    */
+    uint16_t net_len = htons((uint16_t)(2 + n));
+    uint16_t net_type = htons(PKT_CHAT);
+    memcpy(frame->data, &net_len, 2);
+    memcpy(frame->data + 2, &net_type, 2);
+    frame->len = 4 + (uint32_t)n;
+    frame->ts_ns = monotonic_ns();
+
+    /*
+    * 멤버 배열은 복사하지 않고 참조만 각 reactor에게 넘김
+    * reactor는 배열에서 자신이 담당한 연결에만 프레임 참조를 붙이므로, 대상 수와 관계없이 IO 큐 push는 reactor 수만큼만 발생함
+    * 이후 입장/퇴장은 참조가 남아 있으면 새 배열에 반영되므로(copy-on-write) 전달한 목록은 바뀌지 않음
+    */
+    if (room->members && room->members->count > 0)
+        net_push_multicast(frame, room->members, sender);
+
+    /* 생성 시 잡았던 참조 반납 (수신자가 없으면 여기서 해제됨) */
+    sbuf_release(frame);
+
+    /* IO 스레드를 깨워 큐에 쌓인 작업 처리 유도 (대상 수와 무관하게 한 번만 호출) */
+    net_wakeup();
 }
\ No newline at end of file
@@ -2,39 +2,99 @@
 #define STATE_H
 
 #include "common.h"
+#include "member_set.h"
+#include "ebr.h"
 
-//   ü
+/*
+* 세션 정보 구조체
+* 테이블에 올린 뒤에는 handle과 session_id가 바뀌지 않으므로 다른 worker도 EBR 읽기 구간 안에서 읽을 수 있음
+* 나머지 필드는 home worker만 읽고 씀
+*/
 typedef struct session {
 	int session_id;
-	int fd;
+	conn_handle_t handle;
 	int room_id;
 	bool alive;
-
-	char send_buf[SEND_BUF_SIZE];
-	size_t size_len;
-	size_t size_offset;
+	wheel_timer_t join_timer;			// 방 입장 기한 (home worker의 타이머 휠, JOIN_DEADLINE_MS)
+	ebr_node_t ebr;						// 제거 후 지연 해제용
+	struct session* live_prev;			// home worker의 살아 있는 세션 목록
+	struct session* live_next;
 } session_t;
 
-//   ü
+/*
+* room_id = (세대 << ROOM_SLOT_BITS) | 슬롯 번호
+* 닫힌 방의 슬롯은 재사용되며 그때마다 세대가 올라가므로, 세션이나 큐에 남아 있던 이전 room_id는 room_get에서 걸러짐
+* 세대는 ROOM_GEN_MASK 범위에서 순환하므로 같은 슬롯이 그만큼 재사용되기 전까지 남아 있는 room_id만 구분함
+*/
+#define ROOM_SLOT_BITS 16
+#define ROOM_GEN_MASK 0x7fff
+#define ROOM_SLOT(id) ((id) & ((1 << ROOM_SLOT_BITS) - 1))
+#define ROOM_MAKE_ID(gen, slot) (((gen) << ROOM_SLOT_BITS) | (slot))
+
+/*
+* 방 종류
+* MATCH   : 입장 요청 시 빈 좌석이 있는 방으로 자동 배정되는 소규모 방 (정원 MAX_ROOM_USER)
+* LOBBY   : 채널 0번, 모든 클라이언트가 함께 들어갈 수 있는 대형 방 (정원 LOBBY_CAPACITY)
+* CHANNEL : 채널 번호로 골라 들어가는 대형 방 (정원 CHANNEL_CAPACITY)
+* 대형 방은 채널 번호마다 하나씩 필요할 때 열리고, 모두 나가면 닫힘
+*/
+typedef enum {
+	ROOM_KIND_MATCH,
+	ROOM_KIND_LOBBY,
+	ROOM_KIND_CHANNEL,
+} room_kind_t;
+
+/* 멤버 handle -> members 배열 위치 색인 (open addressing, handle이 HANDLE_NONE이면 빈 칸) */
+typedef struct room_index_entry {
+	conn_handle_t handle;
+	int pos;
+} room_index_entry_t;
+
+// 방 정보 구조체
 typedef struct room {
-	int room_id;
-	session_t* users[MAX_ROOM_USER];
-	int user_count;
-	pthread_mutex_t lock;
+	int room_id;						// 열려 있으면 현재 room_id, 닫혀 있으면 -1 (atomic으로 읽고 씀)
+	int slot;							// rooms[] 안의 위치
+	int gen;							// 슬롯 재사용 세대
+	room_kind_t kind;
+	int capacity;						// 정원
+	int channel;						// LOBBY / CHANNEL 방의 채널 번호
+
+	/* 방 소유 worker만 접근 */
+	member_set_t* members;				// 멤버 dense 배열 (브로드캐스트 중인 reactor와 공유, copy-on-write)
+	room_index_entry_t* index;			// handle -> members 위치
+	int index_cap;						// index 칸 수 (2의 거듭제곱)
+	struct game_room* game;				// 게임 tick 상태 (game.c, 진행 중이 아니면 NULL)
+
+	int reserved;						// 예약된 좌석 수 (g_rooms_lock으로 보호)
+
+	/* 빈 좌석 수별 방 목록 연결 (g_rooms_lock으로 보호) */
+	int open_seats;						// 속한 목록의 빈 좌석 수, 어느 목록에도 없으면 -1
+	int open_prev;
+	int open_next;
 } room_t;
 
-/* session API */
-session_t* session_get(int fd);       // ȸ ( X)
-session_t* session_create(int fd);    //  (  )
-void session_remove(int fd);
+/*
+* session API
+* 생성/제거는 연결 id의 home worker만 호출하고, 조회는 어느 worker든 EBR 읽기 구간 안에서 호출할 수 있음
+*/
+int session_table_init(int limit);                  // 연결 id 한도로 세션 테이블 준비 (worker 시작 전)
+session_t* session_get(conn_handle_t handle);       // 조회만 (생성 X), handle의 세대가 다르면 NULL
+session_t* session_create(conn_handle_t handle);    // 생성만 (없을 때만 생성)
+session_t* session_at(int id);                      // 연결 id 자리의 현재 세션 (세대 무관, home worker 전용)
+void session_remove(conn_handle_t handle);
+void session_remove_all(int worker);                // worker가 home인 세션 전체 제거 (종료 시)
 
 /* room API */
-room_t* room_get(int room_id);  // 
-room_t* room_create(void);      //     
-room_t* room_find(void);
+room_t* room_get(int room_id);
+room_t* room_at(int slot);            // 슬롯 번호로 열린 방 조회 (종료 시 정리용)
+room_t* room_reserve(void);           // 빈 좌석 하나를 예약한 방 반환 (없으면 생성)
+room_t* room_reserve_channel(int channel);	// 채널 방(0 : 로비)의 좌석 하나를 예약 (없으면 생성, 정원이 차면 NULL)
+void room_release(room_t* room);      // 예약 좌석 반환
 
-void room_join(room_t* room, session_t* s);
-void room_leave(session_t* s);
-void room_broadcast(room_t* room, session_t* sender, packet_t* pkt);
+/* 방 소유 worker 전용 API */
+void room_join(room_t* room, conn_handle_t handle, int session_id);
+void room_leave(room_t* room, conn_handle_t handle);
+void room_clear(room_t* room);
+void room_broadcast(room_t* room, conn_handle_t sender, packet_t* pkt);
 
 #endif
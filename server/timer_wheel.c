@@ -0,0 +1,148 @@
+#include "timer_wheel.h"
+
+/* 최상위 단까지 담을 수 있는 최대 tick 수, 이보다 먼 타이머는 범위 끝 칸에 두었다가 내려올 때 다시 나눔 */
+#define TW_RANGE ((1ull << (TW_BITS * TW_LEVELS)) - 1)
+
+void timer_wheel_init(timer_wheel_t* w, uint64_t now_ms) {
+	memset(w, 0, sizeof(*w));
+	w->now = now_ms / TIMER_TICK_MS;
+}
+
+/* 남은 tick 수에 맞는 단과 칸에 넣는 함수 (expire >= now) */
+static void insert(timer_wheel_t* w, wheel_timer_t* t) {
+	uint64_t delta = t->expire - w->now;
+	uint64_t e = (delta > TW_RANGE) ? w->now + TW_RANGE : t->expire;
+
+	int level = 0;
+	while (level < TW_LEVELS - 1 && delta >= (1ull << (TW_BITS * (level + 1))))
+		level++;
+
+	int idx = (int)((e >> (TW_BITS * level)) & (TW_SLOTS - 1));
+	wheel_timer_t** head = &w->slots[level][idx];
+
+	t->next = *head;
+	if (t->next)
+		t->next->pprev = &t->next;
+	t->pprev = head;
+	*head = t;
+
+	t->slot = (uint16_t)(level * TW_SLOTS + idx);
+	w->occupied[level] |= 1ull << idx;
+	w->count++;
+}
+
+static void unlink_timer(timer_wheel_t* w, wheel_timer_t* t) {
+	*t->pprev = t->next;
+	if (t->next)
+		t->next->pprev = t->pprev;
+	t->next = NULL;
+	t->pprev = NULL;
+
+	int level = t->slot / TW_SLOTS;
+	int idx = t->slot % TW_SLOTS;
+	if (!w->slots[level][idx])
+		w->occupied[level] &= ~(1ull << idx);
+	w->count--;
+}
+
+void timer_arm(timer_wheel_t* w, wheel_timer_t* t, uint64_t expire_ms) {
+	if (timer_armed(t))
+		unlink_timer(w, t);
+
+	/* 올림으로 tick을 정해 예정보다 일찍 만료되지 않게 하고, 이미 지난 시각이면 다음 tick에 만료 */
+	uint64_t e = (expire_ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+	t->expire = (e > w->now) ? e : w->now + 1;
+	insert(w, t);
+}
+
+void timer_cancel(timer_wheel_t* w, wheel_timer_t* t) {
+	if (timer_armed(t))
+		unlink_timer(w, t);
+}
+
+/* bitmap에서 start번 칸부터 순환하며 첫 번째로 채워진 칸까지의 거리 (bitmap != 0) */
+static int first_from(uint64_t bitmap, int start) {
+	uint64_t rot = start ? (bitmap >> start) | (bitmap << (TW_SLOTS - start)) : bitmap;
+	return __builtin_ctzll(rot);
+}
+
+/*
+* 다음으로 처리할 일이 있는 tick
+* 0단은 채워진 다음 칸, 상위 단은 채워진 다음 칸이 풀리는 경계 중 가장 이른 값
+* 그 사이의 tick은 할 일이 없으므로 건너뛰어도 됨
+*/
+static uint64_t next_tick(const timer_wheel_t* w) {
+	uint64_t next = UINT64_MAX;
+
+	if (w->occupied[0]) {
+		int start = (int)((w->now + 1) & (TW_SLOTS - 1));
+		next = w->now + 1 + (uint64_t)first_from(w->occupied[0], start);
+	}
+
+	for (int level = 1; level < TW_LEVELS; ++level) {
+		if (!w->occupied[level])
+			continue;
+
+		/* 현재 칸은 이미 풀렸으므로 다음 칸부터 찾음 (현재 칸에 든 타이머는 한 바퀴 뒤에 풀림) */
+		int shift = TW_BITS * level;
+		uint64_t cur = w->now >> shift;
+		int start = (int)((cur + 1) & (TW_SLOTS - 1));
+		uint64_t at = (cur + 1 + (uint64_t)first_from(w->occupied[level], start)) << shift;
+		if (at < next)
+			next = at;
+	}
+
+	return next;
+}
+
+/* 상위 단의 칸 하나를 풀어 남은 시간에 맞는 하위 단으로 다시 넣는 함수 */
+static void cascade(timer_wheel_t* w, int level, int idx) {
+	wheel_timer_t* t = w->slots[level][idx];
+	w->slots[level][idx] = NULL;
+	w->occupied[level] &= ~(1ull << idx);
+
+	while (t) {
+		wheel_timer_t* next = t->next;
+		w->count--;
+		insert(w, t);
+		t = next;
+	}
+}
+
+int timer_wheel_advance(timer_wheel_t* w, uint64_t now_ms) {
+	uint64_t target = now_ms / TIMER_TICK_MS;
+	int fired = 0;
+
+	while (w->now < target) {
+		uint64_t tick = next_tick(w);
+		if (tick > target) {
+			w->now = target;
+			break;
+		}
+		w->now = tick;
+
+		/* 하위 단이 한 바퀴 돈 경계면 상위 단의 해당 칸을 풀어 내림 */
+		for (int level = 1; level < TW_LEVELS; ++level) {
+			int shift = TW_BITS * level;
+			if (tick & ((1ull << shift) - 1))
+				break;
+			cascade(w, level, (int)((tick >> shift) & (TW_SLOTS - 1)));
+		}
+
+		/* 휠에서 먼저 뺀 뒤 호출하므로 콜백 안에서 다시 등록하거나 다른 타이머를 취소해도 됨 */
+		wheel_timer_t** head = &w->slots[0][tick & (TW_SLOTS - 1)];
+		wheel_timer_t* t;
+		while ((t = *head) != NULL) {
+			unlink_timer(w, t);
+			t->fn(t->arg);
+			fired++;
+		}
+	}
+
+	return fired;
+}
+
+uint64_t timer_wheel_next(const timer_wheel_t* w) {
+	uint64_t tick = next_tick(w);
+	return (tick == UINT64_MAX) ? UINT64_MAX : tick * TIMER_TICK_MS;
+}
@@ -0,0 +1,57 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "common.h"
+
+/*
+* 계층형 타이머 휠
+* TIMER_TICK_MS 단위 tick으로 TW_LEVELS단 x TW_SLOTS칸을 두고, 만료까지 남은 tick 수에 따라 단을 골라 칸의 목록에 넣음
+* 상위 단의 칸은 하위 단이 한 바퀴 돌 때마다 풀어 남은 시간에 맞는 하위 단으로 다시 나눔 (cascade)
+* 타이머는 객체에 내장된 노드라 등록/재등록/취소에 할당이 없고 모두 O(1)이며, 단마다 비어 있지 않은 칸 bitmap으로 다음 만료 시각을 바로 구함
+* 휠 하나는 한 스레드(reactor 또는 worker)만 사용하므로 락이 없음
+*/
+#define TW_BITS 6
+#define TW_SLOTS (1 << TW_BITS)
+#define TW_LEVELS 4
+
+typedef struct timer_wheel {
+	uint64_t now;					// 마지막으로 처리한 tick
+	int count;						// 등록된 타이머 수
+	uint64_t occupied[TW_LEVELS];	// 단별로 비어 있지 않은 칸 bitmap
+	wheel_timer_t* slots[TW_LEVELS][TW_SLOTS];
+} timer_wheel_t;
+
+void timer_wheel_init(timer_wheel_t* w, uint64_t now_ms);
+
+static inline void timer_init(wheel_timer_t* t, void (*fn)(void*), void* arg) {
+	t->next = NULL;
+	t->pprev = NULL;
+	t->fn = fn;
+	t->arg = arg;
+}
+
+static inline bool timer_armed(const wheel_timer_t* t) {
+	return t->pprev != NULL;
+}
+
+/* expire_ms(monotonic_ms 기준) 이후 첫 tick에 만료되도록 등록, 이미 등록된 타이머면 옮김 */
+void timer_arm(timer_wheel_t* w, wheel_timer_t* t, uint64_t expire_ms);
+
+/* 등록을 취소 (등록되지 않은 타이머면 무시) */
+void timer_cancel(timer_wheel_t* w, wheel_timer_t* t);
+
+/* now_ms까지 지난 tick들을 처리하며 만료된 타이머의 콜백을 호출하고, 호출한 수를 반환 */
+int timer_wheel_advance(timer_wheel_t* w, uint64_t now_ms);
+
+/* 다음에 timer_wheel_advance를 불러야 하는 시각(ms), 등록된 타이머가 없으면 UINT64_MAX */
+uint64_t timer_wheel_next(const timer_wheel_t* w);
+
+/* now_ms부터 다음 처리 시각까지 남은 시간 (epoll_wait 등의 timeout 인자, 타이머가 없으면 -1) */
+static inline int timer_wheel_timeout(const timer_wheel_t* w, uint64_t now_ms) {
+	uint64_t next = timer_wheel_next(w);
+	if (next == UINT64_MAX)
+		return -1;
+	return (next > now_ms) ? (int)(next - now_ms) : 0;
+}
+
+#endif
@@ -0,0 +1,194 @@
+#include "uring.h"
+
+#if NET_IO_URING
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params* p) {
+	return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/*
+* io_uring 인스턴스 생성 및 공유 ring 메모리 매핑 함수
+* cq_entries가 0이면 커널 기본값(SQ의 2배)을 사용함
+*/
+int uring_init(uring_t* ring, unsigned entries, unsigned cq_entries, unsigned flags) {
+	struct io_uring_params p;
+
+	memset(ring, 0, sizeof(*ring));
+	memset(&p, 0, sizeof(p));
+	p.flags = flags;
+	if (cq_entries) {
+		p.flags |= IORING_SETUP_CQSIZE;
+		p.cq_entries = cq_entries;
+	}
+
+	ring->fd = sys_io_uring_setup(entries, &p);
+	if (ring->fd < 0)
+		return -1;
+
+	ring->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+	/* SINGLE_MMAP을 지원하면 SQ/CQ ring이 한 영역에 들어 있으므로 한 번만 매핑 */
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_len > ring->sq_len)
+			ring->sq_len = ring->cq_len;
+		ring->cq_len = 0;
+	}
+
+	ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ring->fd, IORING_OFF_SQ_RING);
+	if (ring->sq_ptr == MAP_FAILED) {
+		ring->sq_ptr = NULL;
+		goto fail;
+	}
+
+	if (ring->cq_len) {
+		ring->cq_ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			ring->fd, IORING_OFF_CQ_RING);
+		if (ring->cq_ptr == MAP_FAILED) {
+			ring->cq_ptr = NULL;
+			goto fail;
+		}
+	}
+	else {
+		ring->cq_ptr = ring->sq_ptr;
+	}
+
+	ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ring->fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		ring->sqes = NULL;
+		goto fail;
+	}
+
+	char* sq = ring->sq_ptr;
+	ring->sq_entries = p.sq_entries;
+	ring->sq_mask = *(unsigned*)(sq + p.sq_off.ring_mask);
+	ring->sq_head = (unsigned*)(sq + p.sq_off.head);
+	ring->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+	ring->sq_array = (unsigned*)(sq + p.sq_off.array);
+	ring->sqe_tail = *ring->sq_tail;
+
+	char* cq = ring->cq_ptr;
+	ring->cq_mask = *(unsigned*)(cq + p.cq_off.ring_mask);
+	ring->cq_head = (unsigned*)(cq + p.cq_off.head);
+	ring->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+	ring->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+	return 0;
+
+fail:
+	uring_exit(ring);
+	return -1;
+}
+
+void uring_exit(uring_t* ring) {
+	if (ring->sqes)
+		munmap(ring->sqes, ring->sqes_len);
+	if (ring->cq_ptr && ring->cq_ptr != ring->sq_ptr)
+		munmap(ring->cq_ptr, ring->cq_len);
+	if (ring->sq_ptr)
+		munmap(ring->sq_ptr, ring->sq_len);
+	if (ring->fd >= 0)
+		close(ring->fd);
+
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = -1;
+}
+
+/*
+* 비어 있는 SQE 하나를 확보하는 함수
+* SQ가 가득 차 있으면 쌓인 요청을 먼저 제출해 자리를 만듦
+* 반환된 SQE는 0으로 초기화되어 있고, 다음 uring_submit 때 커널에 공개됨
+*/
+struct io_uring_sqe* uring_get_sqe(uring_t* ring) {
+	while (ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+		if (uring_submit(ring, 0) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			return NULL;
+	}
+
+	unsigned idx = ring->sqe_tail & ring->sq_mask;
+	struct io_uring_sqe* sqe = &ring->sqes[idx];
+	memset(sqe, 0, sizeof(*sqe));
+
+	ring->sq_array[idx] = idx;
+	ring->sqe_tail++;
+	return sqe;
+}
+
+/*
+* 채워 둔 SQE들을 커널에 공개하고 제출하는 함수
+* wait_nr > 0이면 완료 이벤트가 그만큼 쌓일 때까지 대기
+* 시스템 콜 실패 시 -1 (errno 설정)
+*/
+int uring_submit(uring_t* ring, unsigned wait_nr) {
+	__atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+
+	unsigned to_submit = ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+	if (to_submit == 0 && wait_nr == 0)
+		return 0;
+
+	return sys_io_uring_enter(ring->fd, to_submit, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0);
+}
+
+/*
+* provided buffer ring 생성 및 등록 함수
+* entries는 2의 거듭제곱이어야 하며, 등록 직후 모든 버퍼를 ring에 채워 둠
+*/
+int uring_buf_ring_init(uring_t* ring, uring_buf_ring_t* br, uint16_t bgid, unsigned entries, unsigned buf_size) {
+	memset(br, 0, sizeof(*br));
+	br->entries = entries;
+	br->mask = entries - 1;
+	br->buf_size = buf_size;
+	br->bgid = bgid;
+
+	br->br = mmap(NULL, entries * sizeof(struct io_uring_buf), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (br->br == MAP_FAILED) {
+		br->br = NULL;
+		return -1;
+	}
+
+	br->base = malloc((size_t)entries * buf_size);
+	if (!br->base) {
+		uring_buf_ring_free(br);
+		return -1;
+	}
+
+	struct io_uring_buf_reg reg;
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uint64_t)(uintptr_t)br->br;
+	reg.ring_entries = entries;
+	reg.bgid = bgid;
+
+	if (sys_io_uring_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+		uring_buf_ring_free(br);
+		return -1;
+	}
+
+	for (unsigned i = 0; i < entries; ++i)
+		uring_buf_recycle(br, (uint16_t)i);
+
+	return 0;
+}
+
+/* 버퍼 메모리 해제 (ring 등록은 io_uring 인스턴스를 닫을 때 함께 해제됨) */
+void uring_buf_ring_free(uring_buf_ring_t* br) {
+	if (br->br)
+		munmap(br->br, br->entries * sizeof(struct io_uring_buf));
+	free(br->base);
+	memset(br, 0, sizeof(*br));
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef URING_H
+#define URING_H
+
+#include "common.h"
+
+#if NET_IO_URING
+
+#include <linux/io_uring.h>
+
+/*
+* io_uring 인스턴스 (liburing 없이 시스템 콜과 mmap으로 직접 다룸)
+* SQ/CQ ring과 SQE 배열은 커널과 공유하는 메모리이며, head/tail은 acquire/release로 주고받음
+* 한 인스턴스는 한 스레드만 사용함
+*/
+typedef struct uring {
+	int fd;
+
+	// submission queue
+	unsigned sq_entries;
+	unsigned sq_mask;
+	unsigned* sq_head;				// 커널이 소비한 위치
+	unsigned* sq_tail;				// 커널에 공개한 위치
+	unsigned* sq_array;
+	unsigned sqe_tail;				// 채워 넣었지만 아직 공개하지 않은 위치
+	struct io_uring_sqe* sqes;
+
+	// completion queue
+	unsigned cq_mask;
+	unsigned* cq_head;
+	unsigned* cq_tail;
+	struct io_uring_cqe* cqes;
+
+	void* sq_ptr;
+	size_t sq_len;
+	void* cq_ptr;
+	size_t cq_len;
+	size_t sqes_len;
+} uring_t;
+
+/*
+* provided buffer ring
+* recv 요청에 버퍼를 미리 붙이지 않고, 데이터가 도착한 시점에 커널이 이 ring에서 버퍼 하나를 골라 채움
+* 처리가 끝난 버퍼는 uring_buf_recycle로 다시 ring에 돌려줌
+*/
+typedef struct uring_buf_ring {
+	struct io_uring_buf_ring* br;
+	char* base;						// 버퍼 메모리 (buf_size * entries)
+	unsigned entries;
+	unsigned mask;
+	unsigned buf_size;
+	uint16_t bgid;
+	uint16_t tail;
+} uring_buf_ring_t;
+
+int uring_init(uring_t* ring, unsigned entries, unsigned cq_entries, unsigned flags);
+void uring_exit(uring_t* ring);
+
+struct io_uring_sqe* uring_get_sqe(uring_t* ring);
+int uring_submit(uring_t* ring, unsigned wait_nr);
+
+/* 완료된 CQE 하나를 꺼내보는 함수 (없으면 NULL), 처리 후 uring_cqe_seen으로 넘김 */
+static inline struct io_uring_cqe* uring_peek_cqe(uring_t* ring) {
+	unsigned head = *ring->cq_head;
+	if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+		return NULL;
+	return &ring->cqes[head & ring->cq_mask];
+}
+
+static inline void uring_cqe_seen(uring_t* ring) {
+	__atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+int uring_buf_ring_init(uring_t* ring, uring_buf_ring_t* br, uint16_t bgid, unsigned entries, unsigned buf_size);
+void uring_buf_ring_free(uring_buf_ring_t* br);
+
+static inline char* uring_buf_addr(uring_buf_ring_t* br, uint16_t bid) {
+	return br->base + (size_t)bid * br->buf_size;
+}
+
+/* 다 쓴 버퍼를 ring에 돌려주는 함수 */
+static inline void uring_buf_recycle(uring_buf_ring_t* br, uint16_t bid) {
+	struct io_uring_buf* b = &br->br->bufs[br->tail & br->mask];
+	b->addr = (uint64_t)(uintptr_t)uring_buf_addr(br, bid);
+	b->len = br->buf_size;
+	b->bid = bid;
+	br->tail++;
+	__atomic_store_n(&br->br->tail, br->tail, __ATOMIC_RELEASE);
+}
+
+#endif
+
+#endif